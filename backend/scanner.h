@@ -21,6 +21,23 @@ typedef enum {
 } ConnectionStatus;
 
 
+// TCP 内核计数（--tcp-info 开启时由 sock_diag 的 INET_DIAG_INFO 填充）
+typedef struct {
+    uint8_t valid;           // 本轮是否取到 tcp_info
+    uint64_t bytes_acked;    // 已被对端确认的发送字节
+    uint64_t bytes_received;
+    uint32_t segs_out;
+    uint32_t segs_in;
+    uint32_t rtt_us;         // 平滑 RTT（微秒）
+    uint32_t rttvar_us;
+    uint32_t total_retrans;  // 连接生命周期内的重传段数
+    uint32_t snd_cwnd;       // 拥塞窗口（段）
+    uint8_t ca_state;        // TCP_CA_Open / Disorder / CWR / Recovery / Loss
+    double tx_rate;          // 字节/秒，由 conn_track 与上一轮同一连接比较得出
+    double rx_rate;
+    double retrans_rate;     // 重传段/秒（同上）
+} TcpDiag;
+
 typedef struct {
     char protocol[16];   // TCP or UDP
     char local_addr[128];
@@ -31,39 +48,134 @@ typedef struct {
     char process[256];
     char exe_path[512];  // 进程执行路径（用于审计）
     char risk_reason[64]; // 风险原因描述（用于 UI）
+    uint64_t inode;      // 套接字 inode（不可用时为 0），与五元组共同标识一条连接
+    int64_t first_seen;  // 首次观测到的时间（Unix 秒，由 conn_track 维护，未跟踪时为 0）
+    int64_t state_since; // 进入当前状态的时间（同上）
+    uint32_t tx_queue;   // 发送队列字节数
+    uint32_t rx_queue;   // 接收队列字节数；LISTEN 套接字为当前全连接（accept）队列长度
+    uint32_t backlog;    // LISTEN 套接字的 backlog 上限（经 sock_diag 取得，未知为 0）
+    int32_t group_count; // 折叠后本行代表的连接数（未折叠为 1），其余字段取自首个成员，收发队列为成员之和
+    uint16_t group_port_min; // group_count > 1 时成员的本地端口范围
+    uint16_t group_port_max;
+    TcpDiag tcp;
 } ConnectionInfo;
 
+#define STATS_TOP_PROCS 8    // calculate_stats 给出的活跃进程排名条数
+
+typedef struct {
+    char name[32];
+    int count;           // 已建立连接数
+} StatsProc;
+
 // 统计数据结构
 typedef struct {
     int total;
     int established;
     int listening;
     int suspicious;
+    int stuck;           // 在 SYN_SENT / CLOSE_WAIT 等状态滞留超过阈值的连接数
+    int port_at_risk;    // 临时端口占用率达到告警阈值的目标数
+    int port_util_max;   // 各目标中最高的临时端口占用率（百分比）
+    int leaking;         // 套接字或 CLOSE_WAIT 持续增长的进程数
     char top_process[256];
     int top_process_count;
+    StatsProc top_procs[STATS_TOP_PROCS];  // 已建立连接最多的进程，降序（首项即 top_process）
+    int top_proc_count;
 } ConnectionStats;
 
+// 按进程聚合的吞吐（Top Talkers），process 指向 conns 内的字符串
+typedef struct {
+    const char *process;
+    int32_t pid;
+    int conns;
+    double tx_rate;
+    double rx_rate;
+} ProcessRate;
+
+// 按远端 /24 前缀聚合的 TCP 健康度（仅统计带 tcp_info 的 ESTABLISHED 连接）
+typedef struct {
+    uint32_t prefix;         // 主机字节序，低 8 位为 0
+    int conns;
+    double avg_rtt_us;
+    uint32_t max_rtt_us;
+    double retrans_rate;     // 前缀内各连接重传速率之和
+    uint32_t total_retrans;
+} PrefixHealth;
+
 // 排序模式
 typedef enum {
     SORT_NONE,
     SORT_BY_PID,
     SORT_BY_PROCESS,
-    SORT_BY_REMOTE
+    SORT_BY_REMOTE,
+    SORT_BY_AGE
 } SortMode;
 
+#define SORT_MODE_COUNT (SORT_BY_AGE + 1)
+
+// 状态数量（用于按状态计数的数组）
+#define CONN_STATUS_COUNT (CONN_STATUS_UNKNOWN + 1)
+
 // 逻辑层接口
+const char* conn_status_name(ConnectionStatus status);
+ConnectionStatus conn_status_from_name(const char *name);
 int is_suspicious(const ConnectionInfo *conn);
 void calculate_stats(const ConnectionInfo *conns, int count, ConnectionStats *stats);
 int is_internal(const char *addr);
+int parse_ipv4_endpoint(const char *addr, uint32_t *ip, uint16_t *port);
 int is_external_connection(const ConnectionInfo *conn);
 void sort_connections(ConnectionInfo *conns, int count, SortMode mode);
+// 聚合用的临时表从 scratch 分配（调用方的帧区域），不单独释放
+struct Arena;
+int top_process_rates(const ConnectionInfo *conns, int count, ProcessRate *out, int max, struct Arena *scratch);
+const char* tcp_ca_state_name(uint8_t ca_state);
+int top_prefix_health(const ConnectionInfo *conns, int count, PrefixHealth *out, int max, struct Arena *scratch);
 
-// HTML 导出接口
+// 行折叠：把 (进程, 远端地址, 状态) 相同的连接合并为一行，界面的排序、过滤与渲染开销随折叠比下降
+// LISTEN 与未连接的 UDP（远端端口为 0）不参与；被展开的分组保持逐行明细
+void conn_collapse_enable(int on);
+int conn_collapse_enabled(void);
+// 启用时原地折叠 conns（合并行的 group_count 与端口范围随之填写），返回折叠后的行数；未启用时原样返回 count
+// 扫描侧的监测、记录与发布都在逐行数据上完成后才调用，只有界面看到折叠行
+int conn_collapse_rows(ConnectionInfo *conns, int count);
+// 展开 / 收起分组（按该行的进程、远端地址与状态），返回 1 表示已展开；下一轮扫描生效
+int conn_collapse_toggle_expand(const ConnectionInfo *row);
+int conn_collapse_is_expanded(const ConnectionInfo *row);
+
+// 导出接口（"-" 表示写到标准输出，HTML 除外）
 int export_html_report(const char *filename, ConnectionInfo *conns, int count);
+int export_json_report(const char *filename, ConnectionInfo *conns, int count);
+int export_csv_report(const char *filename, ConnectionInfo *conns, int count);
+int export_bin_report(const char *filename, ConnectionInfo *conns, int count);
+// 按 format（html|json|csv|bin）分派；format 为 NULL 时按扩展名推断
+int export_report(const char *filename, const char *format, ConnectionInfo *conns, int count);
 
-// 获取当前所有连接
+// 获取当前所有连接（Linux 下数组来自扫描区域，在下一次调用前有效）
 ConnectionInfo* scanner_get_connections(int *count);
 
+// 设置扫描过滤（state / port / cidr，pid 不参与），之后只采集并解析匹配的套接字；NULL 清除
+// Linux 下经 sock_diag 的状态掩码与字节码在内核侧过滤，不可用时退回用户态逐行过滤
+struct ConnFilter;
+void scanner_set_filter(const struct ConnFilter *f);
+
+// PID 观察模式：只采集这些进程（with_children 时含其子孙进程）持有的套接字，count 为 0 恢复全量扫描
+// Linux 下只读取这些进程的 fd 表与所在网络命名空间的套接字表，不再遍历整个 /proc
+void scanner_set_pids(const int32_t *pids, int count, int with_children);
+
+// procfs 根目录（默认 /proc；容器内可指向宿主机挂载点，基准测试指向合成目录），过长时返回 -1
+// 不是本机 /proc 时不再经 sock_diag 采集，全部读取该目录下的套接字表
+int scanner_set_proc_root(const char *root);
+const char *scanner_proc_root(void);
+// 是否为本机 /proc：否则按 inode 经 sock_diag 补充的字段（tcp_info、backlog）会配到无关的套接字上，不应补充
+int scanner_proc_root_is_live(void);
+
+// 最近一轮扫描中各持有套接字进程的 fd 总数（Linux 建立 inode 索引遍历 fd 表时顺带计数，不额外读取 /proc）
+typedef void (*ProcessFdVisit)(int32_t pid, int fd_count, void *ctx);
+void scanner_visit_fd_counts(ProcessFdVisit visit, void *ctx);
+
+// 扫描器自行发出的 open / close / readlink / stat 调用累计数（读类调用由内核另行计数），供分阶段计时统计
+uint64_t scanner_syscall_count(void);
+
 // 释放连接信息占用的内存
 void scanner_free_connections(ConnectionInfo *conns, int count);
 
@@ -4,7 +4,13 @@
 #include <stdint.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
 #include "backend/scanner.h"
+#include "backend/sock_diag.h"
+#include "lib/arena.h"
+#include "lib/conn_filter.h"
+#include "lib/phase_timer.h"
 
 // 将十六进制字符串转为 IP 地址字符串
 static void hex_to_ip(const char *hex, char *ip) {
@@ -54,75 +60,348 @@ static const char* status_enum_to_str(ConnectionStatus status) {
     }
 }
 
-// 获取进程名和执行路径
-static void get_process_name(unsigned long target_inode, int32_t *pid, char *process, char *exe_path) {
-    if (exe_path) strcpy(exe_path, "N/A");
-    DIR *dir = opendir("/proc");
-    if (!dir) return;
+// procfs 挂载点（容器内可指向宿主机的 /host/proc，基准测试指向合成的 fixture 目录）
+#define PROC_PATH_MAX 512
+static char proc_root[256] = "/proc";
+static int proc_root_live = 1;   // 是否为本机 /proc：否则 sock_diag 查到的是另一份套接字表，不能混用
 
-    struct dirent *entry;
-    while ((entry = readdir(dir))) {
-        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+int scanner_set_proc_root(const char *root) {
+    size_t len = strlen(root);
+    while (len > 1 && root[len - 1] == '/') len--;
+    if (len == 0 || len >= sizeof(proc_root)) return -1;
+    memcpy(proc_root, root, len);
+    proc_root[len] = '\0';
+    proc_root_live = strcmp(proc_root, "/proc") == 0;
+    return 0;
+}
+
+const char *scanner_proc_root(void) {
+    return proc_root;
+}
+
+int scanner_proc_root_is_live(void) {
+    return proc_root_live;
+}
+
+// 本模块发出的 open / close / readlink / stat 计数（fgets、readdir 背后的读调用由内核在 /proc/self/io 计数）
+static uint64_t syscall_count = 0;
+
+uint64_t scanner_syscall_count(void) {
+    return syscall_count;
+}
+
+// inode -> 所属进程的开放寻址索引（跨轮复用）
+// 每轮只遍历一次相关进程的 fd 表建立，解析时按 inode 直接查表，避免逐行重新遍历整个 /proc
+typedef struct {
+    uint64_t inode;      // 0 表示空槽
+    int owner;           // owners[] 下标
+} InodeSlot;
+
+typedef struct {
+    int32_t pid;
+    int fd_count;        // 该进程的 fd 总数（含非套接字）
+    int resolved;        // comm / exe 是否已读取（首次命中时才读）
+    char comm[256];
+    char exe[512];
+} SocketOwner;
+
+static InodeSlot *inode_slots = NULL;
+static size_t inode_slot_cap = 0;
+static size_t inode_slot_used = 0;
+static SocketOwner *owners = NULL;
+static int owner_count = 0;
+static int owner_cap = 0;
+
+// 过滤扫描先采集匹配行，再把这些行的 inode 以 owner -1（待认领）登记进索引；
+// 此时 index_pid 只认领待认领的 inode，全部认领后即停止遍历 fd 表
+static int index_claim_mode = 0;
+static size_t index_unclaimed = 0;
+
+static size_t inode_hash(uint64_t inode) {
+    return (size_t)((inode * 0x9E3779B97F4A7C15ull) >> 32) & (inode_slot_cap - 1);
+}
+
+static void index_reset(void) {
+    if (inode_slots) memset(inode_slots, 0, sizeof(InodeSlot) * inode_slot_cap);
+    inode_slot_used = 0;
+    owner_count = 0;
+}
+
+// 插入 inode（已存在则保留先登记的进程，与原先按 /proc 顺序取第一个匹配一致）；内存不足返回 -1
+static int index_insert(uint64_t inode, int owner) {
+    if ((inode_slot_used + 1) * 2 > inode_slot_cap) {
+        size_t new_cap = inode_slot_cap ? inode_slot_cap * 2 : 4096;
+        InodeSlot *ns = calloc(new_cap, sizeof(InodeSlot));
+        if (!ns) return -1;
+        InodeSlot *old = inode_slots;
+        size_t old_cap = inode_slot_cap;
+        inode_slots = ns;
+        inode_slot_cap = new_cap;
+        for (size_t i = 0; i < old_cap; i++) {
+            if (old[i].inode == 0) continue;
+            size_t pos = inode_hash(old[i].inode);
+            while (inode_slots[pos].inode != 0) pos = (pos + 1) & (inode_slot_cap - 1);
+            inode_slots[pos] = old[i];
+        }
+        free(old);
+    }
+    size_t pos = inode_hash(inode);
+    while (inode_slots[pos].inode != 0) {
+        if (inode_slots[pos].inode == inode) return 0;
+        pos = (pos + 1) & (inode_slot_cap - 1);
+    }
+    inode_slots[pos].inode = inode;
+    inode_slots[pos].owner = owner;
+    inode_slot_used++;
+    return 0;
+}
+
+static InodeSlot *index_find(uint64_t inode) {
+    if (inode == 0 || inode_slot_cap == 0) return NULL;
+    size_t pos = inode_hash(inode);
+    while (inode_slots[pos].inode != 0) {
+        if (inode_slots[pos].inode == inode) return &inode_slots[pos];
+        pos = (pos + 1) & (inode_slot_cap - 1);
+    }
+    return NULL;
+}
+
+static int index_lookup(uint64_t inode) {
+    InodeSlot *slot = index_find(inode);
+    return slot ? slot->owner : -1;
+}
+
+// 登记一个进程持有的全部套接字 inode；进程至少持有一个套接字时才占用 owners[] 槽位
+static void index_pid(int32_t pid) {
+    char fd_path[PROC_PATH_MAX];
+    snprintf(fd_path, sizeof(fd_path), "%s/%d/fd", proc_root, pid);
+    DIR *fd_dir = opendir(fd_path);
+    syscall_count++;
+    if (!fd_dir) return;
 
-        // 使用更大的缓冲区避免截断警告
-        char fd_path[512];
-        snprintf(fd_path, sizeof(fd_path), "/proc/%s/fd", entry->d_name);
-        DIR *fd_dir = opendir(fd_path);
-        if (!fd_dir) continue;
-
-        struct dirent *fd_entry;
-        int found = 0;
-        while ((fd_entry = readdir(fd_dir))) {
-            // 使用更大的缓冲区避免截断警告
-            char link_path[1024], target[1024];
-            snprintf(link_path, sizeof(link_path), "%s/%s", fd_path, fd_entry->d_name);
-            ssize_t len = readlink(link_path, target, sizeof(target) - 1);
-            if (len != -1) {
-                target[len] = '\0';
-                unsigned long inode;
-                if (sscanf(target, "socket:[%lu]", &inode) == 1) {
-                    if (inode == target_inode) {
-                        *pid = atoi(entry->d_name);
-                        char comm_path[512];
-                        snprintf(comm_path, sizeof(comm_path), "/proc/%s/comm", entry->d_name);
-                        FILE *comm_fp = fopen(comm_path, "r");
-                        if (comm_fp) {
-                            // 使用结构体定义的大小，避免硬编码
-                            char temp_buf[256];
-                                // 安全复制到目标缓冲区
-                                if (fgets(temp_buf, sizeof(temp_buf), comm_fp)) {
-                                    size_t l = strlen(temp_buf);
-                                    if (l > 0 && temp_buf[l-1] == '\n') temp_buf[l-1] = '\0';
-                                    strncpy(process, temp_buf, 255);
-                                    process[255] = '\0';
-                                }
-                            fclose(comm_fp);
-                        }
-                        
-                        // [NEW] 获取进程执行路径
-                        char exe_link[512];
-                        snprintf(exe_link, sizeof(exe_link), "/proc/%s/exe", entry->d_name);
-                        ssize_t exe_len = readlink(exe_link, exe_path, 511);
-                        if (exe_len != -1) {
-                            exe_path[exe_len] = '\0';
-                        } else {
-                            strcpy(exe_path, "Access Denied");
-                        }
-                        
-                        found = 1;
-                        break;
-                    }
-                }
+    int owner = -1;
+    int fds = 0;
+    struct dirent *fd_entry;
+    while ((fd_entry = readdir(fd_dir))) {
+        if (fd_entry->d_name[0] < '0' || fd_entry->d_name[0] > '9') continue;
+        fds++;
+        // 认领完毕后只继续计数（fd 总数供泄漏检测使用，须是完整值），不再 readlink
+        if (index_claim_mode && index_unclaimed == 0) continue;
+        char link_path[PROC_PATH_MAX + sizeof(fd_entry->d_name) + 1], target[64];
+        snprintf(link_path, sizeof(link_path), "%s/%s", fd_path, fd_entry->d_name);
+        ssize_t len = readlink(link_path, target, sizeof(target) - 1);
+        syscall_count++;
+        if (len < 9 || memcmp(target, "socket:[", 8) != 0) continue;
+        target[len] = '\0';
+        uint64_t inode = strtoull(target + 8, NULL, 10);
+        if (inode == 0) continue;
+        InodeSlot *slot = NULL;
+        if (index_claim_mode) {
+            slot = index_find(inode);
+            if (!slot || slot->owner >= 0) continue;
+        }
+
+        if (owner < 0) {
+            if (owner_count == owner_cap) {
+                int new_cap = owner_cap ? owner_cap * 2 : 64;
+                SocketOwner *tmp = realloc(owners, sizeof(SocketOwner) * new_cap);
+                if (!tmp) break;
+                owners = tmp;
+                owner_cap = new_cap;
             }
+            owner = owner_count++;
+            owners[owner].pid = pid;
+            owners[owner].resolved = 0;
         }
-        closedir(fd_dir);
-        if (found) break;
+        if (slot) {
+            slot->owner = owner;
+            index_unclaimed--;
+        } else if (index_insert(inode, owner) != 0) break;
     }
-    closedir(dir);
+    closedir(fd_dir);
+    syscall_count++;
+    if (owner >= 0) owners[owner].fd_count = fds;
+}
+
+void scanner_visit_fd_counts(ProcessFdVisit visit, void *ctx) {
+    for (int i = 0; i < owner_count; i++) visit(owners[i].pid, owners[i].fd_count, ctx);
+}
+
+// 获取进程名和执行路径（每个进程每轮只读一次）
+static const SocketOwner *resolve_owner(int owner) {
+    SocketOwner *o = &owners[owner];
+    if (o->resolved) return o;
+    o->resolved = 1;
+    strcpy(o->comm, "N/A");
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/comm", proc_root, o->pid);
+    FILE *comm_fp = fopen(path, "r");
+    syscall_count++;
+    if (comm_fp) {
+        if (fgets(o->comm, sizeof(o->comm), comm_fp)) {
+            size_t l = strlen(o->comm);
+            if (l > 0 && o->comm[l-1] == '\n') o->comm[l-1] = '\0';
+        }
+        fclose(comm_fp);
+        syscall_count++;
+    }
+
+    snprintf(path, sizeof(path), "%s/%d/exe", proc_root, o->pid);
+    ssize_t exe_len = readlink(path, o->exe, sizeof(o->exe) - 1);
+    syscall_count++;
+    if (exe_len != -1) o->exe[exe_len] = '\0';
+    else strcpy(o->exe, "Access Denied");
+    return o;
+}
+
+// PID 观察模式（-p）：只读取这些进程（及可选的子孙进程）的 fd 表和所在网络命名空间的套接字表
+static int32_t *watch_pids = NULL;
+static int watch_pid_count = 0;
+static int watch_children = 0;
+
+// 本轮实际观察的进程（含展开的子孙进程），跨轮复用
+static int32_t *scan_pids = NULL;
+static int scan_pid_count = 0;
+static int scan_pid_cap = 0;
+
+void scanner_set_pids(const int32_t *pids, int count, int with_children) {
+    free(watch_pids);
+    watch_pids = NULL;
+    watch_pid_count = 0;
+    watch_children = with_children;
+    if (count <= 0) return;
+    watch_pids = malloc(sizeof(int32_t) * count);
+    if (!watch_pids) return;
+    memcpy(watch_pids, pids, sizeof(int32_t) * count);
+    watch_pid_count = count;
+}
+
+static void add_scan_pid(int32_t pid) {
+    for (int i = 0; i < scan_pid_count; i++) if (scan_pids[i] == pid) return;
+    if (scan_pid_count == scan_pid_cap) {
+        int new_cap = scan_pid_cap ? scan_pid_cap * 2 : 16;
+        int32_t *tmp = realloc(scan_pids, sizeof(int32_t) * new_cap);
+        if (!tmp) return;
+        scan_pids = tmp;
+        scan_pid_cap = new_cap;
+    }
+    scan_pids[scan_pid_count++] = pid;
+}
+
+// 经 /proc/<pid>/task/<tid>/children 展开子进程（只触及该进程树，不遍历整个 /proc）
+static void add_children(int32_t pid) {
+    char task_path[PROC_PATH_MAX];
+    snprintf(task_path, sizeof(task_path), "%s/%d/task", proc_root, pid);
+    DIR *task_dir = opendir(task_path);
+    syscall_count++;
+    if (!task_dir) return;
+    struct dirent *t;
+    while ((t = readdir(task_dir))) {
+        if (t->d_name[0] < '0' || t->d_name[0] > '9') continue;
+        char children_path[PROC_PATH_MAX + sizeof(t->d_name) + 16];
+        snprintf(children_path, sizeof(children_path), "%s/%s/children", task_path, t->d_name);
+        FILE *fp = fopen(children_path, "r");
+        syscall_count++;
+        if (!fp) continue;
+        int child;
+        while (fscanf(fp, "%d", &child) == 1) add_scan_pid(child);
+        fclose(fp);
+        syscall_count++;
+    }
+    closedir(task_dir);
+    syscall_count++;
+}
+
+static void collect_scan_pids(void) {
+    scan_pid_count = 0;
+    for (int i = 0; i < watch_pid_count; i++) add_scan_pid(watch_pids[i]);
+    // 广度优先：新加入的子进程排在末尾，继续展开它们的子进程
+    for (int i = 0; watch_children && i < scan_pid_count; i++) add_children(scan_pids[i]);
+}
+
+// 扫描过滤（--state / --port / --cidr），pid 固定为不限
+static ConnFilter scan_filter = { .pid = -1, .port = -1 };
+static int scan_filter_active = 0;
+
+void scanner_set_filter(const struct ConnFilter *f) {
+    if (f) scan_filter = *f;
+    else conn_filter_init(&scan_filter);
+    scan_filter.pid = -1;
+    scan_filter_active = !conn_filter_is_empty(&scan_filter);
+    sock_diag_set_filter(scan_filter_active ? &scan_filter : NULL);
+}
+
+// 扫描区域：连接数组每轮从这里分配，下一轮开始时整体复位；主块按近期最大行数保留（连接数尖峰过后
+// ARENA_SHRINK_ROUNDS 轮缩回），稳态下数组在主块内原地倍增，不再 malloc / realloc
+static Arena scan_arena = { .shrink_after = ARENA_SHRINK_ROUNDS };
+
+// 在数组末尾预留一行；扩容失败返回 NULL
+static ConnectionInfo *reserve_row(ConnectionInfo **conns, int *count, int *capacity) {
+    if (*count >= *capacity) {
+        size_t old_size = sizeof(ConnectionInfo) * (size_t)(*capacity);
+        ConnectionInfo *temp = arena_grow(&scan_arena, *conns, old_size, old_size * 2);
+        if (!temp) return NULL; // 内存分配失败
+        *conns = temp;
+        *capacity *= 2;
+    }
+    return &((*conns)[*count]);
 }
 
-static int parse_proc_file(const char *filename, const char *proto, ConnectionInfo **conns, int *count, int *capacity) {
+// 填充地址与进程以外的字段
+static void fill_row(ConnectionInfo *c, const char *proto, int st, uint32_t tx_queue, uint32_t rx_queue, uint64_t inode) {
+    snprintf(c->protocol, sizeof(c->protocol), "%s", proto);
+
+    // 设置状态枚举和字符串
+    c->status_enum = get_status_enum(proto, st);
+    snprintf(c->status, sizeof(c->status), "%s", status_enum_to_str(c->status_enum));
+
+    c->pid = -1;
+    strcpy(c->process, "N/A");
+    strcpy(c->exe_path, "N/A");
+    strcpy(c->risk_reason, "");
+    c->inode = inode;
+    c->tx_queue = tx_queue;
+    c->rx_queue = rx_queue;
+    c->backlog = 0;
+    c->group_count = 1;
+    c->group_port_min = 0;
+    c->group_port_max = 0;
+    c->first_seen = 0;
+    c->state_since = 0;
+    memset(&c->tcp, 0, sizeof(c->tcp));
+}
+
+// 查表填入所属进程
+static void resolve_row(ConnectionInfo *c) {
+    int owner = index_lookup(c->inode);
+    if (owner >= 0) {
+        const SocketOwner *o = resolve_owner(owner);
+        c->pid = o->pid;
+        strcpy(c->process, o->comm);
+        strcpy(c->exe_path, o->exe);
+    }
+}
+
+static int defer_resolve = 0;   // 过滤扫描：索引在采集之后才建立，行先不查表
+
+// 保留刚填好的行 conns[*count]
+static void commit_row(ConnectionInfo *conns, int *count) {
+    if (!defer_resolve) resolve_row(&conns[*count]);
+    (*count)++;
+}
+
+// 用户态过滤（sock_diag 不可用时的退路）
+static int row_matches(const ConnectionInfo *c) {
+    NcmWireRecord r;
+    conn_to_wire(c, &r);
+    return conn_filter_match(&scan_filter, &r);
+}
+
+// owned_only：只保留 inode 出现在索引中的行（PID 观察模式）
+static int parse_proc_file(const char *filename, const char *proto, int owned_only, ConnectionInfo **conns, int *count, int *capacity) {
     FILE *fp = fopen(filename, "r");
+    syscall_count += 2; // open + close
     if (!fp) return 0;
 
     char line[256];
@@ -133,39 +412,25 @@ static int parse_proc_file(const char *filename, const char *proto, ConnectionIn
     }
 
     while (fgets(line, sizeof(line), fp)) {
-        if (*count >= *capacity) {
-            *capacity *= 2;
-            // 修复内存泄漏：使用临时指针检查 realloc 结果
-            ConnectionInfo *temp = realloc(*conns, sizeof(ConnectionInfo) * (*capacity));
-            if (!temp) {
-                fclose(fp);
-                return 0; // 内存分配失败
-            }
-            *conns = temp;
+        ConnectionInfo *c = reserve_row(conns, count, capacity);
+        if (!c) {
+            fclose(fp);
+            return 0; // 内存分配失败
         }
 
         char local_addr_hex[64], remote_addr_hex[64];
         int st;
+        unsigned int tx_queue, rx_queue;
         unsigned long inode;
 
-        if (sscanf(line, "%*d: %63s %63s %X %*X:%*X %*X:%*X %*X %*d %*d %lu",
-                   local_addr_hex, remote_addr_hex, &st, &inode) == 4) {
-            
-            ConnectionInfo *c = &((*conns)[*count]);
-            strncpy(c->protocol, proto, sizeof(c->protocol));
+        if (sscanf(line, "%*d: %63s %63s %X %X:%X %*X:%*X %*X %*d %*d %lu",
+                   local_addr_hex, remote_addr_hex, &st, &tx_queue, &rx_queue, &inode) == 6) {
+            if (owned_only && index_lookup(inode) < 0) continue;
             hex_to_ip(local_addr_hex, c->local_addr);
             hex_to_ip(remote_addr_hex, c->remote_addr);
-            
-            // 设置状态枚举和字符串
-            c->status_enum = get_status_enum(proto, st);
-            strncpy(c->status, status_enum_to_str(c->status_enum), sizeof(c->status));
-            
-            c->pid = -1;
-            strcpy(c->process, "N/A");
-            strcpy(c->exe_path, "N/A");
-            strcpy(c->risk_reason, "");
-            get_process_name(inode, &c->pid, c->process, c->exe_path);
-            (*count)++;
+            fill_row(c, proto, st, tx_queue, rx_queue, inode);
+            if (scan_filter_active && !row_matches(c)) continue;
+            commit_row(*conns, count);
         }
     }
 
@@ -173,20 +438,157 @@ static int parse_proc_file(const char *filename, const char *proto, ConnectionIn
     return 1;
 }
 
+typedef struct {
+    const char *proto;
+    ConnectionInfo **conns;
+    int *count;
+    int *capacity;
+    int failed;
+} DiagScanCtx;
+
+static void format_endpoint(uint32_t ip_be, uint16_t port, char *out) {
+    const unsigned char *o = (const unsigned char *)&ip_be;
+    sprintf(out, "%u.%u.%u.%u:%u", o[0], o[1], o[2], o[3], port);
+}
+
+static void visit_diag_socket(const DiagSocket *s, void *ctx) {
+    DiagScanCtx *dc = ctx;
+    if (dc->failed) return;
+    ConnectionInfo *c = reserve_row(dc->conns, dc->count, dc->capacity);
+    if (!c) {
+        dc->failed = 1;
+        return;
+    }
+    format_endpoint(s->src, s->sport, c->local_addr);
+    format_endpoint(s->dst, s->dport, c->remote_addr);
+    // 与 /proc/net/tcp 一致：LISTEN 的接收队列为 accept 队列长度，发送队列为 0
+    if (s->state == 0x0A && strcmp(dc->proto, "TCP") == 0) {
+        fill_row(c, dc->proto, s->state, 0, s->rqueue, s->inode);
+        c->backlog = s->wqueue;
+    } else {
+        fill_row(c, dc->proto, s->state, s->wqueue, s->rqueue, s->inode);
+    }
+    // 内核状态比 /proc/net/tcp 多出 NEW_SYN_RECV（半连接），经 sock_diag_status 映射后与回退路径一致显示为 SYN_RECV
+    if (strcmp(dc->proto, "TCP") == 0) {
+        c->status_enum = sock_diag_status(s->state);
+        snprintf(c->status, sizeof(c->status), "%s", status_enum_to_str(c->status_enum));
+    }
+    commit_row(*dc->conns, dc->count);
+}
+
+// 采集单个协议：有过滤时先走 sock_diag（内核侧过滤），失败则回退到 /proc 逐行过滤
+static void scan_protocol(const char *proc_file, const char *proto, uint8_t ipproto, ConnectionInfo **conns, int *count, int *capacity) {
+    if (scan_filter_active && proc_root_live) {
+        int start = *count;
+        DiagScanCtx dc = { proto, conns, count, capacity, 0 };
+        if (sock_diag_scan(ipproto, visit_diag_socket, &dc) >= 0 && !dc.failed) return;
+        *count = start;
+    }
+    parse_proc_file(proc_file, proto, 0, conns, count, capacity);
+}
+
+// PID 观察模式：每个网络命名空间只读一次其套接字表（经该命名空间内任一被观察进程的 /proc/<pid>/net）
+static void scan_watched(int want_tcp, int want_udp, ConnectionInfo **conns, int *count, int *capacity) {
+    ino_t seen_ns[16];
+    int seen = 0;
+    for (int i = 0; i < scan_pid_count; i++) {
+        char path[PROC_PATH_MAX];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%d/ns/net", proc_root, scan_pids[i]);
+        syscall_count++;
+        if (stat(path, &st) != 0) continue;
+        int dup = 0;
+        for (int k = 0; k < seen; k++) if (seen_ns[k] == st.st_ino) dup = 1;
+        if (dup) continue;
+        if (seen < (int)(sizeof(seen_ns) / sizeof(seen_ns[0]))) seen_ns[seen++] = st.st_ino;
+
+        if (want_tcp) {
+            snprintf(path, sizeof(path), "%s/%d/net/tcp", proc_root, scan_pids[i]);
+            parse_proc_file(path, "TCP", 1, conns, count, capacity);
+        }
+        if (want_udp) {
+            snprintf(path, sizeof(path), "%s/%d/net/udp", proc_root, scan_pids[i]);
+            parse_proc_file(path, "UDP", 1, conns, count, capacity);
+        }
+    }
+}
+
+// 全量模式：遍历所有进程的 fd 表（认领模式下全部认领后提前结束）
+static void index_all_pids(void) {
+    DIR *dir = opendir(proc_root);
+    syscall_count++;
+    if (!dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        index_pid((int32_t)atoi(entry->d_name));
+        if (index_claim_mode && index_unclaimed == 0) break;
+    }
+    closedir(dir);
+    syscall_count++;
+}
+
+// 全量模式：读取本机（或 proc_root 下）的 TCP / UDP 套接字表
+static void scan_tables(int want_tcp, int want_udp, ConnectionInfo **conns, int *count, int *capacity) {
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/net/tcp", proc_root);
+    if (want_tcp) scan_protocol(path, "TCP", IPPROTO_TCP, conns, count, capacity);
+    snprintf(path, sizeof(path), "%s/net/udp", proc_root);
+    if (want_udp) scan_protocol(path, "UDP", IPPROTO_UDP, conns, count, capacity);
+}
+
 ConnectionInfo* scanner_get_connections(int *count) {
     int capacity = 128;
     int n = 0;
-    ConnectionInfo *conns = malloc(sizeof(ConnectionInfo) * capacity);
+    arena_reset(&scan_arena);
+    ConnectionInfo *conns = arena_alloc(&scan_arena, sizeof(ConnectionInfo) * capacity);
     if (!conns) return NULL;
 
-    parse_proc_file("/proc/net/tcp", "TCP", &conns, &n, &capacity);
-    parse_proc_file("/proc/net/udp", "UDP", &conns, &n, &capacity);
+    // UDP 行的状态为 NONE：状态过滤只含 TCP 状态时整个协议都不用采集，反之亦然
+    uint32_t udp_bit = 1u << CONN_STATUS_NONE;
+    int want_tcp = !scan_filter.state_mask || (scan_filter.state_mask & ~udp_bit);
+    int want_udp = !scan_filter.state_mask || (scan_filter.state_mask & udp_bit);
+
+    // 先建立 inode -> 进程索引（全量模式遍历所有进程，PID 观察模式只遍历被观察的进程树），
+    // 解析各行时即可查表得到进程
+    uint64_t t = phase_now_ns();
+    index_reset();
+    if (watch_pid_count > 0) {
+        collect_scan_pids();
+        for (int i = 0; i < scan_pid_count; i++) index_pid(scan_pids[i]);
+        t = phase_end(PHASE_INODE_INDEX, t);
+        scan_watched(want_tcp, want_udp, &conns, &n, &capacity);
+        phase_end(PHASE_NET_TABLE, t);
+    } else if (scan_filter_active) {
+        // 有过滤时匹配行通常只占一小部分：先采集，再只为这些行的 inode 遍历 fd 表，全部认领即停
+        defer_resolve = 1;
+        scan_tables(want_tcp, want_udp, &conns, &n, &capacity);
+        defer_resolve = 0;
+        t = phase_end(PHASE_NET_TABLE, t);
+        for (int i = 0; i < n; i++) {
+            if (conns[i].inode != 0 && index_insert(conns[i].inode, -1) != 0) break;
+        }
+        index_unclaimed = inode_slot_used;
+        if (index_unclaimed > 0) {
+            index_claim_mode = 1;
+            index_all_pids();
+            index_claim_mode = 0;
+        }
+        for (int i = 0; i < n; i++) resolve_row(&conns[i]);
+        phase_end(PHASE_INODE_INDEX, t);
+    } else {
+        index_all_pids();
+        t = phase_end(PHASE_INODE_INDEX, t);
+        scan_tables(want_tcp, want_udp, &conns, &n, &capacity);
+        phase_end(PHASE_NET_TABLE, t);
+    }
 
     *count = n;
     return conns;
 }
 
+// 数组属于扫描区域，由下一次 scanner_get_connections 复位，这里不逐个释放
 void scanner_free_connections(ConnectionInfo *conns, int count) {
-    (void)count; // 明确标记未使用参数
-    if (conns) free(conns);
+    (void)conns;
+    (void)count;
 }
@@ -1,11 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <iphlpapi.h>
 #include <psapi.h>
+#include <tlhelp32.h>
 
 #pragma comment(lib, "iphlpapi.lib")
 #pragma comment(lib, "ws2_32.lib")
@@ -13,6 +15,7 @@
 #endif
 
 #include "backend/scanner.h"
+#include "lib/conn_filter.h"
 
 #ifdef _WIN32
 
@@ -74,11 +77,73 @@ static const char* status_enum_to_str(ConnectionStatus status) {
     }
 }
 
+// 扫描过滤：Windows 没有内核侧过滤接口，在解析进程名之前逐行过滤（pid 不参与）
+static ConnFilter scan_filter = { .pid = -1, .port = -1 };
+static int scan_filter_active = 0;
+
+void scanner_set_filter(const struct ConnFilter *f) {
+    if (f) scan_filter = *f;
+    else conn_filter_init(&scan_filter);
+    scan_filter.pid = -1;
+    scan_filter_active = !conn_filter_is_empty(&scan_filter);
+}
+
+static int row_matches(const ConnectionInfo *c) {
+    NcmWireRecord r;
+    conn_to_wire(c, &r);
+    return conn_filter_match(&scan_filter, &r);
+}
+
+// PID 观察模式：表项自带所属 PID，直接按列表过滤；子进程经进程快照按父 PID 展开
+static int32_t watch_pids[256];
+static int watch_pid_count = 0;
+static int watch_children = 0;
+static int32_t scan_pids[1024];
+static int scan_pid_count = 0;
+
+void scanner_set_pids(const int32_t *pids, int count, int with_children) {
+    if (count > (int)(sizeof(watch_pids) / sizeof(watch_pids[0]))) count = (int)(sizeof(watch_pids) / sizeof(watch_pids[0]));
+    memcpy(watch_pids, pids, sizeof(int32_t) * (count > 0 ? count : 0));
+    watch_pid_count = count > 0 ? count : 0;
+    watch_children = with_children;
+}
+
+static int scan_pid_watched(int32_t pid) {
+    for (int i = 0; i < scan_pid_count; i++) if (scan_pids[i] == pid) return 1;
+    return 0;
+}
+
+// 加入成功返回 1（已存在或列表已满返回 0）
+static int add_scan_pid(int32_t pid) {
+    if (scan_pid_watched(pid) || scan_pid_count == (int)(sizeof(scan_pids) / sizeof(scan_pids[0]))) return 0;
+    scan_pids[scan_pid_count++] = pid;
+    return 1;
+}
+
+static void collect_scan_pids(void) {
+    scan_pid_count = 0;
+    for (int i = 0; i < watch_pid_count; i++) add_scan_pid(watch_pids[i]);
+    if (!watch_children) return;
+    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snap == INVALID_HANDLE_VALUE) return;
+    // 反复扫描快照直到不再有新的子孙进程加入
+    for (int added = 1; added;) {
+        added = 0;
+        PROCESSENTRY32 pe;
+        pe.dwSize = sizeof(pe);
+        for (BOOL ok = Process32First(snap, &pe); ok; ok = Process32Next(snap, &pe)) {
+            if (scan_pid_watched((int32_t)pe.th32ParentProcessID) && add_scan_pid((int32_t)pe.th32ProcessID)) added = 1;
+        }
+    }
+    CloseHandle(snap);
+}
+
 ConnectionInfo* scanner_get_connections(int *count) {
     int capacity = 256;
     int n = 0;
     ConnectionInfo *conns = malloc(sizeof(ConnectionInfo) * capacity);
     if (!conns) return NULL;
+    if (watch_pid_count > 0) collect_scan_pids();
 
     // --- 获取 TCP 表 ---
     ULONG size = 0;
@@ -106,6 +171,21 @@ ConnectionInfo* scanner_get_connections(int *count) {
             c->status_enum = win_tcp_status_enum(pTcpTable->table[i].dwState);
             strcpy(c->status, status_enum_to_str(c->status_enum));
             c->pid = pTcpTable->table[i].dwOwningPid;
+            strcpy(c->process, "N/A");
+            c->inode = 0; // Windows 无套接字 inode，仅以五元组标识
+            c->first_seen = 0;
+            c->state_since = 0;
+            c->tx_queue = 0;
+            c->rx_queue = 0;
+            c->backlog = 0;
+            c->group_count = 1;
+            c->group_port_min = 0;
+            c->group_port_max = 0;
+            memset(&c->tcp, 0, sizeof(c->tcp));
+            if ((scan_filter_active && !row_matches(c)) || (watch_pid_count > 0 && !scan_pid_watched(c->pid))) {
+                n--;
+                continue;
+            }
             get_win_process_name(c->pid, c->process);
         }
     }
@@ -137,6 +217,21 @@ ConnectionInfo* scanner_get_connections(int *count) {
             c->status_enum = CONN_STATUS_NONE;
             strcpy(c->status, "NONE");
             c->pid = pUdpTable->table[i].dwOwningPid;
+            strcpy(c->process, "N/A");
+            c->inode = 0; // Windows 无套接字 inode，仅以五元组标识
+            c->first_seen = 0;
+            c->state_since = 0;
+            c->tx_queue = 0;
+            c->rx_queue = 0;
+            c->backlog = 0;
+            c->group_count = 1;
+            c->group_port_min = 0;
+            c->group_port_max = 0;
+            memset(&c->tcp, 0, sizeof(c->tcp));
+            if ((scan_filter_active && !row_matches(c)) || (watch_pid_count > 0 && !scan_pid_watched(c->pid))) {
+                n--;
+                continue;
+            }
             get_win_process_name(c->pid, c->process);
         }
     }
@@ -146,6 +241,27 @@ ConnectionInfo* scanner_get_connections(int *count) {
     return conns;
 }
 
+// Windows 没有 procfs
+int scanner_set_proc_root(const char *root) {
+    (void)root;
+    return -1;
+}
+const char *scanner_proc_root(void) {
+    return "/proc";
+}
+int scanner_proc_root_is_live(void) {
+    return 1;
+}
+
+// Windows 下没有廉价的逐进程句柄枚举，fd 总数不可用
+void scanner_visit_fd_counts(ProcessFdVisit visit, void *ctx) {
+    (void)visit; (void)ctx;
+}
+
+uint64_t scanner_syscall_count(void) {
+    return 0;
+}
+
 void scanner_free_connections(ConnectionInfo *conns, int count) {
     (void)count; // 明确标记未使用参数
     if (conns) free(conns);
@@ -153,6 +269,28 @@ void scanner_free_connections(ConnectionInfo *conns, int count) {
 
 #else
 // 非 Windows 下的占位
+void scanner_set_filter(const struct ConnFilter *f) {
+    (void)f;
+}
+void scanner_set_pids(const int32_t *pids, int count, int with_children) {
+    (void)pids; (void)count; (void)with_children;
+}
+void scanner_visit_fd_counts(ProcessFdVisit visit, void *ctx) {
+    (void)visit; (void)ctx;
+}
+uint64_t scanner_syscall_count(void) {
+    return 0;
+}
+int scanner_set_proc_root(const char *root) {
+    (void)root;
+    return -1;
+}
+const char *scanner_proc_root(void) {
+    return "/proc";
+}
+int scanner_proc_root_is_live(void) {
+    return 1;
+}
 ConnectionInfo* scanner_get_connections(int *count) {
     *count = 0;
     return NULL;
@@ -0,0 +1,371 @@
+#include "backend/sock_diag.h"
+
+#ifdef _WIN32
+int sock_diag_fill_tcp_info(ConnectionInfo *conns, int count) { (void)conns; (void)count; return -1; }
+int sock_diag_fill_listen_backlog(ConnectionInfo *conns, int count) { (void)conns; (void)count; return -1; }
+int sock_diag_set_filter(const struct ConnFilter *f) { (void)f; return -1; }
+int sock_diag_scan(uint8_t protocol, DiagSocketVisit visit, void *ctx) { (void)protocol; (void)visit; (void)ctx; return -1; }
+int sock_diag_query(uint32_t src, uint16_t sport, uint32_t dst, uint16_t dport, DiagSocket *out, TcpDiag *tcp) {
+    (void)src; (void)sport; (void)dst; (void)dport; (void)out; (void)tcp;
+    return -1;
+}
+ConnectionStatus sock_diag_status(uint8_t kernel_state) { (void)kernel_state; return CONN_STATUS_UNKNOWN; }
+void sock_diag_close(void) {}
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/tcp.h>
+#include "lib/conn_filter.h"
+
+#define DIAG_RECV_BUF (64 * 1024)
+#define DIAG_BC_MAX 64
+#define TCP_STATE_TIME_WAIT 6
+#define TCP_STATE_LISTEN 10
+#define TCP_STATE_NEW_SYN_RECV 12
+
+static int diag_fd = -1;
+static char recv_buf[DIAG_RECV_BUF] __attribute__((aligned(8)));
+
+// 当前过滤：TCP 状态掩码（内核状态号位图）与字节码，作用于之后的每次 dump
+static uint32_t filter_tcp_states = ~0u;
+static unsigned char filter_bc[DIAG_BC_MAX] __attribute__((aligned(4)));
+static int filter_bc_len = 0;
+
+// ConnectionStatus -> 内核 TCP 状态号（0 表示无对应）
+static const uint8_t KERNEL_STATE[CONN_STATUS_COUNT] = {
+    [CONN_STATUS_ESTABLISHED] = 1, [CONN_STATUS_SYN_SENT] = 2, [CONN_STATUS_SYN_RECV] = 3,
+    [CONN_STATUS_FIN_WAIT1] = 4, [CONN_STATUS_FIN_WAIT2] = 5, [CONN_STATUS_TIME_WAIT] = 6,
+    [CONN_STATUS_CLOSE] = 7, [CONN_STATUS_CLOSE_WAIT] = 8, [CONN_STATUS_LAST_ACK] = 9,
+    [CONN_STATUS_LISTEN] = 10, [CONN_STATUS_CLOSING] = 11,
+};
+
+// inode -> conns 下标的开放寻址索引（跨轮复用）
+static int *inode_index = NULL;
+static size_t inode_index_cap = 0;
+
+typedef void (*DiagVisit)(const struct inet_diag_msg *msg, struct rtattr **attrs, void *ctx);
+
+static int diag_open(void) {
+    if (diag_fd != -1) return 0;
+    diag_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    return diag_fd == -1 ? -1 : 0;
+}
+
+// 发送请求并逐条回调应答；single 为 1 时（非 dump 请求）收到首条应答即返回
+// 成功返回 0，内核报错返回其负 errno，其他失败返回 -EIO
+static int diag_transact(struct nlmsghdr *req, DiagVisit visit, void *ctx, int single) {
+    struct sockaddr_nl nladdr;
+    memset(&nladdr, 0, sizeof(nladdr));
+    nladdr.nl_family = AF_NETLINK;
+    if (sendto(diag_fd, req, req->nlmsg_len, 0, (struct sockaddr *)&nladdr, sizeof(nladdr)) < 0) return -EIO;
+
+    for (;;) {
+        ssize_t len = recv(diag_fd, recv_buf, sizeof(recv_buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            return -EIO;
+        }
+        struct nlmsghdr *nlh = (struct nlmsghdr *)recv_buf;
+        for (; NLMSG_OK(nlh, (size_t)len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == NLMSG_DONE) return 0;
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr *err = NLMSG_DATA(nlh);
+                return err->error ? err->error : -EIO;
+            }
+            if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+
+            const struct inet_diag_msg *dm = NLMSG_DATA(nlh);
+            struct rtattr *attrs[INET_DIAG_MAX + 1];
+            memset(attrs, 0, sizeof(attrs));
+            int rta_len = (int)(nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*dm)));
+            for (struct rtattr *rta = (struct rtattr *)(dm + 1); RTA_OK(rta, rta_len); rta = RTA_NEXT(rta, rta_len)) {
+                if (rta->rta_type <= INET_DIAG_MAX) attrs[rta->rta_type] = rta;
+            }
+            visit(dm, attrs, ctx);
+            if (single) return 0;
+        }
+    }
+}
+
+// 发送一次 dump 请求并逐条回调；states 为 TCP 状态位掩码（1 << state），TCP 会再与过滤掩码相与
+// 设置了过滤时附带 INET_DIAG_REQ_BYTECODE，不匹配的套接字不会离开内核
+static int diag_dump(uint8_t protocol, uint32_t states, uint8_t ext, DiagVisit visit, void *ctx) {
+    if (diag_open() != 0) return -1;
+
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+        struct rtattr bc_attr;
+        unsigned char bc[DIAG_BC_MAX];
+    } msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(msg.req));
+    msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    msg.req.sdiag_family = AF_INET;
+    msg.req.sdiag_protocol = protocol;
+    msg.req.idiag_ext = ext;
+    msg.req.idiag_states = protocol == IPPROTO_TCP ? states & filter_tcp_states : states;
+    if (filter_bc_len > 0) {
+        msg.bc_attr.rta_type = INET_DIAG_REQ_BYTECODE;
+        msg.bc_attr.rta_len = RTA_LENGTH(filter_bc_len);
+        memcpy(msg.bc, filter_bc, filter_bc_len);
+        msg.nlh.nlmsg_len += RTA_ALIGN(msg.bc_attr.rta_len);
+    }
+
+    return diag_transact(&msg.nlh, visit, ctx, 0) == 0 ? 0 : -1;
+}
+
+typedef struct {
+    ConnectionInfo *conns;
+    int filled;
+} FillCtx;
+
+static size_t inode_slot(uint64_t inode) {
+    return (size_t)((inode * 0x9E3779B97F4A7C15ull) >> 32) & (inode_index_cap - 1);
+}
+
+// 为 conns 中的 TCP 行建立 inode 索引；内存不足返回 -1
+static int build_inode_index(const ConnectionInfo *conns, int count) {
+    size_t need = 1024;
+    while (need < (size_t)count * 2) need <<= 1;
+    if (need > inode_index_cap) {
+        int *tmp = realloc(inode_index, sizeof(int) * need);
+        if (!tmp) return -1;
+        inode_index = tmp;
+        inode_index_cap = need;
+    }
+    for (size_t i = 0; i < inode_index_cap; i++) inode_index[i] = -1;
+
+    for (int i = 0; i < count; i++) {
+        if (conns[i].inode == 0 || strcmp(conns[i].protocol, "TCP") != 0) continue;
+        size_t pos = inode_slot(conns[i].inode);
+        while (inode_index[pos] != -1) pos = (pos + 1) & (inode_index_cap - 1);
+        inode_index[pos] = i;
+    }
+    return 0;
+}
+
+// 按 inode 查找行，找不到返回 NULL
+static ConnectionInfo *lookup_inode(ConnectionInfo *conns, uint64_t inode) {
+    if (inode == 0) return NULL;
+    size_t pos = inode_slot(inode);
+    while (inode_index[pos] != -1 && conns[inode_index[pos]].inode != inode) pos = (pos + 1) & (inode_index_cap - 1);
+    return inode_index[pos] == -1 ? NULL : &conns[inode_index[pos]];
+}
+
+// 从 INET_DIAG_INFO 属性解出 tcp_info 计数（速率字段不动）
+static void parse_tcp_info(const struct rtattr *info, TcpDiag *t) {
+    // 旧内核的 tcp_info 较短，缺失的尾部字段保持为 0
+    struct tcp_info ti;
+    memset(&ti, 0, sizeof(ti));
+    size_t n = RTA_PAYLOAD(info);
+    memcpy(&ti, RTA_DATA(info), n < sizeof(ti) ? n : sizeof(ti));
+
+    t->valid = 1;
+    t->bytes_acked = ti.tcpi_bytes_acked;
+    t->bytes_received = ti.tcpi_bytes_received;
+    t->segs_out = ti.tcpi_segs_out;
+    t->segs_in = ti.tcpi_segs_in;
+    t->rtt_us = ti.tcpi_rtt;
+    t->rttvar_us = ti.tcpi_rttvar;
+    t->total_retrans = ti.tcpi_total_retrans;
+    t->snd_cwnd = ti.tcpi_snd_cwnd;
+    t->ca_state = ti.tcpi_ca_state;
+}
+
+static void visit_tcp_info(const struct inet_diag_msg *dm, struct rtattr **attrs, void *ctx) {
+    FillCtx *fc = ctx;
+    if (!attrs[INET_DIAG_INFO]) return;
+    ConnectionInfo *c = lookup_inode(fc->conns, dm->idiag_inode);
+    if (!c) return;
+    parse_tcp_info(attrs[INET_DIAG_INFO], &c->tcp);
+    fc->filled++;
+}
+
+int sock_diag_fill_tcp_info(ConnectionInfo *conns, int count) {
+    if (build_inode_index(conns, count) != 0) return -1;
+
+    // TIME_WAIT 套接字没有 tcp_info，直接在内核侧排除
+    FillCtx fc = { conns, 0 };
+    if (diag_dump(IPPROTO_TCP, ~(1u << TCP_STATE_TIME_WAIT), 1 << (INET_DIAG_INFO - 1), visit_tcp_info, &fc) != 0) return -1;
+    return fc.filled;
+}
+
+// LISTEN 套接字：idiag_rqueue 为当前 accept 队列长度，idiag_wqueue 为 backlog 上限
+static void visit_listen(const struct inet_diag_msg *dm, struct rtattr **attrs, void *ctx) {
+    (void)attrs;
+    FillCtx *fc = ctx;
+    ConnectionInfo *c = lookup_inode(fc->conns, dm->idiag_inode);
+    if (!c) return;
+    c->rx_queue = dm->idiag_rqueue;
+    c->backlog = dm->idiag_wqueue;
+    fc->filled++;
+}
+
+int sock_diag_fill_listen_backlog(ConnectionInfo *conns, int count) {
+    if (build_inode_index(conns, count) != 0) return -1;
+    FillCtx fc = { conns, 0 };
+    if (diag_dump(IPPROTO_TCP, 1u << TCP_STATE_LISTEN, 0, visit_listen, &fc) != 0) return -1;
+    return fc.filled;
+}
+
+// 追加一条主机条件（S_COND / D_COND）：no 为不匹配时的相对跳转，匹配时顺序执行下一条
+static int bc_hostcond(int pos, uint8_t code, int port, uint8_t prefix_len, uint32_t addr_be, int no) {
+    struct inet_diag_bc_op *op = (struct inet_diag_bc_op *)(filter_bc + pos);
+    struct inet_diag_hostcond *cond = (struct inet_diag_hostcond *)(op + 1);
+    int len = (int)(sizeof(*op) + sizeof(*cond)) + (prefix_len ? 4 : 0);
+    op->code = code;
+    op->yes = (uint8_t)len;
+    op->no = (uint16_t)no;
+    cond->family = prefix_len ? AF_INET : AF_UNSPEC;
+    cond->prefix_len = prefix_len;
+    cond->port = port;
+    if (prefix_len) memcpy(cond->addr, &addr_be, 4);
+    return pos + len;
+}
+
+// 把 port / cidr 条件编译为字节码（各组之间为"与"）
+// 内核逐条执行：匹配前进 yes，不匹配跳 no；恰好走到末尾为接受，跳到末尾之后 4 字节为拒绝
+// 审核要求每条指令都在 yes 链上，因此"或"用 JMP 跳过组内剩余条件，而不是让 yes 直接跳转
+static int compile_bytecode(const ConnFilter *f) {
+    const int host_len = (int)(sizeof(struct inet_diag_bc_op) + sizeof(struct inet_diag_hostcond));
+    const int jmp_len = (int)sizeof(struct inet_diag_bc_op);
+    // 远端 CIDR 前缀长度；/0 恒真，无需生成指令
+    uint8_t prefix = 0;
+    if (f->has_cidr) for (uint32_t m = f->cidr_mask; m; m <<= 1) prefix++;
+    int total = (f->port >= 0 ? host_len * 2 + jmp_len : 0) + (prefix ? host_len + 4 : 0);
+    int pos = 0;
+    memset(filter_bc, 0, sizeof(filter_bc));
+
+    if (f->port >= 0) {
+        // 本地端口 == port || 远端端口 == port
+        int group_end = host_len * 2 + jmp_len;
+        pos = bc_hostcond(pos, INET_DIAG_BC_S_COND, f->port, 0, 0, host_len + jmp_len);
+        struct inet_diag_bc_op *jmp = (struct inet_diag_bc_op *)(filter_bc + pos);
+        jmp->code = INET_DIAG_BC_JMP;
+        jmp->yes = (uint8_t)jmp_len;
+        jmp->no = (uint16_t)(group_end - pos);
+        pos += jmp_len;
+        pos = bc_hostcond(pos, INET_DIAG_BC_D_COND, f->port, 0, 0, total + 4 - pos);
+    }
+    // 远端地址落在 CIDR 内
+    if (prefix) bc_hostcond(pos, INET_DIAG_BC_D_COND, -1, prefix, htonl(f->cidr_net), total + 4 - pos);
+    return total;
+}
+
+int sock_diag_set_filter(const struct ConnFilter *f) {
+    filter_tcp_states = ~0u;
+    filter_bc_len = 0;
+    if (!f) return 0;
+
+    if (f->state_mask) {
+        filter_tcp_states = 0;
+        for (int st = 0; st < CONN_STATUS_COUNT; st++) {
+            if (!(f->state_mask & (1u << st)) || KERNEL_STATE[st] == 0) continue;
+            filter_tcp_states |= 1u << KERNEL_STATE[st];
+        }
+        // 半连接（request sock）在新内核中单独以 NEW_SYN_RECV 计，展示为 SYN_RECV
+        if (f->state_mask & (1u << CONN_STATUS_SYN_RECV)) filter_tcp_states |= 1u << TCP_STATE_NEW_SYN_RECV;
+    }
+    filter_bc_len = compile_bytecode(f);
+    return 0;
+}
+
+typedef struct {
+    DiagSocketVisit visit;
+    void *ctx;
+    int n;
+} ScanCtx;
+
+static void to_diag_socket(const struct inet_diag_msg *dm, DiagSocket *s) {
+    s->state = dm->idiag_state;
+    s->src = dm->id.idiag_src[0];
+    s->dst = dm->id.idiag_dst[0];
+    s->sport = ntohs(dm->id.idiag_sport);
+    s->dport = ntohs(dm->id.idiag_dport);
+    s->rqueue = dm->idiag_rqueue;
+    s->wqueue = dm->idiag_wqueue;
+    s->inode = dm->idiag_inode;
+}
+
+static void visit_scan(const struct inet_diag_msg *dm, struct rtattr **attrs, void *ctx) {
+    (void)attrs;
+    ScanCtx *sc = ctx;
+    DiagSocket s;
+    to_diag_socket(dm, &s);
+    sc->visit(&s, sc->ctx);
+    sc->n++;
+}
+
+int sock_diag_scan(uint8_t protocol, DiagSocketVisit visit, void *ctx) {
+    ScanCtx sc = { visit, ctx, 0 };
+    if (diag_dump(protocol, ~0u, 0, visit_scan, &sc) != 0) return -1;
+    return sc.n;
+}
+
+typedef struct {
+    DiagSocket *out;
+    TcpDiag *tcp;
+} QueryCtx;
+
+static void visit_query(const struct inet_diag_msg *dm, struct rtattr **attrs, void *ctx) {
+    QueryCtx *qc = ctx;
+    to_diag_socket(dm, qc->out);
+    if (qc->tcp && attrs[INET_DIAG_INFO]) parse_tcp_info(attrs[INET_DIAG_INFO], qc->tcp);
+}
+
+int sock_diag_query(uint32_t src, uint16_t sport, uint32_t dst, uint16_t dport, DiagSocket *out, TcpDiag *tcp) {
+    if (diag_open() != 0) return -1;
+
+    // 非 dump 请求：内核按四元组直接查哈希表，只返回这一个套接字，不受扫描过滤影响
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.nlh.nlmsg_len = sizeof(msg);
+    msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST;
+    msg.req.sdiag_family = AF_INET;
+    msg.req.sdiag_protocol = IPPROTO_TCP;
+    msg.req.idiag_ext = tcp ? 1 << (INET_DIAG_INFO - 1) : 0;
+    msg.req.idiag_states = ~0u;
+    msg.req.id.idiag_src[0] = src;
+    msg.req.id.idiag_dst[0] = dst;
+    msg.req.id.idiag_sport = htons(sport);
+    msg.req.id.idiag_dport = htons(dport);
+    msg.req.id.idiag_cookie[0] = INET_DIAG_NOCOOKIE;
+    msg.req.id.idiag_cookie[1] = INET_DIAG_NOCOOKIE;
+
+    QueryCtx qc = { out, tcp };
+    int rc = diag_transact(&msg.nlh, visit_query, &qc, 1);
+    if (rc == 0) return 0;
+    return rc == -ENOENT ? 1 : -1;
+}
+
+ConnectionStatus sock_diag_status(uint8_t kernel_state) {
+    if (kernel_state == TCP_STATE_NEW_SYN_RECV) return CONN_STATUS_SYN_RECV;
+    for (int st = 0; st < CONN_STATUS_COUNT; st++) {
+        if (KERNEL_STATE[st] == kernel_state && kernel_state != 0) return (ConnectionStatus)st;
+    }
+    return CONN_STATUS_UNKNOWN;
+}
+
+void sock_diag_close(void) {
+    if (diag_fd != -1) close(diag_fd);
+    diag_fd = -1;
+    free(inode_index);
+    inode_index = NULL;
+    inode_index_cap = 0;
+}
+#endif
@@ -0,0 +1,51 @@
+#ifndef SOCK_DIAG_H
+#define SOCK_DIAG_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// sock_diag（NETLINK_SOCK_DIAG）驱动：一次 dump 批量取得内核中的 TCP 套接字扩展信息
+// 仅 Linux 可用，其他平台各接口返回 -1
+
+// 通过 INET_DIAG_INFO 取得每个 TCP 套接字的 tcp_info（字节/段计数、RTT、重传、拥塞状态），按 inode 回填 conns[i].tcp
+// 成功返回回填的连接数，sock_diag 不可用时返回 -1
+int sock_diag_fill_tcp_info(ConnectionInfo *conns, int count);
+
+// 只 dump LISTEN 状态的 TCP 套接字（开销很小），按 inode 回填 backlog 上限并刷新 rx_queue（accept 队列长度）
+// 成功返回回填的连接数，sock_diag 不可用时返回 -1
+int sock_diag_fill_listen_backlog(ConnectionInfo *conns, int count);
+
+// 设置之后所有 dump 的内核侧过滤：state 转为 idiag_states 掩码，port / cidr 编译为 INET_DIAG_REQ_BYTECODE
+// NULL 清除；pid 条件忽略。成功返回 0
+struct ConnFilter;
+int sock_diag_set_filter(const struct ConnFilter *f);
+
+// dump 得到的单个套接字（IPv4）
+typedef struct {
+    uint8_t state;           // 内核 TCP 状态号（与 /proc/net/tcp 的 st 列一致）
+    uint32_t src;            // 网络字节序
+    uint32_t dst;
+    uint16_t sport;          // 主机字节序
+    uint16_t dport;
+    uint32_t rqueue;         // 接收队列；LISTEN 为 accept 队列长度
+    uint32_t wqueue;         // 发送队列；LISTEN 为 backlog 上限
+    uint64_t inode;
+} DiagSocket;
+
+typedef void (*DiagSocketVisit)(const DiagSocket *s, void *ctx);
+
+// 按当前过滤 dump 指定协议（IPPROTO_TCP / IPPROTO_UDP）的套接字并逐个回调
+// 返回回调次数，sock_diag 不可用（或 UDP 未加载 udp_diag）时返回 -1
+int sock_diag_scan(uint8_t protocol, DiagSocketVisit visit, void *ctx);
+
+// 按四元组（IP 网络字节序、端口主机字节序）精确查询单个 TCP 套接字，tcp 非 NULL 时一并取回 tcp_info
+// 找到返回 0，套接字已不存在返回 1，sock_diag 不可用返回 -1
+int sock_diag_query(uint32_t src, uint16_t sport, uint32_t dst, uint16_t dport, DiagSocket *out, TcpDiag *tcp);
+
+// 内核 TCP 状态号 -> ConnectionStatus
+ConnectionStatus sock_diag_status(uint8_t kernel_state);
+
+// 关闭 netlink 套接字并释放复用缓冲区
+void sock_diag_close(void);
+
+#endif // SOCK_DIAG_H
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "backend/scanner.h"
+#include "lib/stream_writer.h"
+#include "lib/strtab.h"
+#include "lib/ncm_columnar.h"
+
+// 机器可读导出（JSON 行 / CSV / 列式二进制）：与 HTML 导出共用 StreamWriter，逐行输出不做堆分配
+
+// 把 "ip:port" 在最后一个 ':' 处拆开；无端口时 port 为 0
+static void split_endpoint(const char *addr, char *ip, size_t ip_size, int *port) {
+    const char *colon = strrchr(addr, ':');
+    size_t n = colon ? (size_t)(colon - addr) : strlen(addr);
+    if (n >= ip_size) n = ip_size - 1;
+    memcpy(ip, addr, n);
+    ip[n] = '\0';
+    *port = colon ? atoi(colon + 1) : 0;
+}
+
+// 打开输出文件，"-" 表示标准输出（便于 ssh host ncm -e - --format csv 直接管道给分析工具）
+static FILE *open_output(const char *filename, const char *mode) {
+    if (strcmp(filename, "-") == 0) return stdout;
+    FILE *fp = fopen(filename, mode);
+    if (!fp) fprintf(stderr, "错误：无法创建文件 %s\n", filename);
+    return fp;
+}
+
+static int close_output(FILE *fp, StreamWriter *w, const char *filename) {
+    int rc = sw_flush(w);
+    if (fp != stdout && fclose(fp) != 0) rc = -1;
+    if (rc != 0) fprintf(stderr, "错误：写入 %s 失败\n", filename);
+    return rc;
+}
+
+// JSON 行（NDJSON）：每行一个对象，pandas.read_json(lines=True) / DuckDB read_json 可直接加载
+int export_json_report(const char *filename, ConnectionInfo *conns, int count) {
+    FILE *fp = open_output(filename, "w");
+    if (!fp) return -1;
+    StreamWriter *w = malloc(sizeof(StreamWriter));
+    if (!w) {
+        if (fp != stdout) fclose(fp);
+        return -1;
+    }
+    sw_init(w, fp);
+
+    for (int i = 0; i < count; i++) {
+        ConnectionInfo *c = &conns[i];
+        int suspicious = is_suspicious(c);
+        char local_ip[128], remote_ip[128];
+        int local_port, remote_port;
+        split_endpoint(c->local_addr, local_ip, sizeof(local_ip), &local_port);
+        split_endpoint(c->remote_addr, remote_ip, sizeof(remote_ip), &remote_port);
+
+        sw_puts(w, "{\"proto\":");
+        sw_json_str(w, c->protocol);
+        sw_puts(w, ",\"local_ip\":");
+        sw_json_str(w, local_ip);
+        sw_puts(w, ",\"local_port\":");
+        sw_int(w, local_port);
+        sw_puts(w, ",\"remote_ip\":");
+        sw_json_str(w, remote_ip);
+        sw_puts(w, ",\"remote_port\":");
+        sw_int(w, remote_port);
+        sw_puts(w, ",\"state\":");
+        sw_json_str(w, c->status);
+        sw_puts(w, ",\"pid\":");
+        sw_int(w, c->pid);
+        sw_puts(w, ",\"process\":");
+        sw_json_str(w, c->process);
+        sw_puts(w, ",\"exe\":");
+        sw_json_str(w, c->exe_path);
+        sw_puts(w, ",\"risk\":");
+        sw_json_str(w, c->risk_reason);
+        sw_puts(w, suspicious ? ",\"suspicious\":true}\n" : ",\"suspicious\":false}\n");
+    }
+
+    int rc = close_output(fp, w, filename);
+    free(w);
+    return rc;
+}
+
+// CSV（RFC 4180）：首行为列名，含逗号/引号/换行的字段加引号转义
+int export_csv_report(const char *filename, ConnectionInfo *conns, int count) {
+    FILE *fp = open_output(filename, "w");
+    if (!fp) return -1;
+    StreamWriter *w = malloc(sizeof(StreamWriter));
+    if (!w) {
+        if (fp != stdout) fclose(fp);
+        return -1;
+    }
+    sw_init(w, fp);
+
+    sw_puts(w, "proto,local_ip,local_port,remote_ip,remote_port,state,pid,process,exe,risk,suspicious\r\n");
+    for (int i = 0; i < count; i++) {
+        ConnectionInfo *c = &conns[i];
+        int suspicious = is_suspicious(c);
+        char local_ip[128], remote_ip[128];
+        int local_port, remote_port;
+        split_endpoint(c->local_addr, local_ip, sizeof(local_ip), &local_port);
+        split_endpoint(c->remote_addr, remote_ip, sizeof(remote_ip), &remote_port);
+
+        sw_csv_field(w, c->protocol);
+        sw_putc(w, ',');
+        sw_csv_field(w, local_ip);
+        sw_putc(w, ',');
+        sw_int(w, local_port);
+        sw_putc(w, ',');
+        sw_csv_field(w, remote_ip);
+        sw_putc(w, ',');
+        sw_int(w, remote_port);
+        sw_putc(w, ',');
+        sw_csv_field(w, c->status);
+        sw_putc(w, ',');
+        sw_int(w, c->pid);
+        sw_putc(w, ',');
+        sw_csv_field(w, c->process);
+        sw_putc(w, ',');
+        sw_csv_field(w, c->exe_path);
+        sw_putc(w, ',');
+        sw_csv_field(w, c->risk_reason);
+        sw_puts(w, suspicious ? ",1\r\n" : ",0\r\n");
+    }
+
+    int rc = close_output(fp, w, filename);
+    free(w);
+    return rc;
+}
+
+// ---- 列式二进制（布局见 lib/ncm_columnar.h） ----
+
+enum {
+    BIN_PROTO, BIN_STATE, BIN_LOCAL_IP, BIN_LOCAL_PORT, BIN_REMOTE_IP, BIN_REMOTE_PORT,
+    BIN_PID, BIN_PROCESS, BIN_EXE, BIN_RISK, BIN_FLAGS, BIN_COLUMNS
+};
+
+static const struct {
+    const char *name;
+    uint8_t type;
+    uint8_t width;
+} BIN_LAYOUT[BIN_COLUMNS] = {
+    { "proto",       NCM_COL_U8,   1 },
+    { "state",       NCM_COL_STR8, 1 },
+    { "local_ip",    NCM_COL_IPV4, 4 },
+    { "local_port",  NCM_COL_U16,  2 },
+    { "remote_ip",   NCM_COL_IPV4, 4 },
+    { "remote_port", NCM_COL_U16,  2 },
+    { "pid",         NCM_COL_I32,  4 },
+    { "process",     NCM_COL_STR,  4 },
+    { "exe",         NCM_COL_STR,  4 },
+    { "risk",        NCM_COL_STR,  4 },
+    { "flags",       NCM_COL_U8,   1 },
+};
+
+static uint64_t align_up(uint64_t v) {
+    return (v + NCM_COL_ALIGN - 1) & ~(uint64_t)(NCM_COL_ALIGN - 1);
+}
+
+static void sw_pad(StreamWriter *w, uint64_t from, uint64_t to) {
+    static const char zeros[NCM_COL_ALIGN] = {0};
+    sw_write(w, zeros, (size_t)(to - from));
+}
+
+// 列数据先按文件中的最终布局填入一整块内存，再整体写出
+int export_bin_report(const char *filename, ConnectionInfo *conns, int count) {
+    uint64_t col_off[BIN_COLUMNS];
+    uint64_t data_size = 0;
+    for (int c = 0; c < BIN_COLUMNS; c++) {
+        col_off[c] = data_size;
+        data_size = align_up(data_size + (uint64_t)BIN_LAYOUT[c].width * (uint64_t)count);
+    }
+    unsigned char *data = calloc(1, (size_t)(data_size > 0 ? data_size : 1));
+    if (!data) return -1;
+    uint8_t *proto = data + col_off[BIN_PROTO];
+    uint8_t *state = data + col_off[BIN_STATE];
+    uint32_t *local_ip = (uint32_t *)(data + col_off[BIN_LOCAL_IP]);
+    uint16_t *local_port = (uint16_t *)(data + col_off[BIN_LOCAL_PORT]);
+    uint32_t *remote_ip = (uint32_t *)(data + col_off[BIN_REMOTE_IP]);
+    uint16_t *remote_port = (uint16_t *)(data + col_off[BIN_REMOTE_PORT]);
+    int32_t *pid = (int32_t *)(data + col_off[BIN_PID]);
+    uint32_t *process = (uint32_t *)(data + col_off[BIN_PROCESS]);
+    uint32_t *exe = (uint32_t *)(data + col_off[BIN_EXE]);
+    uint32_t *risk = (uint32_t *)(data + col_off[BIN_RISK]);
+    uint8_t *flags = data + col_off[BIN_FLAGS];
+
+    // 状态名最先入表，使 state 列的枚举值即为字符串表下标
+    StringTable tab;
+    strtab_init(&tab);
+    for (int s = 0; s < CONN_STATUS_COUNT; s++) strtab_intern(&tab, conn_status_name((ConnectionStatus)s));
+
+    for (int i = 0; i < count; i++) {
+        ConnectionInfo *c = &conns[i];
+        uint8_t f = 0;
+        if (is_suspicious(c)) f |= 1;
+        if (is_external_connection(c)) f |= 2;
+        proto[i] = (strcmp(c->protocol, "UDP") == 0) ? 17 : 6;
+        state[i] = (uint8_t)c->status_enum;
+        if (parse_ipv4_endpoint(c->local_addr, &local_ip[i], &local_port[i]) != 0) {
+            local_ip[i] = 0;
+            local_port[i] = 0;
+        }
+        if (parse_ipv4_endpoint(c->remote_addr, &remote_ip[i], &remote_port[i]) != 0) {
+            remote_ip[i] = 0;
+            remote_port[i] = 0;
+        }
+        pid[i] = c->pid;
+        process[i] = (uint32_t)strtab_intern(&tab, c->process);
+        exe[i] = (uint32_t)strtab_intern(&tab, c->exe_path);
+        risk[i] = (uint32_t)strtab_intern(&tab, c->risk_reason);
+        flags[i] = f;
+    }
+    if (tab.failed) {
+        fprintf(stderr, "错误：内存不足，无法导出 %s\n", filename);
+        strtab_free(&tab);
+        free(data);
+        return -1;
+    }
+
+    // 计算各段偏移
+    uint64_t str_bytes = 0;
+    for (int s = 0; s < tab.count; s++) str_bytes += strlen(tab.strs[s]);
+    uint64_t desc_end = sizeof(NcmColHeader) + sizeof(NcmColDesc) * BIN_COLUMNS;
+    uint64_t strtab_offset = align_up(desc_end);
+    uint64_t strtab_size = sizeof(uint32_t) * ((uint64_t)tab.count + 1) + str_bytes;
+    uint64_t data_offset = align_up(strtab_offset + strtab_size);
+
+    FILE *fp = open_output(filename, "wb");
+    StreamWriter *w = fp ? malloc(sizeof(StreamWriter)) : NULL;
+    if (!w) {
+        if (fp && fp != stdout) fclose(fp);
+        strtab_free(&tab);
+        free(data);
+        return -1;
+    }
+    sw_init(w, fp);
+
+    NcmColHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = NCM_COL_MAGIC;
+    hdr.version = NCM_COL_VERSION;
+    hdr.n_columns = BIN_COLUMNS;
+    hdr.n_rows = (uint32_t)count;
+    hdr.n_strings = (uint32_t)tab.count;
+    hdr.timestamp = (uint64_t)time(NULL);
+    hdr.strtab_offset = strtab_offset;
+    hdr.strtab_size = strtab_size;
+    sw_write(w, &hdr, sizeof(hdr));
+
+    for (int c = 0; c < BIN_COLUMNS; c++) {
+        NcmColDesc d;
+        memset(&d, 0, sizeof(d));
+        strncpy(d.name, BIN_LAYOUT[c].name, sizeof(d.name) - 1);
+        d.type = BIN_LAYOUT[c].type;
+        d.width = BIN_LAYOUT[c].width;
+        d.offset = data_offset + col_off[c];
+        sw_write(w, &d, sizeof(d));
+    }
+    sw_pad(w, desc_end, strtab_offset);
+
+    uint32_t off = 0;
+    sw_write(w, &off, sizeof(off));
+    for (int s = 0; s < tab.count; s++) {
+        off += (uint32_t)strlen(tab.strs[s]);
+        sw_write(w, &off, sizeof(off));
+    }
+    for (int s = 0; s < tab.count; s++) sw_puts(w, tab.strs[s]);
+    sw_pad(w, strtab_offset + strtab_size, data_offset);
+
+    sw_write(w, data, (size_t)data_size);
+
+    int rc = close_output(fp, w, filename);
+    free(w);
+    strtab_free(&tab);
+    free(data);
+    return rc;
+}
+
+// 未显式指定格式时按扩展名推断，默认 HTML
+static const char *format_from_filename(const char *filename) {
+    const char *dot = strrchr(filename, '.');
+    if (!dot) return "html";
+    if (strcmp(dot, ".json") == 0 || strcmp(dot, ".ndjson") == 0) return "json";
+    if (strcmp(dot, ".csv") == 0) return "csv";
+    if (strcmp(dot, ".bin") == 0 || strcmp(dot, ".ncmc") == 0) return "bin";
+    return "html";
+}
+
+int export_report(const char *filename, const char *format, ConnectionInfo *conns, int count) {
+    if (!format) format = format_from_filename(filename);
+    if (strcmp(format, "html") == 0) return export_html_report(filename, conns, count);
+    if (strcmp(format, "json") == 0) return export_json_report(filename, conns, count);
+    if (strcmp(format, "csv") == 0) return export_csv_report(filename, conns, count);
+    if (strcmp(format, "bin") == 0) return export_bin_report(filename, conns, count);
+    fprintf(stderr, "错误：未知导出格式 %s（可选 html|json|csv|bin）\n", format);
+    return -1;
+}
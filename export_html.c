@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
 #include "backend/scanner.h"
+#include "lib/stream_writer.h"
+#include "lib/strtab.h"
+#include "lib/heavy_hitters.h"
 
 // HTML 模板头部（包含内嵌 CSS）
 static const char* HTML_HEADER = 
@@ -16,7 +20,7 @@ static const char* HTML_HEADER =
 "        * { margin: 0; padding: 0; box-sizing: border-box; }\n"
 "        body {\n"
 "            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;\n"
-"            background: linear-gradient(135deg, #1a1a2e 0%%, #16213e 100%%);\n"
+"            background: linear-gradient(135deg, #1a1a2e 0%, #16213e 100%);\n"
 "            color: #e0e0e0;\n"
 "            padding: 20px;\n"
 "            min-height: 100vh;\n"
@@ -75,17 +79,22 @@ static const char* HTML_HEADER =
 "        }\n"
 "        .filters input { flex: 1; min-width: 200px; }\n"
 "        .filters select { min-width: 150px; }\n"
+"        .viewport {\n"
+"            height: 70vh;\n"
+"            overflow-y: auto;\n"
+"            border-radius: 10px;\n"
+"            background: rgba(255, 255, 255, 0.05);\n"
+"        }\n"
 "        table {\n"
-"            width: 100%%;\n"
+"            width: 100%;\n"
 "            border-collapse: collapse;\n"
-"            background: rgba(255, 255, 255, 0.05);\n"
-"            border-radius: 10px;\n"
-"            overflow: hidden;\n"
+"            table-layout: fixed;\n"
 "        }\n"
 "        thead {\n"
-"            background: rgba(78, 204, 163, 0.2);\n"
+"            background: #1f3a4a;\n"
 "            position: sticky;\n"
 "            top: 0;\n"
+"            z-index: 1;\n"
 "        }\n"
 "        th {\n"
 "            padding: 15px;\n"
@@ -95,10 +104,20 @@ static const char* HTML_HEADER =
 "            user-select: none;\n"
 "        }\n"
 "        th:hover { background: rgba(78, 204, 163, 0.3); }\n"
+"        th.asc::after { content: ' ▲'; }\n"
+"        th.desc::after { content: ' ▼'; }\n"
 "        td {\n"
-"            padding: 12px 15px;\n"
+"            padding: 0 15px;\n"
+"            height: 34px;\n"
+"            white-space: nowrap;\n"
+"            overflow: hidden;\n"
+"            text-overflow: ellipsis;\n"
 "            border-bottom: 1px solid rgba(255, 255, 255, 0.1);\n"
 "        }\n"
+"        .summary { color: #888; margin: 8px 0; font-size: 0.9em; }\n"
+"        .hitters { display: flex; gap: 20px; flex-wrap: wrap; margin-bottom: 20px; }\n"
+"        .hitters > div { flex: 1; min-width: 320px; }\n"
+"        .hitters h3 { color: #4ecca3; margin-bottom: 8px; font-size: 1em; }\n"
 "        tr:hover { background: rgba(255, 255, 255, 0.08); }\n"
 "        .suspicious {\n"
 "            background: rgba(255, 107, 107, 0.2) !important;\n"
@@ -123,7 +142,7 @@ static const char* HTML_HEADER =
 "        @media (max-width: 768px) {\n"
 "            .dashboard { grid-template-columns: 1fr; }\n"
 "            table { font-size: 0.85em; }\n"
-"            th, td { padding: 8px; }\n"
+"            th, td { padding: 0 8px; }\n"
 "        }\n"
 "    </style>\n"
 "</head>\n"
@@ -131,186 +150,325 @@ static const char* HTML_HEADER =
 "<div class=\"container\">\n"
 "    <h1>📊 NCM 网络连接报告</h1>\n";
 
-// HTML 模板尾部（包含内嵌 JavaScript）
+// HTML 模板尾部（内嵌 JavaScript）：只渲染可视区域内的行，过滤与排序均在内存索引上完成
+// 数据来自 NCM_DATA 列式载荷：字符串列存放字符串表下标，比较与匹配都按下标缓存
 static const char* HTML_FOOTER = 
 "    <script>\n"
+"        const D = NCM_DATA, S = D.s, N = D.n, ROW_H = 34, OVERSCAN = 20;\n"
 "        const searchInput = document.getElementById('search');\n"
 "        const statusFilter = document.getElementById('statusFilter');\n"
 "        const protocolFilter = document.getElementById('protocolFilter');\n"
-"        const table = document.getElementById('connTable');\n"
-"        const rows = table.querySelectorAll('tbody tr');\n"
+"        const viewport = document.getElementById('viewport');\n"
+"        const tbody = document.querySelector('#connTable tbody');\n"
+"        const summary = document.getElementById('summary');\n"
+"        const SL = S.map(x => x.toLowerCase());\n"
+"        const esc = x => String(x).replace(/[&<>\"']/g, c => ({'&':'&amp;','<':'&lt;','>':'&gt;','\"':'&quot;',\"'\":'&#39;'}[c]));\n"
+"        let view = new Int32Array(N), viewLen = N;\n"
+"        for (let i = 0; i < N; i++) view[i] = i;\n"
+"        let sortCol = -1, sortAsc = true;\n"
 "\n"
-"        // 搜索和过滤\n"
-"        function filterRows() {\n"
-"            const searchTerm = searchInput.value.toLowerCase();\n"
-"            const statusValue = statusFilter.value;\n"
-"            const protocolValue = protocolFilter.value;\n"
-"            let visibleCount = 0;\n"
+"        // 状态下拉框按实际出现的状态生成\n"
+"        [...new Set(D.state)].map(i => S[i]).sort().forEach(st => {\n"
+"            const o = document.createElement('option'); o.textContent = st; statusFilter.appendChild(o);\n"
+"        });\n"
 "\n"
-"            rows.forEach(row => {\n"
-"                const text = row.textContent.toLowerCase();\n"
-"                const status = row.getAttribute('data-status');\n"
-"                const protocol = row.getAttribute('data-protocol');\n"
+"        // 搜索和过滤：先对字符串表逐项匹配一次，再按行查表\n"
+"        function filterRows() {\n"
+"            const term = searchInput.value.toLowerCase();\n"
+"            const st = statusFilter.value ? S.indexOf(statusFilter.value) : -2;\n"
+"            const pr = protocolFilter.value ? S.indexOf(protocolFilter.value) : -2;\n"
+"            let sm = null;\n"
+"            if (term) { sm = new Uint8Array(S.length); for (let i = 0; i < S.length; i++) sm[i] = SL[i].includes(term) ? 1 : 0; }\n"
+"            let k = 0;\n"
+"            for (let i = 0; i < N; i++) {\n"
+"                if (st !== -2 && D.state[i] !== st) continue;\n"
+"                if (pr !== -2 && D.proto[i] !== pr) continue;\n"
+"                if (sm && !(sm[D.remote[i]] || sm[D.proc[i]] || sm[D.exe[i]] || sm[D.risk[i]] || sm[D.state[i]] ||\n"
+"                            D.local[i].toLowerCase().includes(term) || String(D.pid[i]).includes(term))) continue;\n"
+"                view[k++] = i;\n"
+"            }\n"
+"            viewLen = k;\n"
+"            applySort();\n"
+"            viewport.scrollTop = 0;\n"
+"            render();\n"
+"        }\n"
 "\n"
-"                const matchSearch = text.includes(searchTerm);\n"
-"                const matchStatus = !statusValue || status === statusValue;\n"
-"                const matchProtocol = !protocolValue || protocol === protocolValue;\n"
+"        // 表格排序：字符串列先把字符串表排序得到名次，行比较退化为整数比较\n"
+"        const rankCache = {};\n"
+"        function stringRanks() {\n"
+"            if (!rankCache.s) {\n"
+"                const order = Array.from(S.keys()).sort((a, b) => S[a] < S[b] ? -1 : S[a] > S[b] ? 1 : 0);\n"
+"                rankCache.s = new Int32Array(S.length);\n"
+"                order.forEach((si, r) => rankCache.s[si] = r);\n"
+"            }\n"
+"            return rankCache.s;\n"
+"        }\n"
+"        function localRanks() {\n"
+"            if (!rankCache.local) {\n"
+"                const order = Array.from({length: N}, (_, i) => i).sort((a, b) => D.local[a] < D.local[b] ? -1 : D.local[a] > D.local[b] ? 1 : 0);\n"
+"                rankCache.local = new Int32Array(N);\n"
+"                order.forEach((row, r) => rankCache.local[row] = r);\n"
+"            }\n"
+"            return rankCache.local;\n"
+"        }\n"
+"        function sortKey(col) {\n"
+"            const R = col === 2 ? null : stringRanks();\n"
+"            switch (col) {\n"
+"                case 0: return i => D.flags[i];\n"
+"                case 1: return i => R[D.proto[i]];\n"
+"                case 2: { const L = localRanks(); return i => L[i]; }\n"
+"                case 3: return i => R[D.remote[i]];\n"
+"                case 4: return i => R[D.state[i]];\n"
+"                case 5: return i => R[D.proc[i]];\n"
+"                case 6: return i => D.pid[i];\n"
+"                default: return i => R[D.risk[i]];\n"
+"            }\n"
+"        }\n"
+"        function applySort() {\n"
+"            if (sortCol < 0) return;\n"
+"            const key = sortKey(sortCol), dir = sortAsc ? 1 : -1;\n"
+"            const keys = new Float64Array(N);\n"
+"            for (let k = 0; k < viewLen; k++) keys[view[k]] = key(view[k]);\n"
+"            view.subarray(0, viewLen).sort((a, b) => (keys[a] - keys[b]) * dir || a - b);\n"
+"        }\n"
 "\n"
-"                if (matchSearch && matchStatus && matchProtocol) {\n"
-"                    row.style.display = '';\n"
-"                    visibleCount++;\n"
-"                } else {\n"
-"                    row.style.display = 'none';\n"
-"                }\n"
+"        document.querySelectorAll('#connTable th').forEach(th => {\n"
+"            th.addEventListener('click', () => {\n"
+"                const col = th.cellIndex;\n"
+"                sortAsc = (sortCol === col) ? !sortAsc : true;\n"
+"                sortCol = col;\n"
+"                document.querySelectorAll('#connTable th').forEach(h => h.classList.remove('asc', 'desc'));\n"
+"                th.classList.add(sortAsc ? 'asc' : 'desc');\n"
+"                applySort();\n"
+"                render();\n"
 "            });\n"
+"        });\n"
+"\n"
+"        // 虚拟滚动：上下用占位行撑开高度，只生成可视窗口附近的 <tr>\n"
+"        function rowHtml(i) {\n"
+"            const f = D.flags[i], st = S[D.state[i]], remote = S[D.remote[i]];\n"
+"            const icon = !(f & 2) ? '🏠' : (f & 1) ? '⚠️' : (f & 4) ? '🔒' : '🌐';\n"
+"            const cls = st === 'ESTABLISHED' ? 'status-established' : st === 'LISTEN' ? 'status-listen' : 'status-other';\n"
+"            return '<tr' + ((f & 1) ? ' class=\"suspicious\"' : '') + '><td class=\"icon\">' + icon + '</td><td>' + S[D.proto[i]] +\n"
+"                   '</td><td>' + esc(D.local[i]) + '</td><td>' + esc(remote) +\n"
+"                   ' <span class=\"copy-btn\" data-copy=\"' + esc(remote) + '\" title=\"复制 IP\">📋</span></td>' +\n"
+"                   '<td><span class=\"status-badge ' + cls + '\">' + esc(st) + '</span></td><td title=\"' + esc(S[D.exe[i]]) + '\">' +\n"
+"                   esc(S[D.proc[i]]) + '</td><td>' + D.pid[i] + '</td><td>' + (esc(S[D.risk[i]]) || '-') + '</td></tr>';\n"
 "        }\n"
+"        let lastStart = -1, lastEnd = -1;\n"
+"        function render(force) {\n"
+"            const start = Math.max(0, Math.floor(viewport.scrollTop / ROW_H) - OVERSCAN);\n"
+"            const end = Math.min(viewLen, start + Math.ceil(viewport.clientHeight / ROW_H) + 2 * OVERSCAN);\n"
+"            if (force !== false || start !== lastStart || end !== lastEnd) {\n"
+"                let html = '<tr style=\"height:' + (start * ROW_H) + 'px\"></tr>';\n"
+"                for (let k = start; k < end; k++) html += rowHtml(view[k]);\n"
+"                html += '<tr style=\"height:' + ((viewLen - end) * ROW_H) + 'px\"></tr>';\n"
+"                tbody.innerHTML = html;\n"
+"                lastStart = start; lastEnd = end;\n"
+"            }\n"
+"            summary.textContent = '显示 ' + viewLen + ' / ' + N + ' 条连接';\n"
+"        }\n"
+"        let ticking = false;\n"
+"        viewport.addEventListener('scroll', () => {\n"
+"            if (!ticking) { ticking = true; requestAnimationFrame(() => { ticking = false; render(false); }); }\n"
+"        });\n"
+"        window.addEventListener('resize', () => render());\n"
 "\n"
-"        searchInput.addEventListener('input', filterRows);\n"
+"        let debounce = 0;\n"
+"        searchInput.addEventListener('input', () => { clearTimeout(debounce); debounce = setTimeout(filterRows, 120); });\n"
 "        statusFilter.addEventListener('change', filterRows);\n"
 "        protocolFilter.addEventListener('change', filterRows);\n"
 "\n"
-"        // 表格排序\n"
-"        document.querySelectorAll('th').forEach(th => {\n"
-"            th.addEventListener('click', () => {\n"
-"                const column = th.cellIndex;\n"
-"                const rowsArray = Array.from(rows);\n"
-"                const isAscending = th.classList.contains('asc');\n"
-"\n"
-"                rowsArray.sort((a, b) => {\n"
-"                    const aText = a.cells[column].textContent.trim();\n"
-"                    const bText = b.cells[column].textContent.trim();\n"
-"                    return isAscending ? bText.localeCompare(aText) : aText.localeCompare(bText);\n"
-"                });\n"
-"\n"
-"                document.querySelectorAll('th').forEach(h => h.classList.remove('asc', 'desc'));\n"
-"                th.classList.add(isAscending ? 'desc' : 'asc');\n"
-"\n"
-"                const tbody = table.querySelector('tbody');\n"
-"                rowsArray.forEach(row => tbody.appendChild(row));\n"
-"            });\n"
+"        // 复制到剪贴板（事件委托，行是动态生成的）\n"
+"        tbody.addEventListener('click', e => {\n"
+"            const btn = e.target.closest('.copy-btn');\n"
+"            if (btn) navigator.clipboard.writeText(btn.dataset.copy).then(() => console.log('已复制: ' + btn.dataset.copy));\n"
 "        });\n"
-"\n"
-"        // 复制到剪贴板\n"
-"        function copyToClipboard(text) {\n"
-"            navigator.clipboard.writeText(text).then(() => {\n"
-"                console.log('已复制: ' + text);\n"
-"            });\n"
-"        }\n"
+"        render();\n"
 "    </script>\n"
 "</body>\n"
 "</html>\n";
 
-// 转义 HTML 特殊字符
-static void escape_html(const char *src, char *dest, size_t dest_size) {
-    size_t j = 0;
-    for (size_t i = 0; src[i] && j < dest_size - 1; i++) {
-        if (src[i] == '<') {
-            if (j + 4 < dest_size) { strcpy(&dest[j], "&lt;"); j += 4; }
-        } else if (src[i] == '>') {
-            if (j + 4 < dest_size) { strcpy(&dest[j], "&gt;"); j += 4; }
-        } else if (src[i] == '&') {
-            if (j + 5 < dest_size) { strcpy(&dest[j], "&amp;"); j += 5; }
-        } else {
-            dest[j++] = src[i];
-        }
+// 输出一列整数数组："name":[v0,v1,...]
+static void write_int_column(StreamWriter *w, const char *name, const int *vals, int count) {
+    sw_putc(w, '"');
+    sw_puts(w, name);
+    sw_puts(w, "\":[");
+    for (int i = 0; i < count; i++) {
+        if (i) sw_putc(w, ',');
+        sw_int(w, vals[i]);
     }
-    dest[j] = '\0';
+    sw_puts(w, "],\n");
+}
+
+#define HITTERS_EXPORT_ROWS 10
+
+// 热点远端表：估计的平均并发连接数与 Space-Saving 误差上界（一次性导出时只有本次快照的数据）
+static void write_hitters_table(StreamWriter *w, HhMode mode, const char *title) {
+    const HeavyHitter *top[HITTERS_EXPORT_ROWS];
+    int n = heavy_hitters_ranked(mode, top, HITTERS_EXPORT_ROWS);
+    char num[32];
+    sw_puts(w, "        <div><h3>");
+    sw_puts(w, title);
+    sw_puts(w, "</h3><table>\n");
+    sw_puts(w, "            <tr><th style=\"width:50px\">#</th><th>远端</th><th>平均连接数</th><th>误差上界</th><th>占比</th></tr>\n");
+    for (int i = 0; i < n; i++) {
+        sw_puts(w, "            <tr><td>");
+        sw_int(w, i + 1);
+        sw_puts(w, "</td><td>");
+        sw_puts(w, top[i]->label);
+        snprintf(num, sizeof(num), "%.1f", heavy_hitters_avg(top[i]));
+        sw_puts(w, "</td><td>");
+        sw_puts(w, num);
+        snprintf(num, sizeof(num), "%.1f", heavy_hitters_err(top[i]));
+        sw_puts(w, "</td><td>±");
+        sw_puts(w, num);
+        snprintf(num, sizeof(num), "%.1f%%", heavy_hitters_share(top[i]) * 100.0);
+        sw_puts(w, "</td><td>");
+        sw_puts(w, num);
+        sw_puts(w, "</td></tr>\n");
+    }
+    sw_puts(w, "        </table></div>\n");
 }
 
 // 导出 HTML 报告主函数
 int export_html_report(const char *filename, ConnectionInfo *conns, int count) {
-    FILE *fp = fopen(filename, "w");
+    // "-" 与其他格式一致写到标准输出
+    int to_stdout = strcmp(filename, "-") == 0;
+    FILE *fp = to_stdout ? stdout : fopen(filename, "w");
     if (!fp) {
         fprintf(stderr, "错误：无法创建文件 %s\n", filename);
         return -1;
     }
 
-    // 计算统计数据
+    // 计算统计数据（同时为每行填充 risk_reason，后续不再逐行重复判定）
     ConnectionStats stats;
     calculate_stats(conns, count, &stats);
 
+    // 列式数据：字符串列存字符串表下标
+    enum { COL_PROTO, COL_REMOTE, COL_STATE, COL_PROC, COL_EXE, COL_RISK, COL_PID, COL_FLAGS, COL_COUNT };
+    static const char *COL_NAMES[COL_COUNT] = { "proto", "remote", "state", "proc", "exe", "risk", "pid", "flags" };
+    int *cols = malloc(sizeof(int) * (size_t)COL_COUNT * (size_t)(count > 0 ? count : 1));
+    StringTable tab;
+    strtab_init(&tab);
+    if (!cols) {
+        if (!to_stdout) fclose(fp);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        ConnectionInfo *c = &conns[i];
+        int flags = 0;
+        if (c->risk_reason[0]) flags |= 1;
+        if (is_external_connection(c)) flags |= 2;
+        if (strstr(c->remote_addr, ":443") || strstr(c->remote_addr, ":8443")) flags |= 4;
+        cols[COL_PROTO * count + i] = strtab_intern(&tab, c->protocol);
+        cols[COL_REMOTE * count + i] = strtab_intern(&tab, c->remote_addr);
+        cols[COL_STATE * count + i] = strtab_intern(&tab, c->status);
+        cols[COL_PROC * count + i] = strtab_intern(&tab, c->process);
+        cols[COL_EXE * count + i] = strtab_intern(&tab, c->exe_path);
+        cols[COL_RISK * count + i] = strtab_intern(&tab, c->risk_reason);
+        cols[COL_PID * count + i] = c->pid;
+        cols[COL_FLAGS * count + i] = flags;
+    }
+    if (tab.failed) {
+        fprintf(stderr, "错误：内存不足，无法导出 %s\n", filename);
+        free(cols);
+        strtab_free(&tab);
+        if (!to_stdout) fclose(fp);
+        return -1;
+    }
+
     // 获取当前时间
     time_t now = time(NULL);
     struct tm *t = localtime(&now);
     char timestamp[64];
     strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", t);
 
+    StreamWriter *w = malloc(sizeof(StreamWriter));
+    if (!w) {
+        free(cols);
+        strtab_free(&tab);
+        if (!to_stdout) fclose(fp);
+        return -1;
+    }
+    sw_init(w, fp);
+
     // 写入 HTML 头部
-    fprintf(fp, "%s", HTML_HEADER);
-    fprintf(fp, "    <div class=\"timestamp\">生成时间: %s</div>\n", timestamp);
+    sw_puts(w, HTML_HEADER);
+    sw_puts(w, "    <div class=\"timestamp\">生成时间: ");
+    sw_puts(w, timestamp);
+    sw_puts(w, "</div>\n");
 
     // 写入统计看板
-    fprintf(fp, "    <div class=\"dashboard\">\n");
-    fprintf(fp, "        <div class=\"card\"><div class=\"card-label\">总连接数</div><div class=\"card-value\">%d</div></div>\n", stats.total);
-    fprintf(fp, "        <div class=\"card\"><div class=\"card-label\">正在通信</div><div class=\"card-value\">%d</div></div>\n", stats.established);
-    fprintf(fp, "        <div class=\"card\"><div class=\"card-label\">监听中</div><div class=\"card-value\">%d</div></div>\n", stats.listening);
-    fprintf(fp, "        <div class=\"card\"><div class=\"card-label\">可疑连接</div><div class=\"card-value class=\\\"warn\\\">%d</div></div>\n", stats.suspicious);
-    fprintf(fp, "    </div>\n");
+    sw_puts(w, "    <div class=\"dashboard\">\n");
+    sw_puts(w, "        <div class=\"card\"><div class=\"card-label\">总连接数</div><div class=\"card-value\">");
+    sw_int(w, stats.total);
+    sw_puts(w, "</div></div>\n        <div class=\"card\"><div class=\"card-label\">正在通信</div><div class=\"card-value\">");
+    sw_int(w, stats.established);
+    sw_puts(w, "</div></div>\n        <div class=\"card\"><div class=\"card-label\">监听中</div><div class=\"card-value\">");
+    sw_int(w, stats.listening);
+    sw_puts(w, "</div></div>\n        <div class=\"card\"><div class=\"card-label\">可疑连接</div><div class=\"card-value warn\">");
+    sw_int(w, stats.suspicious);
+    sw_puts(w, "</div></div>\n    </div>\n");
+
+    // 写入热点远端
+    sw_puts(w, "    <div class=\"hitters\">\n");
+    write_hitters_table(w, HH_BY_HOST, "热点远端主机");
+    write_hitters_table(w, HH_BY_PREFIX, "热点远端网段（/24、/64）");
+    sw_puts(w, "    </div>\n");
 
     // 写入过滤器
-    fprintf(fp, "    <div class=\"filters\">\n");
-    fprintf(fp, "        <input type=\"text\" id=\"search\" placeholder=\"🔍 搜索进程、IP、端口...\">\n");
-    fprintf(fp, "        <select id=\"statusFilter\"><option value=\"\">所有状态</option><option>ESTABLISHED</option><option>LISTEN</option><option>TIME_WAIT</option></select>\n");
-    fprintf(fp, "        <select id=\"protocolFilter\"><option value=\"\">所有协议</option><option>TCP</option><option>UDP</option></select>\n");
-    fprintf(fp, "    </div>\n");
+    sw_puts(w, "    <div class=\"filters\">\n");
+    sw_puts(w, "        <input type=\"text\" id=\"search\" placeholder=\"🔍 搜索进程、IP、端口...\">\n");
+    sw_puts(w, "        <select id=\"statusFilter\"><option value=\"\">所有状态</option></select>\n");
+    sw_puts(w, "        <select id=\"protocolFilter\"><option value=\"\">所有协议</option><option>TCP</option><option>UDP</option></select>\n");
+    sw_puts(w, "    </div>\n");
 
-    // 写入表格
-    fprintf(fp, "    <table id=\"connTable\">\n");
-    fprintf(fp, "        <thead>\n");
-    fprintf(fp, "            <tr><th>图标</th><th>协议</th><th>本地地址</th><th>远端地址</th><th>状态</th><th>进程</th><th>操作</th></tr>\n");
-    fprintf(fp, "        </thead>\n");
-    fprintf(fp, "        <tbody>\n");
+    // 写入表格骨架（行由脚本按可视区域生成）
+    sw_puts(w, "    <div class=\"summary\" id=\"summary\"></div>\n");
+    sw_puts(w, "    <div class=\"viewport\" id=\"viewport\">\n");
+    sw_puts(w, "    <table id=\"connTable\">\n");
+    sw_puts(w, "        <thead>\n");
+    sw_puts(w, "            <tr><th style=\"width:60px\">图标</th><th style=\"width:70px\">协议</th><th>本地地址</th><th>远端地址</th>"
+               "<th style=\"width:140px\">状态</th><th>进程</th><th style=\"width:90px\">PID</th><th style=\"width:120px\">风险</th></tr>\n");
+    sw_puts(w, "        </thead>\n");
+    sw_puts(w, "        <tbody></tbody>\n");
+    sw_puts(w, "    </table>\n");
+    sw_puts(w, "    </div>\n");
+    sw_puts(w, "</div>\n");
 
-    // 写入连接数据
-    char escaped[512];
+    // 写入列式 JSON 数据
+    sw_puts(w, "    <script>\n    const NCM_DATA = {\"v\":1,\"n\":");
+    sw_int(w, count);
+    sw_puts(w, ",\n\"s\":[");
+    for (int i = 0; i < tab.count; i++) {
+        if (i) sw_putc(w, ',');
+        sw_json_str(w, tab.strs[i]);
+    }
+    sw_puts(w, "],\n\"local\":[");
     for (int i = 0; i < count; i++) {
-        ConnectionInfo *c = &conns[i];
-        int suspicious = is_suspicious(c);
-        int is_ext = is_external_connection(c);
-        
-        // 确定图标
-        const char *icon = "🏠"; // 本地
-        if (is_ext) {
-            if (suspicious) icon = "⚠️";
-            else if (strstr(c->remote_addr, ":443") || strstr(c->remote_addr, ":8443")) icon = "🔒";
-            else icon = "🌐";
-        }
-
-        // 确定状态样式
-        const char *status_class = "status-other";
-        if (c->status_enum == CONN_STATUS_ESTABLISHED) status_class = "status-established";
-        else if (c->status_enum == CONN_STATUS_LISTEN) status_class = "status-listen";
-
-        fprintf(fp, "            <tr %s data-status=\"%s\" data-protocol=\"%s\">\n",
-                suspicious ? "class=\"suspicious\"" : "",
-                c->status,
-                c->protocol);
-        fprintf(fp, "                <td class=\"icon\">%s</td>\n", icon);
-        fprintf(fp, "                <td>%s</td>\n", c->protocol);
-        
-        escape_html(c->local_addr, escaped, sizeof(escaped));
-        fprintf(fp, "                <td>%s</td>\n", escaped);
-        
-        escape_html(c->remote_addr, escaped, sizeof(escaped));
-        fprintf(fp, "                <td>%s <span class=\"copy-btn\" onclick=\"copyToClipboard('%s')\" title=\"复制 IP\">📋</span></td>\n", 
-                escaped, escaped);
-        
-        fprintf(fp, "                <td><span class=\"status-badge %s\">%s</span></td>\n", status_class, c->status);
-        
-        escape_html(c->process, escaped, sizeof(escaped));
-        fprintf(fp, "                <td>%s</td>\n", escaped);
-        fprintf(fp, "                <td>-</td>\n");
-        fprintf(fp, "            </tr>\n");
+        if (i) sw_putc(w, ',');
+        sw_json_str(w, conns[i].local_addr);
     }
-
-    fprintf(fp, "        </tbody>\n");
-    fprintf(fp, "    </table>\n");
-    fprintf(fp, "</div>\n");
+    sw_puts(w, "],\n");
+    for (int col = 0; col < COL_COUNT; col++) {
+        write_int_column(w, COL_NAMES[col], &cols[col * count], count);
+    }
+    sw_puts(w, "\"end\":0};\n    </script>\n");
 
     // 写入 HTML 尾部
-    fprintf(fp, "%s", HTML_FOOTER);
+    sw_puts(w, HTML_FOOTER);
 
-    fclose(fp);
+    int rc = sw_flush(w);
+    free(w);
+    free(cols);
+    strtab_free(&tab);
+    if (!to_stdout && fclose(fp) != 0) rc = -1;
+    if (rc != 0) {
+        fprintf(stderr, "错误：写入文件 %s 失败\n", filename);
+        return -1;
+    }
+    if (to_stdout) return 0; // 标准输出只含报告本身
     printf("✅ HTML 报告已生成: %s\n", filename);
     printf("   包含 %d 个连接，其中 %d 个可疑\n", count, stats.suspicious);
     return 0;
@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include <string.h>
+#include "lib/arena.h"
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_CAP 4096
+
+struct ArenaSpill {
+    ArenaSpill *next;
+    size_t size;
+};
+
+#define SPILL_HEADER ((sizeof(ArenaSpill) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static void note_peak(Arena *a) {
+    if (a->used + a->spilled > a->peak) a->peak = a->used + a->spilled;
+}
+
+static void *spill_alloc(Arena *a, size_t size) {
+    ArenaSpill *s = malloc(SPILL_HEADER + size);
+    if (!s) return NULL;
+    s->next = a->spill;
+    s->size = size;
+    a->spill = s;
+    a->spilled += size;
+    note_peak(a);
+    return (unsigned char *)s + SPILL_HEADER;
+}
+
+void *arena_alloc(Arena *a, size_t size) {
+    size = align_up(size ? size : 1);
+    if (size <= a->cap - a->used) {
+        void *p = a->base + a->used;
+        a->top = a->used;
+        a->used += size;
+        note_peak(a);
+        return p;
+    }
+    return spill_alloc(a, size);
+}
+
+void *arena_calloc(Arena *a, size_t size) {
+    void *p = arena_alloc(a, size);
+    if (p) memset(p, 0, size);
+    return p;
+}
+
+void *arena_grow(Arena *a, void *p, size_t old_size, size_t new_size) {
+    if (!p) return arena_alloc(a, new_size);
+    new_size = align_up(new_size ? new_size : 1);
+    if (new_size <= align_up(old_size)) return p;
+    unsigned char *q = p;
+
+    // 主块最后一次分配：放得下就原地扩展，放不下就退回这段空间再搬到溢出块
+    if (a->base && q == a->base + a->top && a->top < a->used) {
+        if (new_size <= a->cap - a->top) {
+            a->used = a->top + new_size;
+            note_peak(a);
+            return p;
+        }
+        a->used = a->top;
+        void *n = spill_alloc(a, new_size);
+        if (n) memmove(n, p, old_size);
+        return n;
+    }
+
+    // 最近的溢出块直接 realloc
+    if (a->spill && q == (unsigned char *)a->spill + SPILL_HEADER) {
+        ArenaSpill *s = realloc(a->spill, SPILL_HEADER + new_size);
+        if (!s) return NULL;
+        a->spilled += new_size - s->size;
+        s->size = new_size;
+        a->spill = s;
+        note_peak(a);
+        return (unsigned char *)s + SPILL_HEADER;
+    }
+
+    void *n = arena_alloc(a, new_size);
+    if (n) memcpy(n, p, old_size);
+    return n;
+}
+
+void arena_reset(Arena *a) {
+    while (a->spill) {
+        ArenaSpill *next = a->spill->next;
+        free(a->spill);
+        a->spill = next;
+    }
+    // 本轮溢出过：按高水位加 1/8 余量重建主块，下一轮起全部落在主块内；
+    // 允许缩小时，尖峰过后长期用不到的主块按近期的高水位缩回，不让一次尖峰的大小保留到进程退出
+    int rebuild = 0;
+    size_t want = a->peak;
+    if (a->peak > a->cap) {
+        rebuild = 1;
+        a->low_rounds = 0;
+    } else if (a->shrink_after > 0 && a->cap > ARENA_MIN_CAP && a->peak < a->cap / 4) {
+        if (a->low_rounds == 0 || a->peak > a->low_peak) a->low_peak = a->peak;
+        if (++a->low_rounds >= a->shrink_after) {
+            rebuild = 1;
+            want = a->low_peak;
+            a->low_rounds = 0;
+        }
+    } else {
+        a->low_rounds = 0;
+    }
+    if (rebuild) {
+        size_t cap = align_up(want + want / 8);
+        if (cap < ARENA_MIN_CAP) cap = ARENA_MIN_CAP;
+        unsigned char *nb = malloc(cap);
+        if (nb) {
+            free(a->base);
+            a->base = nb;
+            a->cap = cap;
+        }
+    }
+    a->used = 0;
+    a->top = 0;
+    a->spilled = 0;
+    a->peak = 0;
+}
+
+void arena_free(Arena *a) {
+    int shrink_after = a->shrink_after;
+    a->shrink_after = 0;
+    a->peak = 0;
+    arena_reset(a);
+    free(a->base);
+    memset(a, 0, sizeof(*a));
+    a->shrink_after = shrink_after;
+}
@@ -0,0 +1,40 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// 区域分配器：按轮（一次扫描 / 一帧 / 一次统计）分配，轮末整体复位，不逐个释放
+// 主块放不下的分配临时走堆（溢出块），复位时释放溢出块并把主块扩到本轮的高水位，
+// 因此负载不再增长后每轮都落在主块内，不再调用 malloc。
+// 设置了 shrink_after 的区域在一次尖峰把主块撑大后，连续 shrink_after 轮高水位都不到容量的 1/4 时，
+// 按这些轮中的最大高水位缩回（用量随视图切换大幅波动的区域不设置，避免反复重建）
+#define ARENA_SHRINK_ROUNDS 32
+
+typedef struct ArenaSpill ArenaSpill;
+
+typedef struct Arena {
+    unsigned char *base;
+    size_t cap;
+    size_t used;
+    size_t top;          // 主块中最近一次分配的偏移（arena_grow 可原地扩展）
+    size_t spilled;      // 溢出块当前字节数
+    size_t peak;         // 本轮 used + spilled 的最大值
+    int shrink_after;    // 0 为主块只增不减
+    size_t low_peak;     // 连续低水位各轮中的最大高水位
+    int low_rounds;      // 高水位连续低于容量 1/4 的轮数
+    ArenaSpill *spill;
+} Arena;
+
+// 16 字节对齐；失败返回 NULL。size 为 0 时按 1 字节分配
+void *arena_alloc(Arena *a, size_t size);
+void *arena_calloc(Arena *a, size_t size);
+
+// 把 p（old_size 字节，来自同一 arena 的本轮分配）扩到 new_size，内容保留；
+// p 是主块最后一次分配或最近的溢出块时原地扩展，否则复制到新位置。p 为 NULL 等同 arena_alloc
+void *arena_grow(Arena *a, void *p, size_t old_size, size_t new_size);
+
+// 结束本轮：之前的分配全部失效
+void arena_reset(Arena *a);
+void arena_free(Arena *a);
+
+#endif // ARENA_H
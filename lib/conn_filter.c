@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/conn_filter.h"
+
+void conn_filter_init(ConnFilter *f) {
+    memset(f, 0, sizeof(*f));
+    f->pid = -1;
+    f->port = -1;
+}
+
+static int parse_long(const char *s, long min, long max, long *out) {
+    char *end = NULL;
+    long v = strtol(s, &end, 10);
+    if (!end || end == s || *end != '\0' || v < min || v > max) return -1;
+    *out = v;
+    return 0;
+}
+
+static int parse_cidr(const char *s, uint32_t *net, uint32_t *mask) {
+    unsigned int a, b, c, d, len = 32;
+    char tail;
+    int n = sscanf(s, "%u.%u.%u.%u/%u%c", &a, &b, &c, &d, &len, &tail);
+    if (n != 4 && n != 5) return -1;
+    if (a > 255 || b > 255 || c > 255 || d > 255 || len > 32) return -1;
+    *mask = len == 0 ? 0 : 0xFFFFFFFFu << (32 - len);
+    *net = ((a << 24) | (b << 16) | (c << 8) | d) & *mask;
+    return 0;
+}
+
+int conn_filter_set(ConnFilter *f, const char *key, const char *value) {
+    long v;
+    if (strcmp(key, "pid") == 0) {
+        if (parse_long(value, 0, 0x7FFFFFFF, &v) != 0) return -1;
+        f->pid = (int32_t)v;
+    } else if (strcmp(key, "port") == 0) {
+        if (parse_long(value, 0, 65535, &v) != 0) return -1;
+        f->port = (int)v;
+    } else if (strcmp(key, "state") == 0) {
+        // 逗号分隔的多个状态
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%s", value);
+        for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+            ConnectionStatus st = conn_status_from_name(tok);
+            if (st == CONN_STATUS_UNKNOWN) return -1;
+            f->state_mask |= 1u << st;
+        }
+    } else if (strcmp(key, "cidr") == 0) {
+        if (parse_cidr(value, &f->cidr_net, &f->cidr_mask) != 0) return -1;
+        f->has_cidr = 1;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int conn_filter_is_empty(const ConnFilter *f) {
+    return f->pid < 0 && f->port < 0 && f->state_mask == 0 && !f->has_cidr;
+}
+
+int conn_filter_match(const ConnFilter *f, const NcmWireRecord *r) {
+    if (f->pid >= 0 && r->pid != f->pid) return 0;
+    if (f->port >= 0 && r->local_port != f->port && r->remote_port != f->port) return 0;
+    if (f->state_mask && !(f->state_mask & (1u << r->state))) return 0;
+    if (f->has_cidr) {
+        const unsigned char *o = (const unsigned char *)&r->remote_ip;
+        uint32_t ip = ((uint32_t)o[0] << 24) | ((uint32_t)o[1] << 16) | ((uint32_t)o[2] << 8) | o[3];
+        if ((ip & f->cidr_mask) != f->cidr_net) return 0;
+    }
+    return 1;
+}
+
+void conn_to_wire(const ConnectionInfo *c, NcmWireRecord *r) {
+    memset(r, 0, sizeof(*r));
+    r->proto = (strcmp(c->protocol, "UDP") == 0) ? NCM_WIRE_PROTO_UDP : NCM_WIRE_PROTO_TCP;
+    r->state = (uint8_t)c->status_enum;
+    parse_ipv4_endpoint(c->local_addr, &r->local_ip, &r->local_port);
+    parse_ipv4_endpoint(c->remote_addr, &r->remote_ip, &r->remote_port);
+    if (c->risk_reason[0]) r->flags |= NCM_WIRE_FLAG_SUSPICIOUS;
+    r->pid = c->pid;
+    snprintf(r->process, sizeof(r->process), "%.*s", (int)sizeof(r->process) - 1, c->process); // 线上格式只保留前 15 字节
+}
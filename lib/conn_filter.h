@@ -0,0 +1,30 @@
+#ifndef CONN_FILTER_H
+#define CONN_FILTER_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+#include "lib/ncm_wire.h"
+
+// 连接过滤条件（各条件之间为"与"关系）
+typedef struct ConnFilter {
+    int32_t pid;          // -1 表示不限
+    int port;             // -1 表示不限；本地或远端端口任一匹配
+    uint32_t state_mask;  // 0 表示不限；bit i 对应 ConnectionStatus i
+    int has_cidr;         // 远端地址 CIDR
+    uint32_t cidr_net;    // 主机字节序
+    uint32_t cidr_mask;
+} ConnFilter;
+
+void conn_filter_init(ConnFilter *f);
+
+// 设置单个条件：pid=N / port=N / state=S[,S...] / cidr=A.B.C.D[/len]
+// 成功返回 0，键或值非法返回 -1
+int conn_filter_set(ConnFilter *f, const char *key, const char *value);
+
+int conn_filter_is_empty(const ConnFilter *f);
+int conn_filter_match(const ConnFilter *f, const NcmWireRecord *r);
+
+// 把连接转换为定长线上记录
+void conn_to_wire(const ConnectionInfo *c, NcmWireRecord *r);
+
+#endif // CONN_FILTER_H
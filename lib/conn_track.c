@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/conn_track.h"
+
+typedef struct {
+    uint64_t inode;
+    uint32_t local_ip;
+    uint32_t remote_ip;
+    uint16_t local_port;
+    uint16_t remote_port;
+    uint8_t proto;
+    uint8_t state;
+    uint8_t used;
+    uint8_t taken;         // 本轮已被当前扫描继承，搬运旧表时跳过
+    uint32_t last_gen;     // 最近一次出现的扫描轮次
+    int64_t first_seen;
+    int64_t state_since;
+    int64_t counters_ms;   // 下列计数的采样时刻（毫秒），0 表示尚无样本
+    uint64_t bytes_acked;
+    uint64_t bytes_received;
+    uint32_t total_retrans;
+} TrackEntry;
+
+// 开放寻址表，容量为 2 的幂
+typedef struct {
+    TrackEntry *slots;
+    size_t cap;
+    size_t count;
+} TrackTable;
+
+// 双表交替：每轮把仍存活的条目从旧表搬入新表，淘汰即"不搬"，无需墓碑
+static TrackTable table_a, table_b;
+static TrackTable *cur = &table_a, *old = &table_b;
+static uint32_t generation = 0;
+static int last_churn = 0;
+
+static int stuck_threshold[CONN_STATUS_COUNT] = {
+    [CONN_STATUS_SYN_SENT] = 30,
+    [CONN_STATUS_CLOSE_WAIT] = 60,
+    [CONN_STATUS_FIN_WAIT2] = 60,
+};
+
+void conn_track_set_threshold(ConnectionStatus status, int seconds) {
+    if ((int)status < 0 || status >= CONN_STATUS_COUNT) return;
+    stuck_threshold[status] = seconds > 0 ? seconds : 0;
+}
+
+int conn_track_parse_threshold(const char *spec) {
+    const char *eq = strchr(spec, '=');
+    if (!eq || eq == spec || (size_t)(eq - spec) >= 32) return -1;
+    char name[32];
+    memcpy(name, spec, (size_t)(eq - spec));
+    name[eq - spec] = '\0';
+    ConnectionStatus st = conn_status_from_name(name);
+    if (st == CONN_STATUS_UNKNOWN) return -1;
+    char *end;
+    long sec = strtol(eq + 1, &end, 10);
+    if (end == eq + 1 || *end != '\0' || sec < 0 || sec > 86400 * 365) return -1;
+    conn_track_set_threshold(st, (int)sec);
+    return 0;
+}
+
+// 按 64 位字乘法混合（逐字节 FNV 在每轮两次查表的热路径上偏慢）
+static uint32_t hash_key(const TrackEntry *k) {
+    uint64_t h = ((uint64_t)k->local_ip << 32 | k->remote_ip) * 0x9E3779B97F4A7C15ull;
+    h ^= ((uint64_t)k->local_port << 24 | (uint64_t)k->remote_port << 8 | k->proto) * 0xC2B2AE3D27D4EB4Full;
+    h ^= k->inode * 0x165667B19E3779F9ull;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static int key_equal(const TrackEntry *a, const TrackEntry *b) {
+    return a->inode == b->inode && a->local_ip == b->local_ip && a->remote_ip == b->remote_ip &&
+           a->local_port == b->local_port && a->remote_port == b->remote_port && a->proto == b->proto;
+}
+
+// 查找键对应的槽位；不存在时返回应插入的空槽
+static TrackEntry *table_slot(TrackTable *t, const TrackEntry *key) {
+    size_t mask = t->cap - 1;
+    size_t pos = hash_key(key) & mask;
+    while (t->slots[pos].used && !key_equal(&t->slots[pos], key)) pos = (pos + 1) & mask;
+    return &t->slots[pos];
+}
+
+// 保证表容量不低于 2 倍元素数并清空；失败返回 -1（保留原表）
+static int table_reset(TrackTable *t, size_t entries) {
+    size_t need = 1024;
+    while (need < entries * 2) need <<= 1;
+    if (need > t->cap) {
+        TrackEntry *slots = malloc(sizeof(TrackEntry) * need);
+        if (!slots) return -1;
+        free(t->slots);
+        t->slots = slots;
+        t->cap = need;
+    }
+    memset(t->slots, 0, sizeof(TrackEntry) * t->cap);
+    t->count = 0;
+    return 0;
+}
+
+static void make_key(const ConnectionInfo *c, TrackEntry *k) {
+    memset(k, 0, sizeof(*k));
+    k->inode = c->inode;
+    k->proto = (strcmp(c->protocol, "UDP") == 0) ? 17 : 6;
+    parse_ipv4_endpoint(c->local_addr, &k->local_ip, &k->local_port);
+    parse_ipv4_endpoint(c->remote_addr, &k->remote_ip, &k->remote_port);
+}
+
+// 与上一轮样本比较计算收发速率，并记录本轮样本
+static void update_rates(TrackEntry *e, TcpDiag *t, int64_t now_ms) {
+    if (!t->valid) return;
+    int64_t dt = now_ms - e->counters_ms;
+    if (e->counters_ms > 0 && dt > 0 && t->bytes_acked >= e->bytes_acked && t->bytes_received >= e->bytes_received) {
+        t->tx_rate = (double)(t->bytes_acked - e->bytes_acked) * 1000.0 / (double)dt;
+        t->rx_rate = (double)(t->bytes_received - e->bytes_received) * 1000.0 / (double)dt;
+        if (t->total_retrans >= e->total_retrans) t->retrans_rate = (double)(t->total_retrans - e->total_retrans) * 1000.0 / (double)dt;
+    }
+    e->counters_ms = now_ms;
+    e->bytes_acked = t->bytes_acked;
+    e->bytes_received = t->bytes_received;
+    e->total_retrans = t->total_retrans;
+}
+
+int conn_track_update(ConnectionInfo *conns, int count, int64_t now_ms) {
+    int64_t now = now_ms / 1000;
+    // 旧表中的条目最多全部被搬入新表
+    if (table_reset(cur, (size_t)count + old->count) != 0) return 0;
+    generation++;
+
+    int stuck = 0;
+    int churn = 0;
+    for (int i = 0; i < count; i++) {
+        ConnectionInfo *c = &conns[i];
+        TrackEntry key;
+        make_key(c, &key);
+        TrackEntry *e = table_slot(cur, &key);
+        if (!e->used) {
+            TrackEntry *prev = old->cap ? table_slot(old, &key) : NULL;
+            *e = key;
+            e->used = 1;
+            cur->count++;
+            e->state = (uint8_t)c->status_enum;
+            if (prev && prev->used && !prev->taken) {
+                prev->taken = 1;
+                e->first_seen = prev->first_seen;
+                e->state_since = (prev->state == e->state) ? prev->state_since : now;
+                if (prev->state != e->state) churn++;
+                e->counters_ms = prev->counters_ms;
+                e->bytes_acked = prev->bytes_acked;
+                e->bytes_received = prev->bytes_received;
+                e->total_retrans = prev->total_retrans;
+            } else {
+                e->first_seen = now;
+                e->state_since = now;
+                churn++;
+            }
+        }
+        e->last_gen = generation;
+        update_rates(e, &c->tcp, now_ms);
+        c->first_seen = e->first_seen;
+        c->state_since = e->state_since;
+
+        int limit = ((int)c->status_enum >= 0 && c->status_enum < CONN_STATUS_COUNT) ? stuck_threshold[c->status_enum] : 0;
+        if (limit > 0 && now - c->state_since >= limit) {
+            stuck++;
+            if (c->risk_reason[0] == '\0') strcpy(c->risk_reason, "Stuck");
+        }
+    }
+
+    // 本轮缺席但仍在宽限期内的条目原样保留
+    for (size_t i = 0; i < old->cap; i++) {
+        TrackEntry *prev = &old->slots[i];
+        if (!prev->used || prev->taken) continue;
+        if (prev->last_gen + 1 == generation) churn++; // 上一轮还在，本轮消失
+        if (prev->last_gen + CONN_TRACK_GRACE_GENS < generation) continue;
+        TrackEntry *e = table_slot(cur, prev);
+        if (e->used) continue;
+        *e = *prev;
+        cur->count++;
+    }
+
+    // 首轮所有连接都是"新"的，不算变化
+    last_churn = generation > 1 ? churn : 0;
+
+    TrackTable *tmp = old;
+    old = cur;
+    cur = tmp;
+    return stuck;
+}
+
+int conn_track_churn(void) {
+    return last_churn;
+}
+
+void conn_track_format_age(int64_t seconds, char *buf, size_t size) {
+    if (seconds < 0) snprintf(buf, size, "-");
+    else if (seconds < 60) snprintf(buf, size, "%llds", (long long)seconds);
+    else if (seconds < 3600) snprintf(buf, size, "%lldm", (long long)(seconds / 60));
+    else if (seconds < 86400) snprintf(buf, size, "%lldh", (long long)(seconds / 3600));
+    else snprintf(buf, size, "%lldd", (long long)(seconds / 86400));
+}
+
+void conn_track_free(void) {
+    free(table_a.slots);
+    free(table_b.slots);
+    memset(&table_a, 0, sizeof(table_a));
+    memset(&table_b, 0, sizeof(table_b));
+    generation = 0;
+    last_churn = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef CONN_TRACK_H
+#define CONN_TRACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 连接生命周期跟踪：以五元组 + inode 为键跨扫描保存首次出现与进入当前状态的时间
+// 每轮 O(N) 维护，表只在连接数增长时扩容，不做逐行分配
+
+// 连续缺席超过该轮数的连接才从表中淘汰（/proc 读取非原子，偶发漏行不应重置年龄）
+#define CONN_TRACK_GRACE_GENS 2
+
+// 设置某状态的滞留告警阈值（秒），0 表示不告警
+// 默认：SYN_SENT 30 秒，CLOSE_WAIT 60 秒，FIN_WAIT2 60 秒
+void conn_track_set_threshold(ConnectionStatus status, int seconds);
+
+// 解析命令行 "STATE=SECONDS"（如 "CLOSE_WAIT=120"），成功返回 0
+int conn_track_parse_threshold(const char *spec);
+
+// 每轮扫描后调用（now_ms 为 Unix 毫秒）：回填 first_seen / state_since，
+// 若本轮带有 tcp_info 计数则与上一轮同一连接比较得出 tcp.tx_rate / rx_rate / retrans_rate，
+// 滞留超阈值且无其他风险的行标记为 "Stuck"；返回滞留连接数
+int conn_track_update(ConnectionInfo *conns, int count, int64_t now_ms);
+
+// 最近一轮相对上一轮的变化行数：新出现 + 状态迁移 + 消失（首轮为 0），供扫描调度判断连接变化快慢
+int conn_track_churn(void);
+
+// 把秒数格式化为 "42s" / "5m" / "3h" / "2d"，未跟踪时输出 "-"
+void conn_track_format_age(int64_t seconds, char *buf, size_t size);
+
+void conn_track_free(void);
+
+#endif // CONN_TRACK_H
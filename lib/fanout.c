@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lib/fanout.h"
+
+#define INDEX_CAP (FANOUT_MAX_PROCS * 2)
+
+static FanOutProc procs[FANOUT_MAX_PROCS];
+static int proc_count = 0;
+static uint32_t generation = 0;
+static uint32_t epoch = 0;
+
+// pid -> procs[] 下标的开放寻址索引，-1 为空槽；淘汰或替换槽位后重建
+static int slots[INDEX_CAP];
+static int index_ready = 0;
+
+// 本轮的监听端口位图：本地端口在其中的连接是入站连接，不计入扇出
+static uint8_t listen_ports[65536 / 8];
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t hash_bytes(const char *s, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ull;
+    }
+    return mix64(h);
+}
+
+// 高 FANOUT_HLL_BITS 位选寄存器，其余位的前导零个数 + 1 为秩，寄存器保留最大秩
+static void hll_add(uint8_t *reg, uint64_t h) {
+    int idx = (int)(h >> (64 - FANOUT_HLL_BITS));
+    uint64_t w = h << FANOUT_HLL_BITS;
+    uint8_t rank = 1;
+    while (rank <= 64 - FANOUT_HLL_BITS && !(w & 0x8000000000000000ull)) {
+        w <<= 1;
+        rank++;
+    }
+    if (rank > reg[idx]) reg[idx] = rank;
+}
+
+// 两份草图并集的基数估计；小基数时改用线性计数
+static int hll_estimate(const uint8_t *a, const uint8_t *b) {
+    double sum = 0;
+    int zeros = 0;
+    for (int i = 0; i < FANOUT_HLL_M; i++) {
+        uint8_t r = a[i] > b[i] ? a[i] : b[i];
+        sum += ldexp(1.0, -r);
+        if (r == 0) zeros++;
+    }
+    double m = FANOUT_HLL_M;
+    double e = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+    if (e <= 2.5 * m && zeros > 0) e = m * log(m / zeros);
+    return (int)(e + 0.5);
+}
+
+static uint32_t pid_hash(int32_t pid) {
+    return (uint32_t)pid * 2654435761u;
+}
+
+static void index_rebuild(void) {
+    memset(slots, 0xff, sizeof(slots));
+    for (int i = 0; i < proc_count; i++) {
+        uint32_t s = pid_hash(procs[i].pid) & (INDEX_CAP - 1);
+        while (slots[s] >= 0) s = (s + 1) & (INDEX_CAP - 1);
+        slots[s] = i;
+    }
+    index_ready = 1;
+}
+
+static int find_proc(int32_t pid) {
+    if (!index_ready) return -1;
+    uint32_t s = pid_hash(pid) & (INDEX_CAP - 1);
+    while (slots[s] >= 0) {
+        if (procs[slots[s]].pid == pid) return slots[s];
+        s = (s + 1) & (INDEX_CAP - 1);
+    }
+    return -1;
+}
+
+static void reset_proc(FanOutProc *p, const ConnectionInfo *c) {
+    memset(p, 0, sizeof(*p));
+    p->pid = c->pid;
+    snprintf(p->process, sizeof(p->process), "%.*s", (int)sizeof(p->process) - 1, c->process);
+    // 启动后第一轮只建立基线、不标记；之后才出现的进程基线为 0，首轮即按绝对门限判定（新起的扫描器）
+    p->ip_base = generation <= 1 ? -1 : 0;
+    p->port_base = p->ip_base;
+}
+
+// 取得（必要时登记）本轮出现的进程；表满时替换本轮尚未出现、最久未出现的进程，都出现过则放弃
+static FanOutProc *touch_proc(const ConnectionInfo *c) {
+    int idx = find_proc(c->pid);
+    if (idx >= 0) {
+        FanOutProc *p = &procs[idx];
+        // pid 被复用：进程名变了就从头开始
+        if (strncmp(p->process, c->process, sizeof(p->process) - 1) != 0) reset_proc(p, c);
+        p->last_gen = generation;
+        return p;
+    }
+    if (proc_count < FANOUT_MAX_PROCS) {
+        idx = proc_count++;
+    } else {
+        for (int i = 0; i < proc_count; i++) {
+            if (procs[i].last_gen == generation) continue;
+            if (idx < 0 || procs[i].last_gen < procs[idx].last_gen) idx = i;
+        }
+        if (idx < 0) return NULL;
+    }
+    reset_proc(&procs[idx], c);
+    procs[idx].last_gen = generation;
+    index_rebuild();
+    return &procs[idx];
+}
+
+// 远端 "ip:port"：端口为最后一个冒号之后的部分，端口为 0 或无法解析（未连接的 UDP 等）时返回 -1
+static int split_remote(const char *addr, size_t *ip_len, uint16_t *port) {
+    const char *colon = strrchr(addr, ':');
+    if (!colon || colon == addr) return -1;
+    char *end;
+    long v = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || v <= 0 || v > 65535) return -1;
+    *ip_len = (size_t)(colon - addr);
+    *port = (uint16_t)v;
+    return 0;
+}
+
+static int local_port(const char *addr) {
+    const char *colon = strrchr(addr, ':');
+    if (!colon) return -1;
+    char *end;
+    long v = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || v < 0 || v > 65535) return -1;
+    return (int)v;
+}
+
+// 与基线比较得出标记，再把本轮估计并入基线
+static int judge(int est, double *base) {
+    if (*base < 0) {
+        *base = est;
+        return 0;
+    }
+    int jumped = est >= FANOUT_MIN_DISTINCT && est >= FANOUT_JUMP * *base;
+    *base += FANOUT_BASE_ALPHA * (est - *base);
+    return jumped;
+}
+
+int fanout_update(const ConnectionInfo *conns, int count) {
+    if (!index_ready) index_rebuild();
+    generation++;
+
+    // 纪元轮换：清空即将成为“当前”的那份草图（上一纪元的内容保留到下一次轮换）
+    if (generation % FANOUT_EPOCH_SCANS == 0) {
+        epoch++;
+        int cur = epoch & 1;
+        for (int i = 0; i < proc_count; i++) {
+            memset(procs[i].ips[cur], 0, FANOUT_HLL_M);
+            memset(procs[i].ports[cur], 0, FANOUT_HLL_M);
+        }
+    }
+    int cur = epoch & 1;
+
+    memset(listen_ports, 0, sizeof(listen_ports));
+    for (int i = 0; i < count; i++) {
+        if (conns[i].status_enum != CONN_STATUS_LISTEN) continue;
+        int lp = local_port(conns[i].local_addr);
+        if (lp >= 0) listen_ports[lp >> 3] |= (uint8_t)(1u << (lp & 7));
+    }
+
+    // 一次遍历：出站连接的远端 IP 与端口分别加入所属进程的当前草图（折叠行的成员远端相同，计一次即可）
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        if (c->pid <= 0 || c->status_enum == CONN_STATUS_LISTEN) continue;
+        size_t ip_len;
+        uint16_t rport;
+        if (split_remote(c->remote_addr, &ip_len, &rport) != 0) continue;
+        int lp = local_port(c->local_addr);
+        if (lp >= 0 && (listen_ports[lp >> 3] & (1u << (lp & 7)))) continue;
+        FanOutProc *p = touch_proc(c);
+        if (!p) continue;
+        hll_add(p->ips[cur], hash_bytes(c->remote_addr, ip_len));
+        hll_add(p->ports[cur], mix64(0x9e3779b97f4a7c15ull + rport));
+    }
+
+    // 本轮出现的进程估计基数并判定；淘汰连续缺席的进程
+    int flagged = 0, kept = 0;
+    for (int i = 0; i < proc_count; i++) {
+        FanOutProc *p = &procs[i];
+        if (generation - p->last_gen > FANOUT_GRACE) continue;
+        if (p->last_gen == generation) {
+            p->ip_est = hll_estimate(p->ips[0], p->ips[1]);
+            p->port_est = hll_estimate(p->ports[0], p->ports[1]);
+            p->flags = 0;
+            if (judge(p->ip_est, &p->ip_base)) p->flags |= FANOUT_FLAG_IPS;
+            if (judge(p->port_est, &p->port_base)) p->flags |= FANOUT_FLAG_PORTS;
+        } else {
+            p->flags = 0;
+        }
+        if (p->flags) flagged++;
+        if (kept != i) procs[kept] = *p;
+        kept++;
+    }
+    if (kept != proc_count) {
+        proc_count = kept;
+        index_rebuild();
+    }
+    return flagged;
+}
+
+int fanout_is_flagged(int32_t pid) {
+    const FanOutProc *p = fanout_lookup(pid);
+    return p && p->flags;
+}
+
+const FanOutProc *fanout_lookup(int32_t pid) {
+    if (pid <= 0) return NULL;
+    int idx = find_proc(pid);
+    return idx >= 0 ? &procs[idx] : NULL;
+}
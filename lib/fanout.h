@@ -0,0 +1,47 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 扇出检测：扫描器 / 蠕虫的特征是单个进程在短时间内连向大量*不同*的远端 IP 或端口。
+// 每个进程维护两组 HyperLogLog 基数草图（远端 IP、远端端口），跨扫描累积，只统计出站连接
+// （本地端口不是监听端口的连接）。草图按纪元轮换：当前纪元与上一纪元两份，估计值取两者的并集，
+// 因此覆盖最近 1~2 个纪元。每轮把估计值与该进程自身的平滑基线比较，跳升到基线数倍时标记 "FanOut"。
+// 进程槽位、草图与索引全部是定长静态数组：无论主机在几天内见过多少不同远端，内存都不变
+
+#define FANOUT_HLL_BITS 8                    // 每份草图 2^8 个寄存器，标准误差约 6.5%
+#define FANOUT_HLL_M (1 << FANOUT_HLL_BITS)
+#define FANOUT_MAX_PROCS 256                 // 同时跟踪的进程数上限（满时淘汰最久未出现的）
+#define FANOUT_EPOCH_SCANS 30                // 每个纪元的扫描轮数（默认间隔下约 1 分钟）
+#define FANOUT_MIN_DISTINCT 32               // 估计的不同远端数至少为该值才可能标记
+#define FANOUT_JUMP 3.0                      // 且达到基线的该倍数
+#define FANOUT_BASE_ALPHA 0.05               // 基线的平滑系数（持续的新水平约十几轮后被吸收）
+#define FANOUT_GRACE 5                       // 连续缺席超过该轮数即淘汰
+
+#define FANOUT_FLAG_IPS   0x1                // 不同远端 IP 数跳升
+#define FANOUT_FLAG_PORTS 0x2                // 不同远端端口数跳升
+
+typedef struct {
+    int32_t pid;
+    char process[32];
+    uint8_t ips[2][FANOUT_HLL_M];            // 远端 IP 草图，[纪元 & 1]
+    uint8_t ports[2][FANOUT_HLL_M];          // 远端端口草图
+    double ip_base;                          // 估计值的平滑基线
+    double port_base;
+    int ip_est;                              // 本轮估计的不同远端 IP 数（最近 1~2 个纪元）
+    int port_est;
+    int flags;                               // FANOUT_FLAG_*
+    uint32_t last_gen;                       // 最近一次出现的轮次
+} FanOutProc;
+
+// 每轮扫描后调用，返回被标记的进程数
+int fanout_update(const ConnectionInfo *conns, int count);
+
+// 该 pid 当前是否被标记
+int fanout_is_flagged(int32_t pid);
+
+// 该 pid 的跟踪记录，未跟踪返回 NULL
+const FanOutProc *fanout_lookup(int32_t pid);
+
+#endif // FANOUT_H
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#endif
+#include "lib/heavy_hitters.h"
+
+#define INDEX_CAP (HH_CAPACITY * 4)
+#define INDEX_MASK (INDEX_CAP - 1)
+
+typedef struct {
+    HeavyHitter heap[HH_CAPACITY];   // 按 count 的最小堆，根为下一个被替换的键
+    int size;
+    int index[INDEX_CAP];            // 键 -> 堆下标的开放寻址索引，-1 为空槽
+    const HeavyHitter *ranked[HH_TOP_MAX];
+    int ranked_count;
+} HhTable;
+
+static HhTable tables[HH_MODE_COUNT];
+static int initialized = 0;
+static double total = 0;             // 衰减后的全部连接·秒
+static double norm = 0;              // 衰减后的累计秒数
+static int64_t last_ms = 0;
+
+static uint32_t key_hash(const HhKey *k) {
+    uint32_t h = 2166136261u;
+    const uint8_t *p = (const uint8_t *)k;
+    for (size_t i = 0; i < sizeof(*k); i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void heap_swap(HhTable *t, int a, int b) {
+    HeavyHitter tmp = t->heap[a];
+    t->heap[a] = t->heap[b];
+    t->heap[b] = tmp;
+    t->index[t->heap[a].slot] = a;
+    t->index[t->heap[b].slot] = b;
+}
+
+static void sift_up(HhTable *t, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (t->heap[parent].count <= t->heap[i].count) break;
+        heap_swap(t, parent, i);
+        i = parent;
+    }
+}
+
+static void sift_down(HhTable *t, int i) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < t->size && t->heap[l].count < t->heap[m].count) m = l;
+        if (r < t->size && t->heap[r].count < t->heap[m].count) m = r;
+        if (m == i) return;
+        heap_swap(t, m, i);
+        i = m;
+    }
+}
+
+// 键所在的槽，或应插入的空槽
+static int find_slot(const HhTable *t, const HhKey *k, uint32_t h) {
+    int s = (int)(h & INDEX_MASK);
+    while (t->index[s] >= 0) {
+        const HeavyHitter *e = &t->heap[t->index[s]];
+        if (e->hash == h && memcmp(&e->key, k, sizeof(*k)) == 0) return s;
+        s = (s + 1) & INDEX_MASK;
+    }
+    return s;
+}
+
+// 线性探测的回移删除：把后续同簇中可前移的项补进空位，不留墓碑
+static void index_delete(HhTable *t, int s) {
+    int i = s;
+    t->index[i] = -1;
+    for (int j = (i + 1) & INDEX_MASK; t->index[j] >= 0; j = (j + 1) & INDEX_MASK) {
+        int home = (int)(t->heap[t->index[j]].hash & INDEX_MASK);
+        // home 落在 (i, j] 之间（环形）时该项不能前移
+        int stays = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (stays) continue;
+        t->index[i] = t->index[j];
+        t->heap[t->index[i]].slot = i;
+        t->index[j] = -1;
+        i = j;
+    }
+}
+
+static void format_label(const HhKey *k, HhMode mode, char *buf, size_t size) {
+    if (k->family == 4) {
+        if (mode == HH_BY_PREFIX) snprintf(buf, size, "%u.%u.%u.0/24", k->addr[0], k->addr[1], k->addr[2]);
+        else snprintf(buf, size, "%u.%u.%u.%u", k->addr[0], k->addr[1], k->addr[2], k->addr[3]);
+        return;
+    }
+#ifndef _WIN32
+    char text[INET6_ADDRSTRLEN];
+    if (inet_ntop(AF_INET6, k->addr, text, sizeof(text))) {
+        snprintf(buf, size, "%s%s", text, mode == HH_BY_PREFIX ? "/64" : "");
+        return;
+    }
+#endif
+    snprintf(buf, size, "?");
+}
+
+// 远端地址转为键：IPv4 "a.b.c.d:port"，IPv6 "[addr]:port"；未连接（地址或端口为 0）或无法解析返回 -1
+static int remote_key(const char *addr, HhMode mode, HhKey *k) {
+    memset(k, 0, sizeof(*k));
+    uint32_t ip;
+    uint16_t port;
+    if (parse_ipv4_endpoint(addr, &ip, &port) == 0) {
+        if (ip == 0 || port == 0) return -1;
+        k->family = 4;
+        memcpy(k->addr, &ip, 4);
+        if (mode == HH_BY_PREFIX) k->addr[3] = 0;
+        return 0;
+    }
+#ifndef _WIN32
+    const char *close = strchr(addr, ']');
+    if (addr[0] != '[' || !close || close[1] != ':' || atoi(close + 2) == 0) return -1;
+    char text[64];
+    size_t n = (size_t)(close - addr - 1);
+    if (n >= sizeof(text)) return -1;
+    memcpy(text, addr + 1, n);
+    text[n] = '\0';
+    if (inet_pton(AF_INET6, text, k->addr) != 1) return -1;
+    k->family = 6;
+    if (mode == HH_BY_PREFIX) memset(k->addr + 8, 0, 8);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+// Space-Saving 更新
+static void table_add(HhTable *t, HhMode mode, const HhKey *k, double w) {
+    uint32_t h = key_hash(k);
+    int s = find_slot(t, k, h);
+    if (t->index[s] >= 0) {
+        int pos = t->index[s];
+        t->heap[pos].count += w;
+        sift_down(t, pos);
+        return;
+    }
+    int pos;
+    double base = 0;
+    if (t->size < HH_CAPACITY) {
+        pos = t->size++;
+    } else {
+        // 替换计数最小的键，新键继承其计数：高估量不超过该计数
+        pos = 0;
+        base = t->heap[0].count;
+        index_delete(t, t->heap[0].slot);
+        s = find_slot(t, k, h);
+    }
+    HeavyHitter *e = &t->heap[pos];
+    e->key = *k;
+    e->hash = h;
+    e->count = base + w;
+    e->err = base;
+    e->slot = s;
+    format_label(k, mode, e->label, sizeof(e->label));
+    t->index[s] = pos;
+    if (pos == 0) sift_down(t, 0);
+    else sift_up(t, pos);
+}
+
+// 取计数最高的 HH_TOP_MAX 个（插入排序）
+static void table_rank(HhTable *t) {
+    t->ranked_count = 0;
+    for (int i = 0; i < t->size; i++) {
+        const HeavyHitter *e = &t->heap[i];
+        int j = t->ranked_count < HH_TOP_MAX ? t->ranked_count++ : HH_TOP_MAX;
+        while (j > 0 && t->ranked[j - 1]->count < e->count) {
+            if (j < HH_TOP_MAX) t->ranked[j] = t->ranked[j - 1];
+            j--;
+        }
+        if (j < HH_TOP_MAX) t->ranked[j] = e;
+    }
+}
+
+void heavy_hitters_update(const ConnectionInfo *conns, int count, int64_t now_ms) {
+    if (!initialized) {
+        for (int m = 0; m < HH_MODE_COUNT; m++) memset(tables[m].index, 0xff, sizeof(tables[m].index));
+        initialized = 1;
+    }
+
+    // 本轮权重为距上一轮的秒数；首轮按 1 秒计，使第一轮起平均值即为当前连接数
+    double dt = last_ms > 0 ? (now_ms - last_ms) / 1000.0 : 1.0;
+    if (dt < 0) dt = 0;
+    if (dt > HH_MAX_STEP_SEC) dt = HH_MAX_STEP_SEC;
+    last_ms = now_ms;
+    if (dt == 0) return;
+
+    // 统一衰减：所有计数等比缩放，堆序不变
+    double decay = exp(-dt / HH_WINDOW_SEC);
+    for (int m = 0; m < HH_MODE_COUNT; m++) {
+        HhTable *t = &tables[m];
+        for (int i = 0; i < t->size; i++) {
+            t->heap[i].count *= decay;
+            t->heap[i].err *= decay;
+        }
+    }
+    total *= decay;
+    norm = norm * decay + dt;
+
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        if (c->status_enum == CONN_STATUS_LISTEN) continue;
+        double w = dt;
+        HhKey k;
+        if (remote_key(c->remote_addr, HH_BY_HOST, &k) != 0) continue;
+        table_add(&tables[HH_BY_HOST], HH_BY_HOST, &k, w);
+        remote_key(c->remote_addr, HH_BY_PREFIX, &k);
+        table_add(&tables[HH_BY_PREFIX], HH_BY_PREFIX, &k, w);
+        total += w;
+    }
+
+    for (int m = 0; m < HH_MODE_COUNT; m++) table_rank(&tables[m]);
+}
+
+int heavy_hitters_ranked(HhMode mode, const HeavyHitter **out, int max) {
+    const HhTable *t = &tables[mode];
+    int n = t->ranked_count < max ? t->ranked_count : max;
+    for (int i = 0; i < n; i++) out[i] = t->ranked[i];
+    return n;
+}
+
+double heavy_hitters_avg(const HeavyHitter *h) {
+    return norm > 0 ? h->count / norm : 0;
+}
+
+double heavy_hitters_err(const HeavyHitter *h) {
+    return norm > 0 ? h->err / norm : 0;
+}
+
+double heavy_hitters_share(const HeavyHitter *h) {
+    return total > 0 ? h->count / total : 0;
+}
+
+double heavy_hitters_window_sec(void) {
+    return norm;
+}
+
+int heavy_hitters_rank(HhMode mode, const ConnectionInfo *c, int max) {
+    const HhTable *t = &tables[mode];
+    if (t->ranked_count == 0) return -1;
+    HhKey k;
+    if (remote_key(c->remote_addr, mode, &k) != 0) return -1;
+    int n = t->ranked_count < max ? t->ranked_count : max;
+    for (int i = 0; i < n; i++) {
+        if (memcmp(&t->ranked[i]->key, &k, sizeof(k)) == 0) return i;
+    }
+    return -1;
+}
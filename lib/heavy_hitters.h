@@ -0,0 +1,58 @@
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 远端热点（heavy hitters）：跨扫描累积“最常连向的远端”，按主机与按网段（IPv4 /24、IPv6 /64）各一张表。
+// 每张表是定长的 Space-Saving 摘要（HH_CAPACITY 个计数器 + 最小堆 + 开放寻址索引）：已在表中的键直接累加，
+// 否则替换计数最小的键并继承其计数作为误差上界，因此真实值落在 [count - err, count] 内，
+// 且真实份额超过 1/HH_CAPACITY 的键一定在表中。无论流量多分散，内存都不变。
+// 每轮每条连接按距上一轮的秒数加权（连接·秒），所有计数按时间常数 HH_WINDOW_SEC 指数衰减，
+// 除以同样衰减的累计秒数后即为近一小时内的平均并发连接数
+
+#define HH_CAPACITY 256              // 每张表的计数器数
+#define HH_TOP_MAX 32                // 排名保留的条数
+#define HH_WINDOW_SEC 3600.0         // 衰减时间常数（秒）
+#define HH_MAX_STEP_SEC 60.0         // 单轮权重的上限（进程挂起或时钟跳变后不至于一轮压倒全部历史）
+
+typedef enum {
+    HH_BY_HOST,                      // 单个远端 IP
+    HH_BY_PREFIX,                    // IPv4 /24、IPv6 /64
+    HH_MODE_COUNT
+} HhMode;
+
+typedef struct {
+    uint8_t family;                  // 4 或 6
+    uint8_t addr[16];                // 网络字节序，网段模式下主机位清零
+} HhKey;
+
+typedef struct {
+    HhKey key;
+    char label[64];                  // 展示用，"a.b.c.d" / "a.b.c.0/24" / "2001:db8::/64"
+    double count;                    // 衰减后的连接·秒（含误差）
+    double err;                      // 高估量的上界
+    uint32_t hash;
+    int slot;                        // 在索引中的位置
+} HeavyHitter;
+
+// 每轮扫描后调用（now_ms 为 Unix 毫秒）
+void heavy_hitters_update(const ConnectionInfo *conns, int count, int64_t now_ms);
+
+// 取得估计值最高的至多 max 个（max 不超过 HH_TOP_MAX），返回数量
+int heavy_hitters_ranked(HhMode mode, const HeavyHitter **out, int max);
+
+// 窗口内的平均并发连接数估计与其误差上界
+double heavy_hitters_avg(const HeavyHitter *h);
+double heavy_hitters_err(const HeavyHitter *h);
+
+// 在窗口内全部连接·秒中的占比（0..1）
+double heavy_hitters_share(const HeavyHitter *h);
+
+// 已覆盖的有效秒数（衰减后），不足 HH_WINDOW_SEC 时说明运行时间还短
+double heavy_hitters_window_sec(void);
+
+// 该连接的远端在排名前 max 中的位置（0 起），不在其中返回 -1
+int heavy_hitters_rank(HhMode mode, const ConnectionInfo *c, int max);
+
+#endif // HEAVY_HITTERS_H
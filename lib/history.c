@@ -0,0 +1,618 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/history.h"
+#include "lib/strbuf.h"
+#include "lib/strtab.h"
+
+#define HISTORY_BYTES_PER_ENTRY 512  // 每 512 字节预算配一个索引项（32MB 约 6.5 万轮）
+
+// 行的各字段统一存为 uint64：字符串为段内编号，有符号值为 zigzag，浮点为 float 的位模式
+enum {
+    HF_PROTOCOL, HF_LOCAL, HF_REMOTE, HF_STATUS, HF_PROCESS, HF_EXE, HF_RISK,
+    HF_STATUS_ENUM, HF_PID, HF_INODE, HF_FIRST_SEEN, HF_STATE_SINCE,
+    HF_TX_QUEUE, HF_RX_QUEUE, HF_BACKLOG, HF_GROUP_COUNT, HF_GROUP_PORT_MIN, HF_GROUP_PORT_MAX,
+    HF_TCP_VALID, HF_BYTES_ACKED, HF_BYTES_RECEIVED, HF_SEGS_OUT, HF_SEGS_IN, HF_RTT, HF_RTTVAR,
+    HF_TOTAL_RETRANS, HF_CWND, HF_CA_STATE, HF_TX_RATE, HF_RX_RATE, HF_RETRANS_RATE,
+    HF_COUNT
+};
+
+typedef struct {
+    uint64_t v[HF_COUNT];
+} HistRow;
+
+typedef struct {
+    size_t off;                      // 记录在数据区中的位置（记录不跨越数据区末尾）
+    size_t len;
+    int64_t time_ms;
+    int32_t count;
+    int32_t stuck;                   // calculate_stats 算不出的告警计数，随该轮保存
+    int32_t port_at_risk;
+    int32_t port_util_max;
+    int32_t leaking;
+    uint8_t keyframe;
+} HistEntry;
+
+// 数据区与索引：都是环形，索引按扫描顺序排列，数据区中的记录按同样顺序首尾相接
+static uint8_t *ring = NULL;
+static size_t ring_cap = 0;
+static size_t ring_head = 0;         // 下一条记录的写入位置
+static size_t ring_used = 0;
+static HistEntry *entries = NULL;
+static int entry_cap = 0;
+static int entry_first = 0;
+static int entry_n = 0;
+static int64_t first_seq = 0;        // 最旧一轮的序号，始终是关键帧
+
+// 编码器：上一轮的行（增量的参照，顺序与解码结果一致）与本段的字符串表
+static struct {
+    StringTable dict;                // 本段已写入的字符串，提交后指向数据区中的副本
+    int dict_before;                 // 本轮编码前的字符串数
+    HistRow *ref;
+    HistRow *cur;
+    int *match;                      // 参照行 -> 本轮行下标，-1 为已消失
+    uint8_t *added;                  // 本轮行是否为新出现
+    int ref_count;
+    int cap;
+    int *slots;                      // 参照行按键的开放寻址索引
+    int slot_cap;
+    StrBuf out;
+    size_t str_block;                // 本轮新字符串在记录中的起点
+    int oom;
+    int seg_scans;                   // 本段已写入的轮数，-1 表示下一轮必须写关键帧
+    int64_t seg_key;                 // 本段关键帧的序号
+} enc;
+
+// 解码器：保留最近解码到的一轮，向后步进时只需再解一条增量
+static struct {
+    const char **strs;               // 段内字符串编号 -> 数据区中的字符串
+    int str_count;
+    int str_cap;
+    HistRow *rows;
+    uint8_t *removed;
+    int count;
+    int cap;
+    int64_t seq;                     // 已解码到的轮次，-1 为无
+    int64_t key_seq;
+    ConnectionInfo *conns;
+    int conn_cap;
+    int64_t conns_seq;               // stats 对应的轮次
+    ConnectionStats stats;
+} dec;
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// 速率只用于展示，按 float 精度保存
+static uint64_t float_bits(double d) {
+    float f = (float)d;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static double bits_float(uint64_t v) {
+    uint32_t u = (uint32_t)v;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static void *grow(void *p, size_t elem, int cap, int *ok) {
+    void *tmp = realloc(p, elem * (size_t)cap);
+    if (!tmp) {
+        *ok = 0;
+        return p;
+    }
+    return tmp;
+}
+
+static void put_bytes(StrBuf *b, const void *s, size_t n) {
+    if (strbuf_reserve(b, n) != 0) {
+        enc.oom = 1;
+        return;
+    }
+    strbuf_append(b, s, n);
+}
+
+static void put_varint(StrBuf *b, uint64_t v) {
+    uint8_t tmp[10];
+    int n = 0;
+    while (v >= 0x80) {
+        tmp[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    tmp[n++] = (uint8_t)v;
+    put_bytes(b, tmp, (size_t)n);
+}
+
+// 越界时返回 0 并停在 end，由调用方的计数检查兜底
+static uint64_t get_varint(const uint8_t **p, const uint8_t *end) {
+    uint64_t v = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*p)++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+    *p = end;
+    return 0;
+}
+
+static void put_row(StrBuf *b, const HistRow *r) {
+    for (int f = 0; f < HF_COUNT; f++) put_varint(b, r->v[f]);
+}
+
+static void get_row(const uint8_t **p, const uint8_t *end, HistRow *r) {
+    for (int f = 0; f < HF_COUNT; f++) r->v[f] = get_varint(p, end);
+}
+
+static void row_from_conn(HistRow *r, const ConnectionInfo *c, StringTable *dict) {
+    r->v[HF_PROTOCOL] = (uint64_t)strtab_intern(dict, c->protocol);
+    r->v[HF_LOCAL] = (uint64_t)strtab_intern(dict, c->local_addr);
+    r->v[HF_REMOTE] = (uint64_t)strtab_intern(dict, c->remote_addr);
+    r->v[HF_STATUS] = (uint64_t)strtab_intern(dict, c->status);
+    r->v[HF_PROCESS] = (uint64_t)strtab_intern(dict, c->process);
+    r->v[HF_EXE] = (uint64_t)strtab_intern(dict, c->exe_path);
+    r->v[HF_RISK] = (uint64_t)strtab_intern(dict, c->risk_reason);
+    r->v[HF_STATUS_ENUM] = (uint64_t)c->status_enum;
+    r->v[HF_PID] = zigzag(c->pid);
+    r->v[HF_INODE] = c->inode;
+    r->v[HF_FIRST_SEEN] = zigzag(c->first_seen);
+    r->v[HF_STATE_SINCE] = zigzag(c->state_since);
+    r->v[HF_TX_QUEUE] = c->tx_queue;
+    r->v[HF_RX_QUEUE] = c->rx_queue;
+    r->v[HF_BACKLOG] = c->backlog;
+    r->v[HF_GROUP_COUNT] = zigzag(c->group_count);
+    r->v[HF_GROUP_PORT_MIN] = c->group_port_min;
+    r->v[HF_GROUP_PORT_MAX] = c->group_port_max;
+    r->v[HF_TCP_VALID] = c->tcp.valid;
+    r->v[HF_BYTES_ACKED] = c->tcp.bytes_acked;
+    r->v[HF_BYTES_RECEIVED] = c->tcp.bytes_received;
+    r->v[HF_SEGS_OUT] = c->tcp.segs_out;
+    r->v[HF_SEGS_IN] = c->tcp.segs_in;
+    r->v[HF_RTT] = c->tcp.rtt_us;
+    r->v[HF_RTTVAR] = c->tcp.rttvar_us;
+    r->v[HF_TOTAL_RETRANS] = c->tcp.total_retrans;
+    r->v[HF_CWND] = c->tcp.snd_cwnd;
+    r->v[HF_CA_STATE] = c->tcp.ca_state;
+    r->v[HF_TX_RATE] = float_bits(c->tcp.tx_rate);
+    r->v[HF_RX_RATE] = float_bits(c->tcp.rx_rate);
+    r->v[HF_RETRANS_RATE] = float_bits(c->tcp.retrans_rate);
+}
+
+static void copy_str(char *dst, size_t size, uint64_t id) {
+    snprintf(dst, size, "%s", id < (uint64_t)dec.str_count ? dec.strs[id] : "");
+}
+
+static void conn_from_row(ConnectionInfo *c, const HistRow *r) {
+    memset(c, 0, sizeof(*c));
+    copy_str(c->protocol, sizeof(c->protocol), r->v[HF_PROTOCOL]);
+    copy_str(c->local_addr, sizeof(c->local_addr), r->v[HF_LOCAL]);
+    copy_str(c->remote_addr, sizeof(c->remote_addr), r->v[HF_REMOTE]);
+    copy_str(c->status, sizeof(c->status), r->v[HF_STATUS]);
+    copy_str(c->process, sizeof(c->process), r->v[HF_PROCESS]);
+    copy_str(c->exe_path, sizeof(c->exe_path), r->v[HF_EXE]);
+    copy_str(c->risk_reason, sizeof(c->risk_reason), r->v[HF_RISK]);
+    c->status_enum = (ConnectionStatus)r->v[HF_STATUS_ENUM];
+    c->pid = (int32_t)unzigzag(r->v[HF_PID]);
+    c->inode = r->v[HF_INODE];
+    c->first_seen = unzigzag(r->v[HF_FIRST_SEEN]);
+    c->state_since = unzigzag(r->v[HF_STATE_SINCE]);
+    c->tx_queue = (uint32_t)r->v[HF_TX_QUEUE];
+    c->rx_queue = (uint32_t)r->v[HF_RX_QUEUE];
+    c->backlog = (uint32_t)r->v[HF_BACKLOG];
+    c->group_count = (int32_t)unzigzag(r->v[HF_GROUP_COUNT]);
+    c->group_port_min = (uint16_t)r->v[HF_GROUP_PORT_MIN];
+    c->group_port_max = (uint16_t)r->v[HF_GROUP_PORT_MAX];
+    c->tcp.valid = (uint8_t)r->v[HF_TCP_VALID];
+    c->tcp.bytes_acked = r->v[HF_BYTES_ACKED];
+    c->tcp.bytes_received = r->v[HF_BYTES_RECEIVED];
+    c->tcp.segs_out = (uint32_t)r->v[HF_SEGS_OUT];
+    c->tcp.segs_in = (uint32_t)r->v[HF_SEGS_IN];
+    c->tcp.rtt_us = (uint32_t)r->v[HF_RTT];
+    c->tcp.rttvar_us = (uint32_t)r->v[HF_RTTVAR];
+    c->tcp.total_retrans = (uint32_t)r->v[HF_TOTAL_RETRANS];
+    c->tcp.snd_cwnd = (uint32_t)r->v[HF_CWND];
+    c->tcp.ca_state = (uint8_t)r->v[HF_CA_STATE];
+    c->tcp.tx_rate = bits_float(r->v[HF_TX_RATE]);
+    c->tcp.rx_rate = bits_float(r->v[HF_RX_RATE]);
+    c->tcp.retrans_rate = bits_float(r->v[HF_RETRANS_RATE]);
+}
+
+// 配对用的键：同一条连接在相邻两轮中这几项不变
+static const int KEY_FIELDS[] = { HF_PROTOCOL, HF_LOCAL, HF_REMOTE, HF_PID, HF_INODE };
+#define KEY_FIELD_COUNT (int)(sizeof(KEY_FIELDS) / sizeof(KEY_FIELDS[0]))
+
+static uint32_t row_key_hash(const HistRow *r) {
+    uint32_t h = 2166136261u;
+    for (int k = 0; k < KEY_FIELD_COUNT; k++) {
+        uint64_t v = r->v[KEY_FIELDS[k]];
+        for (int i = 0; i < 8; i++) {
+            h ^= (uint8_t)(v >> (i * 8));
+            h *= 16777619u;
+        }
+    }
+    return h;
+}
+
+static int same_key(const HistRow *a, const HistRow *b) {
+    for (int k = 0; k < KEY_FIELD_COUNT; k++) {
+        if (a->v[KEY_FIELDS[k]] != b->v[KEY_FIELDS[k]]) return 0;
+    }
+    return 1;
+}
+
+static int enc_reserve(int n) {
+    if (n <= enc.cap) return 0;
+    int cap = enc.cap ? enc.cap : 256;
+    while (cap < n) cap *= 2;
+    int ok = 1;
+    enc.ref = grow(enc.ref, sizeof(HistRow), cap, &ok);
+    enc.cur = grow(enc.cur, sizeof(HistRow), cap, &ok);
+    enc.match = grow(enc.match, sizeof(int), cap, &ok);
+    enc.added = grow(enc.added, sizeof(uint8_t), cap, &ok);
+    if (!ok) return -1;
+    enc.cap = cap;
+    return 0;
+}
+
+// 增量：配对参照行与本轮行，依次写出消失行、变化行（字段掩码 + 与旧值之差）、新行
+static void encode_delta(int count) {
+    StrBuf *b = &enc.out;
+    int slot_cap = 16;
+    while (slot_cap < enc.ref_count * 2) slot_cap *= 2;
+    if (slot_cap > enc.slot_cap) {
+        int ok = 1;
+        enc.slots = grow(enc.slots, sizeof(int), slot_cap, &ok);
+        if (!ok) {
+            enc.oom = 1;
+            return;
+        }
+        enc.slot_cap = slot_cap;
+    }
+    int mask = slot_cap - 1;
+    memset(enc.slots, 0xff, sizeof(int) * (size_t)slot_cap);
+    for (int i = 0; i < enc.ref_count; i++) {
+        int s = (int)(row_key_hash(&enc.ref[i]) & (uint32_t)mask);
+        while (enc.slots[s] >= 0) s = (s + 1) & mask;
+        enc.slots[s] = i;
+        enc.match[i] = -1;
+    }
+    int n_added = 0;
+    for (int j = 0; j < count; j++) {
+        enc.added[j] = 1;
+        for (int s = (int)(row_key_hash(&enc.cur[j]) & (uint32_t)mask); enc.slots[s] >= 0; s = (s + 1) & mask) {
+            int i = enc.slots[s];
+            if (enc.match[i] < 0 && same_key(&enc.ref[i], &enc.cur[j])) {
+                enc.match[i] = j;
+                enc.added[j] = 0;
+                break;
+            }
+        }
+        n_added += enc.added[j];
+    }
+
+    int n_removed = 0, n_changed = 0;
+    for (int i = 0; i < enc.ref_count; i++) {
+        if (enc.match[i] < 0) n_removed++;
+        else if (memcmp(&enc.ref[i], &enc.cur[enc.match[i]], sizeof(HistRow)) != 0) n_changed++;
+    }
+    // 下标按升序写出与前一个的间隔，多数只占一个字节
+    put_varint(b, (uint64_t)n_removed);
+    for (int i = 0, prev = -1; i < enc.ref_count; i++) {
+        if (enc.match[i] >= 0) continue;
+        put_varint(b, (uint64_t)(i - prev - 1));
+        prev = i;
+    }
+    put_varint(b, (uint64_t)n_changed);
+    for (int i = 0, prev = -1; i < enc.ref_count; i++) {
+        if (enc.match[i] < 0) continue;
+        const HistRow *old = &enc.ref[i], *now = &enc.cur[enc.match[i]];
+        uint64_t fields = 0;
+        for (int f = 0; f < HF_COUNT; f++) {
+            if (old->v[f] != now->v[f]) fields |= (uint64_t)1 << f;
+        }
+        if (!fields) continue;
+        put_varint(b, (uint64_t)(i - prev - 1));
+        prev = i;
+        put_varint(b, fields);
+        for (int f = 0; f < HF_COUNT; f++) {
+            if (fields & ((uint64_t)1 << f)) put_varint(b, zigzag((int64_t)(now->v[f] - old->v[f])));
+        }
+    }
+    put_varint(b, (uint64_t)n_added);
+    for (int j = 0; j < count; j++) {
+        if (enc.added[j]) put_row(b, &enc.cur[j]);
+    }
+
+    // 新的参照：保留下来的行按原顺序在前，新行在后（与解码器的结果一致）；k <= i，可在 ref 上原地重建
+    int k = 0;
+    for (int i = 0; i < enc.ref_count; i++) {
+        if (enc.match[i] >= 0) enc.ref[k++] = enc.cur[enc.match[i]];
+    }
+    for (int j = 0; j < count; j++) {
+        if (enc.added[j]) enc.ref[k++] = enc.cur[j];
+    }
+    enc.ref_count = k;
+}
+
+// 编码一轮到 enc.out：新字符串块 + 关键帧全部行或增量；失败返回 -1
+static int encode(const ConnectionInfo *conns, int count, int keyframe) {
+    StrBuf *b = &enc.out;
+    b->len = 0;
+    enc.oom = 0;
+    if (enc_reserve(count > enc.ref_count ? count : enc.ref_count) != 0) return -1;
+    if (keyframe) strtab_reset(&enc.dict);
+    enc.dict_before = enc.dict.count;
+    for (int i = 0; i < count; i++) row_from_conn(&enc.cur[i], &conns[i], &enc.dict);
+    if (enc.dict.failed) return -1;
+
+    put_varint(b, (uint64_t)(enc.dict.count - enc.dict_before));
+    enc.str_block = b->len;
+    for (int i = enc.dict_before; i < enc.dict.count; i++) put_bytes(b, enc.dict.strs[i], strlen(enc.dict.strs[i]) + 1);
+
+    if (keyframe) {
+        put_varint(b, (uint64_t)count);
+        for (int i = 0; i < count; i++) put_row(b, &enc.cur[i]);
+        HistRow *tmp = enc.ref;
+        enc.ref = enc.cur;
+        enc.cur = tmp;
+        enc.ref_count = count;
+    } else {
+        encode_delta(count);
+    }
+    return enc.oom ? -1 : 0;
+}
+
+static HistEntry *entry_at(int64_t seq) {
+    return &entries[(entry_first + (int)(seq - first_seq)) % entry_cap];
+}
+
+// 淘汰最旧的一段（关键帧及其后的增量，增量离开关键帧无法解码）
+static void evict_segment(void) {
+    do {
+        ring_used -= entries[entry_first].len;
+        entry_first = (entry_first + 1) % entry_cap;
+        entry_n--;
+        first_seq++;
+    } while (entry_n > 0 && !entries[entry_first].keyframe);
+    // 编码器所在的段被淘汰后，段内字符串编号随之失效，下一轮改写关键帧
+    if (enc.seg_key < first_seq) enc.seg_scans = -1;
+}
+
+static int oldest_overlaps(size_t start, size_t end) {
+    const HistEntry *e = &entries[entry_first];
+    return e->off < end && e->off + e->len > start;
+}
+
+int history_init(size_t budget_bytes) {
+    history_free();
+    if (budget_bytes == 0) return 0;
+    int cap = (int)(budget_bytes / HISTORY_BYTES_PER_ENTRY);
+    if (cap < 16) return -1;
+    size_t index_bytes = sizeof(HistEntry) * (size_t)cap;
+    entries = malloc(index_bytes);
+    ring = malloc(budget_bytes - index_bytes);
+    if (!entries || !ring) {
+        history_free();
+        return -1;
+    }
+    entry_cap = cap;
+    ring_cap = budget_bytes - index_bytes;
+    strtab_init(&enc.dict);
+    enc.seg_scans = -1;
+    dec.seq = -1;
+    dec.conns_seq = -1;
+    return 0;
+}
+
+void history_record(const ConnectionInfo *conns, int count, const ConnectionStats *stats, int64_t now_ms) {
+    if (!ring) return;
+    int keyframe = enc.seg_scans < 0 || enc.seg_scans >= HISTORY_KEYFRAME_EVERY;
+    size_t pos;
+    for (;;) {
+        if (encode(conns, count, keyframe) != 0 || enc.out.len > ring_cap) {
+            // 本轮不记录；已登记的字符串仍指向 conns，下一轮重新开段
+            enc.seg_scans = -1;
+            return;
+        }
+        pos = ring_head;
+        if (enc.out.len > ring_cap - pos) {
+            // 末尾放不下时回到开头；写入位置之后的都是最旧的记录，一并淘汰
+            while (entry_n > 0 && entries[entry_first].off >= pos) evict_segment();
+            pos = 0;
+        }
+        while (entry_n > 0 && (entry_n == entry_cap || oldest_overlaps(pos, pos + enc.out.len))) evict_segment();
+        if (keyframe || enc.seg_scans >= 0) break;
+        keyframe = 1; // 本段的关键帧刚被淘汰，改写为关键帧
+    }
+
+    memcpy(ring + pos, enc.out.data, enc.out.len);
+    // 本轮新登记的字符串改指向数据区中的副本（conns 在下一轮扫描前释放）
+    const char *s = (const char *)ring + pos + enc.str_block;
+    for (int i = enc.dict_before; i < enc.dict.count; i++) {
+        enc.dict.strs[i] = s;
+        s += strlen(s) + 1;
+    }
+
+    int64_t seq = first_seq + entry_n;
+    HistEntry *e = &entries[(entry_first + entry_n) % entry_cap];
+    e->off = pos;
+    e->len = enc.out.len;
+    e->time_ms = now_ms;
+    e->count = count;
+    e->stuck = stats->stuck;
+    e->port_at_risk = stats->port_at_risk;
+    e->port_util_max = stats->port_util_max;
+    e->leaking = stats->leaking;
+    e->keyframe = (uint8_t)keyframe;
+    entry_n++;
+    ring_head = pos + enc.out.len;
+    ring_used += enc.out.len;
+    if (keyframe) {
+        enc.seg_key = seq;
+        enc.seg_scans = 1;
+    } else {
+        enc.seg_scans++;
+    }
+}
+
+int history_range(int64_t *first, int64_t *last) {
+    *first = first_seq;
+    *last = first_seq + entry_n - 1;
+    return entry_n;
+}
+
+int64_t history_time_ms(int64_t seq) {
+    if (seq < first_seq || seq >= first_seq + entry_n) return 0;
+    return entry_at(seq)->time_ms;
+}
+
+static int dec_reserve(int n) {
+    if (n <= dec.cap) return 0;
+    int cap = dec.cap ? dec.cap : 256;
+    while (cap < n) cap *= 2;
+    int ok = 1;
+    dec.rows = grow(dec.rows, sizeof(HistRow), cap, &ok);
+    dec.removed = grow(dec.removed, sizeof(uint8_t), cap, &ok);
+    if (!ok) return -1;
+    dec.cap = cap;
+    return 0;
+}
+
+// 在 dec 当前状态上应用一条记录（关键帧则从头开始）
+static int decode_record(const HistEntry *e) {
+    const uint8_t *p = ring + e->off, *end = p + e->len;
+    if (e->keyframe) {
+        dec.str_count = 0;
+        dec.count = 0;
+    }
+    uint64_t n_str = get_varint(&p, end);
+    for (uint64_t k = 0; k < n_str; k++) {
+        const uint8_t *nul = memchr(p, '\0', (size_t)(end - p));
+        if (!nul) return -1;
+        if (dec.str_count == dec.str_cap) {
+            int ok = 1;
+            int cap = dec.str_cap ? dec.str_cap * 2 : 1024;
+            dec.strs = grow(dec.strs, sizeof(char *), cap, &ok);
+            if (!ok) return -1;
+            dec.str_cap = cap;
+        }
+        dec.strs[dec.str_count++] = (const char *)p;
+        p = nul + 1;
+    }
+
+    if (e->keyframe) {
+        uint64_t n = get_varint(&p, end);
+        if (n > (uint64_t)e->count || dec_reserve((int)n) != 0) return -1;
+        for (uint64_t i = 0; i < n; i++) get_row(&p, end, &dec.rows[i]);
+        dec.count = (int)n;
+        return 0;
+    }
+
+    memset(dec.removed, 0, (size_t)dec.count);
+    uint64_t n_removed = get_varint(&p, end);
+    for (uint64_t k = 0, idx = (uint64_t)-1; k < n_removed; k++) {
+        idx += get_varint(&p, end) + 1;
+        if (idx >= (uint64_t)dec.count) return -1;
+        dec.removed[idx] = 1;
+    }
+    uint64_t n_changed = get_varint(&p, end);
+    for (uint64_t k = 0, idx = (uint64_t)-1; k < n_changed; k++) {
+        idx += get_varint(&p, end) + 1;
+        if (idx >= (uint64_t)dec.count) return -1;
+        uint64_t fields = get_varint(&p, end);
+        for (int f = 0; f < HF_COUNT; f++) {
+            if (fields & ((uint64_t)1 << f)) dec.rows[idx].v[f] += (uint64_t)unzigzag(get_varint(&p, end));
+        }
+    }
+    uint64_t n_added = get_varint(&p, end);
+    if (n_added > (uint64_t)e->count || dec_reserve(dec.count + (int)n_added) != 0) return -1;
+    // 原地压紧保留的行（k <= i），新行接在其后
+    int k = 0;
+    for (int i = 0; i < dec.count; i++) {
+        if (!dec.removed[i]) dec.rows[k++] = dec.rows[i];
+    }
+    for (uint64_t j = 0; j < n_added; j++) get_row(&p, end, &dec.rows[k++]);
+    dec.count = k;
+    return k == e->count ? 0 : -1;
+}
+
+int history_load(int64_t seq, ConnectionInfo **conns, int *count, ConnectionStats *stats) {
+    if (!ring || seq < first_seq || seq >= first_seq + entry_n) return -1;
+    int64_t key = seq;
+    while (!entry_at(key)->keyframe) key--;
+
+    // 同一段内向后步进时接着已解码的状态继续，否则从关键帧重新解
+    int64_t start = (dec.seq >= 0 && dec.key_seq == key && dec.seq <= seq) ? dec.seq + 1 : key;
+    for (int64_t s = start; s <= seq; s++) {
+        if (decode_record(entry_at(s)) != 0) {
+            dec.seq = -1;
+            dec.conns_seq = -1;
+            return -1;
+        }
+        dec.seq = s;
+        dec.key_seq = key;
+    }
+
+    // 每次都重新展开：调用方会原地排序、折叠上一次取得的数组
+    if (dec.count > dec.conn_cap) {
+        int ok = 1;
+        dec.conns = grow(dec.conns, sizeof(ConnectionInfo), dec.count, &ok);
+        if (!ok) return -1;
+        dec.conn_cap = dec.count;
+    }
+    for (int i = 0; i < dec.count; i++) conn_from_row(&dec.conns[i], &dec.rows[i]);
+    if (dec.conns_seq != seq) {
+        // calculate_stats 会按规则重判 risk_reason，之后恢复记录时的值（含 Spike / FanOut）
+        const HistEntry *e = entry_at(seq);
+        calculate_stats(dec.conns, dec.count, &dec.stats);
+        for (int i = 0; i < dec.count; i++) copy_str(dec.conns[i].risk_reason, sizeof(dec.conns[i].risk_reason), dec.rows[i].v[HF_RISK]);
+        dec.stats.stuck = e->stuck;
+        dec.stats.port_at_risk = e->port_at_risk;
+        dec.stats.port_util_max = e->port_util_max;
+        dec.stats.leaking = e->leaking;
+        dec.conns_seq = seq;
+    }
+
+    *stats = dec.stats;
+    *conns = dec.conns;
+    *count = dec.count;
+    return 0;
+}
+
+size_t history_bytes_used(void) {
+    return ring_used;
+}
+
+size_t history_capacity(void) {
+    return ring_cap;
+}
+
+void history_free(void) {
+    free(ring);
+    free(entries);
+    ring = NULL;
+    entries = NULL;
+    ring_cap = ring_head = ring_used = 0;
+    entry_cap = entry_first = entry_n = 0;
+    first_seq = 0;
+    strtab_free(&enc.dict);
+    strbuf_free(&enc.out);
+    free(enc.ref);
+    free(enc.cur);
+    free(enc.match);
+    free(enc.added);
+    free(enc.slots);
+    memset(&enc, 0, sizeof(enc));
+    free(dec.strs);
+    free(dec.rows);
+    free(dec.removed);
+    free(dec.conns);
+    memset(&dec, 0, sizeof(dec));
+}
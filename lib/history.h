@@ -0,0 +1,41 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 长时连接历史：每轮扫描的完整连接表压缩后存入一块固定大小的内存（预算在启动时一次分配），供界面回放任意一轮。
+// 每 HISTORY_KEYFRAME_EVERY 轮写一个关键帧（全部行），其间只写增量：按 (协议, 本地, 远端, PID, inode)
+// 与上一轮配对，记录消失的行、变化行中改变的字段（与旧值之差，变长整数编码）以及新出现的行。
+// 字符串在“关键帧 + 其后增量”组成的段内去重为编号，只在首次出现时写入一次。
+// 预算用尽时从最旧的整段开始淘汰；占用恒定，不随运行时间增长。
+// 预算只含压缩数据与索引；编解码的工作区与当前行数成正比、不计入预算：编码器每行约 0.5KB
+// （上一轮与本轮的定长字段行及配对索引），首次回放后解码器每行另需约 1.5KB（定长字段行与展开后的 ConnectionInfo）
+
+#define HISTORY_DEFAULT_MB 32
+#define HISTORY_KEYFRAME_EVERY 60    // 回放任意一轮最多解码一个关键帧与 59 个增量
+
+// 分配 budget_bytes 的历史存储（含索引），0 表示不记录；分配失败返回 -1
+int history_init(size_t budget_bytes);
+
+// 每轮扫描后调用（now_ms 为 Unix 毫秒）；stats 中 calculate_stats 之外的告警计数随本轮一并保存
+void history_record(const ConnectionInfo *conns, int count, const ConnectionStats *stats, int64_t now_ms);
+
+// 当前保存的扫描序号范围 [*first, *last]，返回轮数（0 表示尚无记录）
+int history_range(int64_t *first, int64_t *last);
+
+// 该轮的扫描时刻（Unix 毫秒），不在范围内返回 0
+int64_t history_time_ms(int64_t seq);
+
+// 解码第 seq 轮：*conns 指向内部数组（下一次调用前有效，每次调用重新展开，调用方可原地排序或折叠），
+// stats 按该轮的逐行数据计算；不在范围内或内存不足返回 -1
+int history_load(int64_t seq, ConnectionInfo **conns, int *count, ConnectionStats *stats);
+
+// 已用字节（记录数据，不含索引）与数据区容量
+size_t history_bytes_used(void);
+size_t history_capacity(void);
+
+void history_free(void);
+
+#endif // HISTORY_H
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/leak_watch.h"
+
+#define LEAK_RANK_MAX 16
+
+static ProcLeak *procs = NULL;
+static int proc_count = 0;
+static int proc_cap = 0;
+static uint32_t generation = 0;
+
+// pid -> procs[] 下标的开放寻址索引，-1 为空槽；每轮压缩数组后重建
+static int *slots = NULL;
+static int slot_cap = 0;
+
+static const ProcLeak *ranked[LEAK_RANK_MAX];
+static int ranked_count = 0;
+
+static uint32_t pid_hash(int32_t pid) {
+    return (uint32_t)pid * 2654435761u;
+}
+
+static void index_put(int idx) {
+    uint32_t i = pid_hash(procs[idx].pid) & (uint32_t)(slot_cap - 1);
+    while (slots[i] >= 0) i = (i + 1) & (uint32_t)(slot_cap - 1);
+    slots[i] = idx;
+}
+
+// 容量保持为 2 的幂且不低于表项数的两倍；内存不足返回 -1
+static int index_rebuild(int entries) {
+    int need = 64;
+    while (need < entries * 2) need <<= 1;
+    if (need > slot_cap) {
+        int *ns = realloc(slots, sizeof(int) * need);
+        if (!ns) return -1;
+        slots = ns;
+        slot_cap = need;
+    }
+    memset(slots, 0xff, sizeof(int) * slot_cap);
+    for (int i = 0; i < proc_count; i++) index_put(i);
+    return 0;
+}
+
+static int find_proc(int32_t pid) {
+    if (slot_cap == 0) return -1;
+    uint32_t i = pid_hash(pid) & (uint32_t)(slot_cap - 1);
+    while (slots[i] >= 0) {
+        if (procs[slots[i]].pid == pid) return slots[i];
+        i = (i + 1) & (uint32_t)(slot_cap - 1);
+    }
+    return -1;
+}
+
+// /proc/<pid>/stat 第 22 项；comm 可能含空格和括号，从最后一个 ')' 之后开始数
+static uint64_t read_start_time(int32_t pid) {
+    char path[512], buf[1024];
+    snprintf(path, sizeof(path), "%s/%d/stat", scanner_proc_root(), pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    char *p = strrchr(buf, ')');
+    if (!p) return 0;
+    p++;
+    for (int field = 3; field < 22 && p; field++) p = strchr(p + 1, ' ');
+    return p ? strtoull(p + 1, NULL, 10) : 0;
+}
+
+// "Max open files" 的软限制，unlimited 或读取失败返回 -1
+static int read_fd_limit(int32_t pid) {
+    char path[512], line[256];
+    snprintf(path, sizeof(path), "%s/%d/limits", scanner_proc_root(), pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int limit = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "Max open files", 14) != 0) continue;
+        char *end = NULL;
+        long v = strtol(line + 14, &end, 10);
+        if (end != line + 14 && v > 0 && v <= 0x7fffffff) limit = (int)v;
+        break;
+    }
+    fclose(f);
+    return limit;
+}
+
+static void init_proc(ProcLeak *p, int32_t pid, uint64_t start_time, const char *process) {
+    memset(p, 0, sizeof(*p));
+    p->pid = pid;
+    p->start_time = start_time;
+    snprintf(p->process, sizeof(p->process), "%s", process);
+    p->fd_limit = read_fd_limit(pid);
+}
+
+static ProcLeak *add_proc(int32_t pid, const char *process) {
+    if (proc_count == proc_cap) {
+        int new_cap = proc_cap ? proc_cap * 2 : 64;
+        ProcLeak *tmp = realloc(procs, sizeof(ProcLeak) * new_cap);
+        if (!tmp) return NULL;
+        procs = tmp;
+        proc_cap = new_cap;
+    }
+    if ((proc_count + 1) * 2 > slot_cap && index_rebuild(proc_count + 1) != 0) return NULL;
+    ProcLeak *p = &procs[proc_count];
+    init_proc(p, pid, read_start_time(pid), process);
+    index_put(proc_count++);
+    return p;
+}
+
+static void visit_fd_count(int32_t pid, int fd_count, void *ctx) {
+    (void)ctx;
+    int idx = find_proc(pid);
+    if (idx >= 0 && procs[idx].last_gen == generation) procs[idx].fds = fd_count;
+}
+
+static void trend_update(LeakTrend *t, int value, double dt_sec, int first) {
+    if (first) {
+        t->level = value;
+        t->run = 0;
+        t->run_start = value;
+        t->rate = 0;
+        return;
+    }
+    double prev = t->level;
+    t->level = LEAK_ALPHA * value + (1 - LEAK_ALPHA) * prev;
+    if (dt_sec > 0) t->rate = LEAK_ALPHA * (t->level - prev) / dt_sec + (1 - LEAK_ALPHA) * t->rate;
+    if (t->level < prev) {
+        t->run = 0;
+        t->run_start = t->level;
+    } else {
+        t->run++;
+    }
+}
+
+static int trend_sustained(const LeakTrend *t) {
+    return t->run >= LEAK_MIN_RUN && t->level - t->run_start >= LEAK_MIN_GROWTH && t->rate > 0;
+}
+
+static int leak_worse(const ProcLeak *a, const ProcLeak *b) {
+    if ((a->flags != 0) != (b->flags != 0)) return a->flags != 0;
+    if (a->fd_trend.rate != b->fd_trend.rate) return a->fd_trend.rate > b->fd_trend.rate;
+    if (a->cw_trend.rate != b->cw_trend.rate) return a->cw_trend.rate > b->cw_trend.rate;
+    return a->sockets > b->sockets;
+}
+
+int leak_watch_update(const ConnectionInfo *conns, int count, int64_t now_ms) {
+    generation++;
+
+    // 1. 按进程累计本轮的套接字与 CLOSE_WAIT（折叠行按成员数计）
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        if (c->pid <= 0) continue;
+        int idx = find_proc(c->pid);
+        ProcLeak *p = idx >= 0 ? &procs[idx] : add_proc(c->pid, c->process);
+        if (!p) continue;
+        if (p->last_gen != generation) {
+            // 缺席后重新出现：启动时间不同说明 pid 已被复用，按新进程重新计
+            if (p->last_gen != 0 && p->last_gen + 1 != generation) {
+                uint64_t st = read_start_time(p->pid);
+                if (st != p->start_time) init_proc(p, p->pid, st, c->process);
+            }
+            p->sockets = 0;
+            p->close_wait = 0;
+            p->fds = -1;
+            p->last_gen = generation;
+        }
+        p->sockets++;
+        if (c->status_enum == CONN_STATUS_CLOSE_WAIT) p->close_wait++;
+    }
+
+    // 2. fd 总数取自扫描器建立 inode 索引时的计数
+    scanner_visit_fd_counts(visit_fd_count, NULL);
+
+    // 3. 更新趋势与标记，淘汰已退出的进程
+    int flagged = 0, kept = 0;
+    for (int i = 0; i < proc_count; i++) {
+        ProcLeak *p = &procs[i];
+        if (p->last_gen != generation) {
+            if (generation - p->last_gen > LEAK_GRACE) continue;
+        } else {
+            int first = p->history_len == 0;
+            double dt = (double)(now_ms - p->last_ms) / 1000.0;
+            int value = p->fds >= 0 ? p->fds : p->sockets;
+            trend_update(&p->fd_trend, value, dt, first);
+            trend_update(&p->cw_trend, p->close_wait, dt, first);
+            p->history[p->history_pos] = (uint32_t)value;
+            p->history_pos = (p->history_pos + 1) % LEAK_HISTORY_LEN;
+            if (p->history_len < LEAK_HISTORY_LEN) p->history_len++;
+            if (++p->limit_age >= LEAK_LIMIT_REFRESH) {
+                p->fd_limit = read_fd_limit(p->pid);
+                p->limit_age = 0;
+            }
+            p->flags = (trend_sustained(&p->fd_trend) ? LEAK_FLAG_FDS : 0) |
+                       (trend_sustained(&p->cw_trend) ? LEAK_FLAG_CLOSE_WAIT : 0);
+            if (p->flags) flagged++;
+            p->last_ms = now_ms;
+        }
+        if (kept != i) procs[kept] = *p;
+        kept++;
+    }
+    proc_count = kept;
+    if (index_rebuild(proc_count) != 0) proc_count = 0;
+
+    // 4. 排名缓存（只含本轮出现的进程）
+    ranked_count = 0;
+    for (int i = 0; i < proc_count; i++) {
+        const ProcLeak *p = &procs[i];
+        if (p->last_gen != generation) continue;
+        int j = ranked_count < LEAK_RANK_MAX ? ranked_count++ : LEAK_RANK_MAX;
+        if (j == LEAK_RANK_MAX && !leak_worse(p, ranked[LEAK_RANK_MAX - 1])) continue;
+        if (j == LEAK_RANK_MAX) j = LEAK_RANK_MAX - 1;
+        while (j > 0 && leak_worse(p, ranked[j - 1])) {
+            ranked[j] = ranked[j - 1];
+            j--;
+        }
+        ranked[j] = p;
+    }
+    return flagged;
+}
+
+int leak_watch_ranked(const ProcLeak **out, int max) {
+    int n = ranked_count < max ? ranked_count : max;
+    for (int i = 0; i < n; i++) out[i] = ranked[i];
+    return n;
+}
+
+int leak_watch_is_leaking(int32_t pid) {
+    int idx = find_proc(pid);
+    return idx >= 0 && procs[idx].last_gen == generation && procs[idx].flags != 0;
+}
+
+int leak_watch_eta_sec(const ProcLeak *p) {
+    if (p->fd_limit <= 0 || p->fds < 0 || p->fd_trend.rate <= 0) return -1;
+    if (p->fds >= p->fd_limit) return 0;
+    double eta = (p->fd_limit - p->fds) / p->fd_trend.rate;
+    return eta > 0x7fffffff ? 0x7fffffff : (int)eta;
+}
@@ -0,0 +1,60 @@
+#ifndef LEAK_WATCH_H
+#define LEAK_WATCH_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 套接字泄漏检测：按进程（PID + 启动时间）跟踪 fd 总数、套接字数与 CLOSE_WAIT 数，
+// 以 /proc/<pid>/limits 的 "Max open files" 软限制为上限。每个指标维护 O(1) 的在线趋势：
+// 取值的指数平滑水平、水平连续不下降的轮数与本段增长量、增长速率的滑动平均；
+// 平滑后持续单调增长时告警并预估到达上限的时间（正常业务的连接数起落通常不会触发）
+
+#define LEAK_HISTORY_LEN 30        // 每个进程保留的历史轮数
+#define LEAK_MIN_RUN 15            // 连续不下降至少该轮数才算持续增长
+#define LEAK_MIN_GROWTH 20         // 且本段增长不少于该数量
+#define LEAK_ALPHA 0.2             // 水平与增长速率滑动平均的权重
+#define LEAK_LIMIT_REFRESH 30      // 每隔该轮数重读一次 limits（prlimit 可能在运行中调整）
+#define LEAK_GRACE 2               // 连续缺席超过该轮数即淘汰
+
+#define LEAK_FLAG_FDS        0x1   // fd 总数（无法读取 fd 表时为套接字数）持续增长
+#define LEAK_FLAG_CLOSE_WAIT 0x2   // CLOSE_WAIT 持续堆积（应用未 close 对端已关闭的连接）
+
+typedef struct {
+    double level;                  // 取值的指数平滑水平
+    int run;                       // 水平连续不下降的轮数
+    double run_start;              // 本段开始时的水平
+    double rate;                   // 水平每秒增长量的滑动平均
+} LeakTrend;
+
+typedef struct {
+    int32_t pid;
+    uint64_t start_time;           // /proc/<pid>/stat 第 22 项（开机以来的时钟滴答），与 pid 一起标识进程
+    char process[32];
+    int sockets;                   // 本轮持有的套接字数
+    int close_wait;
+    int fds;                       // fd 总数，未知时为 -1
+    int fd_limit;                  // 软限制，未知或无限制时为 -1
+    LeakTrend fd_trend;            // fds 已知时跟踪 fds，否则跟踪 sockets
+    LeakTrend cw_trend;
+    uint32_t history[LEAK_HISTORY_LEN];  // fd_trend 的取值，环形
+    int history_pos;
+    int history_len;
+    int flags;                     // LEAK_FLAG_*
+    int limit_age;                 // 距上次读取 limits 的轮数
+    int64_t last_ms;
+    uint32_t last_gen;
+} ProcLeak;
+
+// 每轮扫描后调用（now_ms 为 Unix 毫秒），返回被标记的进程数
+int leak_watch_update(const ConnectionInfo *conns, int count, int64_t now_ms);
+
+// 取得最值得关注的至多 max 个进程（被标记的在前，其余按增长速率），返回数量
+int leak_watch_ranked(const ProcLeak **out, int max);
+
+// 该 pid 当前是否被标记
+int leak_watch_is_leaking(int32_t pid);
+
+// 按 fd 增长速率预估到达上限的秒数；上限未知或未在增长时返回 -1
+int leak_watch_eta_sec(const ProcLeak *p);
+
+#endif // LEAK_WATCH_H
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <string.h>
+#include "lib/listen_watch.h"
+
+static ListenerPressure listeners[LISTEN_WATCH_MAX];
+static int listener_count = 0;
+static uint32_t generation = 0;
+
+// 本地端口 -> 监听下标；port_gen 不等于当前轮次的端口视为无主，免去每轮清表
+static uint32_t port_gen[65536];
+static uint16_t port_owner[65536];
+
+double listen_fill_ratio(const ListenerPressure *l) {
+    if (l->backlog == 0) return 0;
+    double r = (double)l->accept_queue / (double)l->backlog;
+    return r > 1.0 ? 1.0 : r;
+}
+
+static ListenerPressure *find_or_add(uint32_t ip, uint16_t port) {
+    for (int i = 0; i < listener_count; i++) {
+        if (listeners[i].ip == ip && listeners[i].port == port) return &listeners[i];
+    }
+    if (listener_count == LISTEN_WATCH_MAX) return NULL;
+    ListenerPressure *l = &listeners[listener_count++];
+    memset(l, 0, sizeof(*l));
+    l->ip = ip;
+    l->port = port;
+    return l;
+}
+
+void listen_watch_update(const ConnectionInfo *conns, int count) {
+    generation++;
+
+    // 1. 登记本轮的监听套接字（监听数量有限，线性查找即可）
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        uint32_t ip;
+        uint16_t port;
+        if (c->status_enum != CONN_STATUS_LISTEN || parse_ipv4_endpoint(c->local_addr, &ip, &port) != 0) continue;
+        ListenerPressure *l = find_or_add(ip, port);
+        if (!l) continue;
+        snprintf(l->local_addr, sizeof(l->local_addr), "%s", c->local_addr);
+        snprintf(l->process, sizeof(l->process), "%s", c->process);
+        l->pid = c->pid;
+        l->accept_queue = c->rx_queue;
+        l->backlog = c->backlog;
+        if (c->rx_queue > l->peak_accept_queue) l->peak_accept_queue = c->rx_queue;
+        l->children = 0;
+        l->child_rx_queue = 0;
+        l->child_tx_queue = 0;
+        l->last_gen = generation;
+        port_gen[port] = generation;
+        port_owner[port] = (uint16_t)(l - listeners);
+    }
+
+    // 2. 已建立连接按本地端口归属到监听，累计收发队列
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        uint32_t ip;
+        uint16_t port;
+        if (c->status_enum == CONN_STATUS_LISTEN || strcmp(c->protocol, "TCP") != 0) continue;
+        if (parse_ipv4_endpoint(c->local_addr, &ip, &port) != 0 || port_gen[port] != generation) continue;
+        ListenerPressure *l = &listeners[port_owner[port]];
+        l->children++;
+        l->child_rx_queue += c->rx_queue;
+        l->child_tx_queue += c->tx_queue;
+    }
+
+    // 3. 记录历史并淘汰久未出现的监听（保持数组紧凑）
+    int kept = 0;
+    for (int i = 0; i < listener_count; i++) {
+        ListenerPressure *l = &listeners[i];
+        if (l->last_gen + LISTEN_WATCH_GRACE < generation) continue;
+        if (l->last_gen == generation) {
+            l->fill_history[l->history_pos] = (uint8_t)(listen_fill_ratio(l) * 100.0 + 0.5);
+            uint64_t q = l->child_rx_queue + l->child_tx_queue;
+            l->queue_history[l->history_pos] = q > UINT32_MAX ? UINT32_MAX : (uint32_t)q;
+            l->history_pos = (l->history_pos + 1) % LISTEN_HISTORY_LEN;
+            if (l->history_len < LISTEN_HISTORY_LEN) l->history_len++;
+        }
+        if (kept != i) listeners[kept] = *l;
+        kept++;
+    }
+    listener_count = kept;
+}
+
+static int pressure_worse(const ListenerPressure *a, const ListenerPressure *b) {
+    double fa = listen_fill_ratio(a), fb = listen_fill_ratio(b);
+    if (fa != fb) return fa > fb;
+    return a->child_rx_queue + a->child_tx_queue > b->child_rx_queue + b->child_tx_queue;
+}
+
+int listen_watch_ranked(const ListenerPressure **out, int max) {
+    int n = 0;
+    for (int i = 0; i < listener_count; i++) {
+        const ListenerPressure *l = &listeners[i];
+        if (l->last_gen != generation) continue;
+        int j = n < max ? n++ : max;
+        if (j == max && !pressure_worse(l, out[max - 1])) continue;
+        if (j == max) j = max - 1;
+        while (j > 0 && pressure_worse(l, out[j - 1])) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = l;
+    }
+    return n;
+}
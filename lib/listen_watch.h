@@ -0,0 +1,42 @@
+#ifndef LISTEN_WATCH_H
+#define LISTEN_WATCH_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 监听端口压力跟踪：accept 队列占用率、该端口上已建立连接的收发队列积压，以及最近若干轮的历史
+// 表为定长数组，每轮 O(N) 更新，不做堆分配
+
+#define LISTEN_WATCH_MAX 256       // 最多跟踪的监听套接字数
+#define LISTEN_HISTORY_LEN 30      // 每个监听保留的历史轮数
+#define LISTEN_WATCH_GRACE 3       // 连续缺席超过该轮数即淘汰
+
+typedef struct {
+    uint32_t ip;                   // 网络字节序
+    uint16_t port;
+    char local_addr[32];
+    char process[32];
+    int32_t pid;
+    uint32_t accept_queue;         // 当前 accept 队列长度
+    uint32_t backlog;              // backlog 上限（sock_diag 不可用时为 0）
+    uint32_t peak_accept_queue;    // 跟踪期间的最大 accept 队列长度
+    int children;                  // 本地端口与之相同的非 LISTEN 连接数
+    uint64_t child_rx_queue;       // 这些连接的接收队列字节合计（应用读得慢）
+    uint64_t child_tx_queue;       // 发送队列字节合计（对端收得慢）
+    uint8_t fill_history[LISTEN_HISTORY_LEN];    // accept 队列占用百分比，环形
+    uint32_t queue_history[LISTEN_HISTORY_LEN];  // child_rx_queue + child_tx_queue，环形
+    int history_pos;               // 下一次写入位置
+    int history_len;
+    uint32_t last_gen;
+} ListenerPressure;
+
+// 每轮扫描后调用（conns 中的 LISTEN 行应已由 sock_diag_fill_listen_backlog 补全 backlog）
+void listen_watch_update(const ConnectionInfo *conns, int count);
+
+// 取得压力最大的至多 max 个监听（先比 accept 队列占用率，再比队列积压），返回数量
+int listen_watch_ranked(const ListenerPressure **out, int max);
+
+// accept 队列占用率（0..1），backlog 未知时返回 0
+double listen_fill_ratio(const ListenerPressure *l);
+
+#endif // LISTEN_WATCH_H
@@ -1,12 +1,38 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif
 #include "backend/scanner.h"
+#include "lib/arena.h"
 
 // 常用端口白名单 (移植自 Go 版)
 static const int COMMON_PORTS[] = {80, 443, 22, 21, 25, 53, 3306, 5432, 6379, 8080, 8443, 9000, 27017, 5000};
 static const int COMMON_PORTS_COUNT = sizeof(COMMON_PORTS) / sizeof(COMMON_PORTS[0]);
 
+// 状态名称表（与 ConnectionStatus 枚举顺序一致）
+static const char *STATUS_NAMES[] = {
+    "ESTABLISHED", "LISTEN", "TIME_WAIT", "CLOSE_WAIT", "SYN_SENT", "SYN_RECV",
+    "FIN_WAIT1", "FIN_WAIT2", "CLOSE", "CLOSING", "LAST_ACK", "NONE", "UNKNOWN"
+};
+
+// 状态枚举转字符串
+const char* conn_status_name(ConnectionStatus status) {
+    if (status < 0 || status > CONN_STATUS_UNKNOWN) return "UNKNOWN";
+    return STATUS_NAMES[status];
+}
+
+// 状态字符串转枚举（不区分大小写），无法识别时返回 CONN_STATUS_UNKNOWN
+ConnectionStatus conn_status_from_name(const char *name) {
+    for (int i = 0; i < CONN_STATUS_UNKNOWN; i++) {
+        if (strcasecmp(name, STATUS_NAMES[i]) == 0) return (ConnectionStatus)i;
+    }
+    return CONN_STATUS_UNKNOWN;
+}
+
 // 判断是否为内部回环地址
 int is_internal(const char *addr) {
     return (strncmp(addr, "127.0.0.1", 9) == 0 || 
@@ -16,6 +42,28 @@ int is_internal(const char *addr) {
             strncmp(addr, "0.0.0.0", 7) == 0);
 }
 
+// 解析 "a.b.c.d:port" 形式的地址，IP 以网络字节序输出；失败返回 -1
+// 手写逐字符解析（避免 sscanf），查询/导出等路径会对每行调用
+int parse_ipv4_endpoint(const char *addr, uint32_t *ip, uint16_t *port) {
+    unsigned char octets[4];
+    const char *p = addr;
+    for (int i = 0; i < 4; i++) {
+        unsigned int v = 0;
+        int digits = 0;
+        while (*p >= '0' && *p <= '9' && digits < 3) { v = v * 10 + (unsigned int)(*p++ - '0'); digits++; }
+        if (digits == 0 || v > 255) return -1;
+        if (*p++ != (i < 3 ? '.' : ':')) return -1;
+        octets[i] = (unsigned char)v;
+    }
+    unsigned int pv = 0;
+    int digits = 0;
+    while (*p >= '0' && *p <= '9' && digits < 5) { pv = pv * 10 + (unsigned int)(*p++ - '0'); digits++; }
+    if (digits == 0 || *p != '\0' || pv > 65535) return -1;
+    memcpy(ip, octets, 4);
+    *port = (uint16_t)pv;
+    return 0;
+}
+
 // 判断是否为外部连接（排除本地连接）
 int is_external_connection(const ConnectionInfo *conn) {
     return !is_internal(conn->remote_addr);
@@ -58,16 +106,35 @@ int is_suspicious(const ConnectionInfo *conn) {
     return 1;
 }
 
+// 进程名计数表：开放寻址，键直接指向 conns 中的进程名；表在 stats_arena 中分配，每次调用复位
+typedef struct {
+    const char *name;    // NULL 表示空槽
+    int count;
+    int order;           // 首次出现的次序，计数相同时取后出现的进程（与原链表头插法一致）
+} ProcCount;
+
+static Arena stats_arena;
+
+static uint32_t name_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) h = (h ^ (unsigned char)*s) * 16777619u;
+    return h;
+}
+
+static ProcCount *proc_slot(ProcCount *slots, size_t cap, const char *name, uint32_t h) {
+    size_t pos = h & (cap - 1);
+    while (slots[pos].name && strcmp(slots[pos].name, name) != 0) pos = (pos + 1) & (cap - 1);
+    return &slots[pos];
+}
+
 void calculate_stats(const ConnectionInfo *conns, int count, ConnectionStats *stats) {
     memset(stats, 0, sizeof(ConnectionStats));
     stats->total = count;
-    
-    // 用于统计进程名分布
-    struct ProcNode {
-        char name[256];
-        int count;
-        struct ProcNode *next;
-    } *head = NULL;
+
+    // 用于统计进程名分布；装载超过一半时在区域中换一张两倍大的表
+    arena_reset(&stats_arena);
+    size_t cap = 256, used = 0;
+    ProcCount *slots = arena_calloc(&stats_arena, sizeof(ProcCount) * cap);
 
     for (int i = 0; i < count; i++) {
         if (conns[i].status_enum == CONN_STATUS_ESTABLISHED) stats->established++;
@@ -75,37 +142,187 @@ void calculate_stats(const ConnectionInfo *conns, int count, ConnectionStats *st
         if (is_suspicious(&conns[i])) stats->suspicious++;
 
         // 统计进程活跃度（仅对活跃连接进行统计）
-        if (conns[i].status_enum == CONN_STATUS_ESTABLISHED && strcmp(conns[i].process, "N/A") != 0) {
-            struct ProcNode *curr = head;
-            while (curr) {
-                if (strcmp(curr->name, conns[i].process) == 0) {
-                    curr->count++;
-                    break;
-                }
-                curr = curr->next;
+        if (!slots || conns[i].status_enum != CONN_STATUS_ESTABLISHED || strcmp(conns[i].process, "N/A") == 0) continue;
+        uint32_t h = name_hash(conns[i].process);
+        ProcCount *p = proc_slot(slots, cap, conns[i].process, h);
+        if (p->name) {
+            p->count++;
+            continue;
+        }
+        p->name = conns[i].process;
+        p->count = 1;
+        p->order = (int)used++;
+        if (used * 2 > cap) {
+            ProcCount *ns = arena_calloc(&stats_arena, sizeof(ProcCount) * cap * 2);
+            if (!ns) {
+                slots = NULL;
+                continue;
             }
-            if (!curr) {
-                struct ProcNode *new_node = malloc(sizeof(struct ProcNode));
-                strcpy(new_node->name, conns[i].process);
-                new_node->count = 1;
-                new_node->next = head;
-                head = new_node;
+            for (size_t k = 0; k < cap; k++) {
+                if (slots[k].name) *proc_slot(ns, cap * 2, slots[k].name, name_hash(slots[k].name)) = slots[k];
             }
+            slots = ns;
+            cap *= 2;
+        }
+    }
+
+    // 最活跃的若干进程：插入排序，计数相同时后出现的在前
+    const ProcCount *top[STATS_TOP_PROCS];
+    int n = 0;
+    for (size_t k = 0; slots && k < cap; k++) {
+        const ProcCount *p = &slots[k];
+        if (!p->name) continue;
+        int j = n < STATS_TOP_PROCS ? n++ : STATS_TOP_PROCS;
+        while (j > 0 && (top[j - 1]->count < p->count || (top[j - 1]->count == p->count && top[j - 1]->order < p->order))) {
+            if (j < STATS_TOP_PROCS) top[j] = top[j - 1];
+            j--;
         }
+        if (j < STATS_TOP_PROCS) top[j] = p;
+    }
+    for (int i = 0; i < n; i++) {
+        snprintf(stats->top_procs[i].name, sizeof(stats->top_procs[i].name), "%.*s",
+                 (int)sizeof(stats->top_procs[i].name) - 1, top[i]->name);
+        stats->top_procs[i].count = top[i]->count;
+    }
+    stats->top_proc_count = n;
+    if (n > 0) {
+        stats->top_process_count = top[0]->count;
+        snprintf(stats->top_process, sizeof(stats->top_process), "%s", top[0]->name);
+    } else {
+        strcpy(stats->top_process, "-");
+    }
+}
+
+// ---- 行折叠 ----
+
+#define COLLAPSE_EXPANDED_MAX 16
+
+typedef struct {
+    uint32_t hash;
+    int idx;             // -1 表示空槽
+} GroupSlot;
+
+typedef struct {
+    char process[256];       // 与 ConnectionInfo 同长，按完整字段匹配
+    char remote_addr[128];
+    ConnectionStatus status;
+} GroupKey;
+
+static int collapse_on = 0;
+static GroupSlot *group_slots = NULL;
+static size_t group_cap = 0;
+static size_t group_used = 0;
+static GroupKey expanded[COLLAPSE_EXPANDED_MAX];
+static int expanded_count = 0;
+
+void conn_collapse_enable(int on) { collapse_on = on; }
+int conn_collapse_enabled(void) { return collapse_on; }
+
+static void collapse_begin(void) {
+    for (size_t i = 0; i < group_cap; i++) group_slots[i].idx = -1;
+    group_used = 0;
+}
+
+static uint32_t group_hash(const ConnectionInfo *c) {
+    uint32_t h = 2166136261u;
+    for (const char *p = c->process; *p; p++) h = (h ^ (unsigned char)*p) * 16777619u;
+    h = (h ^ 0xFF) * 16777619u;
+    for (const char *p = c->remote_addr; *p; p++) h = (h ^ (unsigned char)*p) * 16777619u;
+    return (h ^ (uint32_t)c->status_enum) * 16777619u;
+}
+
+static int same_group(const ConnectionInfo *a, const ConnectionInfo *b) {
+    return a->status_enum == b->status_enum && strcmp(a->remote_addr, b->remote_addr) == 0 &&
+           strcmp(a->process, b->process) == 0;
+}
+
+static int key_matches(const GroupKey *k, const ConnectionInfo *c) {
+    return k->status == c->status_enum && strncmp(k->remote_addr, c->remote_addr, sizeof(k->remote_addr)) == 0 &&
+           strncmp(k->process, c->process, sizeof(k->process)) == 0;
+}
+
+int conn_collapse_is_expanded(const ConnectionInfo *row) {
+    for (int i = 0; i < expanded_count; i++) if (key_matches(&expanded[i], row)) return 1;
+    return 0;
+}
+
+int conn_collapse_toggle_expand(const ConnectionInfo *row) {
+    for (int i = 0; i < expanded_count; i++) {
+        if (!key_matches(&expanded[i], row)) continue;
+        expanded[i] = expanded[--expanded_count];
+        return 0;
+    }
+    // 已满时替换最早展开的分组
+    if (expanded_count == COLLAPSE_EXPANDED_MAX) {
+        memmove(&expanded[0], &expanded[1], sizeof(GroupKey) * (COLLAPSE_EXPANDED_MAX - 1));
+        expanded_count--;
     }
+    GroupKey *k = &expanded[expanded_count++];
+    snprintf(k->process, sizeof(k->process), "%s", row->process);
+    snprintf(k->remote_addr, sizeof(k->remote_addr), "%s", row->remote_addr);
+    k->status = row->status_enum;
+    return 1;
+}
+
+static int group_grow(void) {
+    size_t new_cap = group_cap ? group_cap * 2 : 1024;
+    GroupSlot *ns = malloc(sizeof(GroupSlot) * new_cap);
+    if (!ns) return -1;
+    for (size_t i = 0; i < new_cap; i++) ns[i].idx = -1;
+    for (size_t i = 0; i < group_cap; i++) {
+        if (group_slots[i].idx < 0) continue;
+        size_t pos = group_slots[i].hash & (new_cap - 1);
+        while (ns[pos].idx >= 0) pos = (pos + 1) & (new_cap - 1);
+        ns[pos] = group_slots[i];
+    }
+    free(group_slots);
+    group_slots = ns;
+    group_cap = new_cap;
+    return 0;
+}
 
-    // 寻找最活跃进程
-    struct ProcNode *curr = head;
-    while (curr) {
-        if (curr->count > stats->top_process_count) {
-            stats->top_process_count = curr->count;
-            strcpy(stats->top_process, curr->name);
+// conns[idx] 能并入已有分组时合并并返回 1（调用方丢弃该行），否则登记为新分组返回 0
+static int collapse_merge(ConnectionInfo *conns, int idx) {
+    ConnectionInfo *c = &conns[idx];
+    uint32_t ip;
+    uint16_t rport, lport;
+    c->group_count = 1;
+    if (!collapse_on) return 0;
+    if (parse_ipv4_endpoint(c->remote_addr, &ip, &rport) != 0 || rport == 0) return 0;
+    if (parse_ipv4_endpoint(c->local_addr, &ip, &lport) != 0) return 0;
+    if (expanded_count > 0 && conn_collapse_is_expanded(c)) return 0;
+    if ((group_used + 1) * 2 > group_cap && group_grow() != 0) return 0;
+
+    uint32_t h = group_hash(c);
+    size_t pos = h & (group_cap - 1);
+    while (group_slots[pos].idx >= 0) {
+        ConnectionInfo *g = &conns[group_slots[pos].idx];
+        if (group_slots[pos].hash == h && same_group(g, c)) {
+            g->group_count++;
+            if (lport < g->group_port_min) g->group_port_min = lport;
+            if (lport > g->group_port_max) g->group_port_max = lport;
+            g->rx_queue = g->rx_queue + c->rx_queue < g->rx_queue ? UINT32_MAX : g->rx_queue + c->rx_queue;
+            g->tx_queue = g->tx_queue + c->tx_queue < g->tx_queue ? UINT32_MAX : g->tx_queue + c->tx_queue;
+            return 1;
         }
-        struct ProcNode *tmp = curr;
-        curr = curr->next;
-        free(tmp);
+        pos = (pos + 1) & (group_cap - 1);
     }
-    if (stats->top_process_count == 0) strcpy(stats->top_process, "-");
+    group_slots[pos].hash = h;
+    group_slots[pos].idx = idx;
+    group_used++;
+    c->group_port_min = c->group_port_max = lport;
+    return 0;
+}
+
+int conn_collapse_rows(ConnectionInfo *conns, int count) {
+    if (!collapse_on) return count;
+    collapse_begin();
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (n != i) conns[n] = conns[i];
+        if (!collapse_merge(conns, n)) n++;
+    }
+    return n;
 }
 
 // 排序比较函数
@@ -121,6 +338,13 @@ static int cmp_remote(const void *a, const void *b) {
     return strcmp(((ConnectionInfo*)a)->remote_addr, ((ConnectionInfo*)b)->remote_addr);
 }
 
+// 按连接年龄排序：最早出现的排在前面，未跟踪（0）的排在最后
+static int cmp_age(const void *a, const void *b) {
+    int64_t fa = ((ConnectionInfo*)a)->first_seen, fb = ((ConnectionInfo*)b)->first_seen;
+    if (fa == 0 || fb == 0) return (fa == 0) - (fb == 0);
+    return (fa > fb) - (fa < fb);
+}
+
 void sort_connections(ConnectionInfo *conns, int count, SortMode mode) {
     if (mode == SORT_NONE || count <= 1) return;
     
@@ -129,8 +353,99 @@ void sort_connections(ConnectionInfo *conns, int count, SortMode mode) {
         case SORT_BY_PID:     cmp = cmp_pid; break;
         case SORT_BY_PROCESS: cmp = cmp_process; break;
         case SORT_BY_REMOTE:  cmp = cmp_remote; break;
+        case SORT_BY_AGE:     cmp = cmp_age; break;
         default: return;
     }
     
     if (cmp) qsort(conns, count, sizeof(ConnectionInfo), cmp);
 }
+
+// 按 PID 聚合 tcp_info 速率，返回吞吐最高的至多 max 个进程（降序）
+int top_process_rates(const ConnectionInfo *conns, int count, ProcessRate *out, int max, Arena *scratch) {
+    size_t cap = 64;
+    while (cap < (size_t)count * 2) cap <<= 1;
+    ProcessRate *slots = arena_calloc(scratch, sizeof(ProcessRate) * cap);
+    if (!slots) return 0;
+
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        if (!c->tcp.valid || c->pid <= 0) continue;
+        size_t pos = ((uint32_t)c->pid * 2654435761u) & (cap - 1);
+        while (slots[pos].process && slots[pos].pid != c->pid) pos = (pos + 1) & (cap - 1);
+        slots[pos].process = c->process;
+        slots[pos].pid = c->pid;
+        slots[pos].conns += c->group_count > 1 ? c->group_count : 1;
+        slots[pos].tx_rate += c->tcp.tx_rate;
+        slots[pos].rx_rate += c->tcp.rx_rate;
+    }
+
+    // 插入法维护前 max 名
+    int n = 0;
+    for (size_t i = 0; i < cap; i++) {
+        if (!slots[i].process) continue;
+        double total = slots[i].tx_rate + slots[i].rx_rate;
+        if (total <= 0) continue;
+        int j = n < max ? n++ : max;
+        if (j == max && total <= out[max - 1].tx_rate + out[max - 1].rx_rate) continue;
+        if (j == max) j = max - 1;
+        while (j > 0 && out[j - 1].tx_rate + out[j - 1].rx_rate < total) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = slots[i];
+    }
+    return n;
+}
+
+const char* tcp_ca_state_name(uint8_t ca_state) {
+    static const char *names[] = { "Open", "Disorder", "CWR", "Recovery", "Loss" };
+    return ca_state < sizeof(names) / sizeof(names[0]) ? names[ca_state] : "?";
+}
+
+// 按远端 /24 聚合 RTT 与重传，返回最差的至多 max 个前缀（先比重传速率，再比平均 RTT）
+static int prefix_worse(const PrefixHealth *a, const PrefixHealth *b) {
+    if (a->retrans_rate != b->retrans_rate) return a->retrans_rate > b->retrans_rate;
+    return a->avg_rtt_us > b->avg_rtt_us;
+}
+
+int top_prefix_health(const ConnectionInfo *conns, int count, PrefixHealth *out, int max, Arena *scratch) {
+    size_t cap = 64;
+    while (cap < (size_t)count * 2) cap <<= 1;
+    PrefixHealth *slots = arena_calloc(scratch, sizeof(PrefixHealth) * cap);
+    if (!slots) return 0;
+
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        uint32_t ip;
+        uint16_t port;
+        if (!c->tcp.valid || c->status_enum != CONN_STATUS_ESTABLISHED) continue;
+        if (parse_ipv4_endpoint(c->remote_addr, &ip, &port) != 0) continue;
+        const unsigned char *o = (const unsigned char *)&ip;
+        uint32_t prefix = (uint32_t)o[0] << 24 | (uint32_t)o[1] << 16 | (uint32_t)o[2] << 8;
+        size_t pos = (prefix * 2654435761u) & (cap - 1);
+        while (slots[pos].conns && slots[pos].prefix != prefix) pos = (pos + 1) & (cap - 1);
+        PrefixHealth *p = &slots[pos];
+        p->prefix = prefix;
+        int weight = c->group_count > 1 ? c->group_count : 1; // 折叠行按成员数计
+        p->conns += weight;
+        p->avg_rtt_us += (double)c->tcp.rtt_us * weight; // 先累加，汇总时再求平均
+        if (c->tcp.rtt_us > p->max_rtt_us) p->max_rtt_us = c->tcp.rtt_us;
+        p->retrans_rate += c->tcp.retrans_rate;
+        p->total_retrans += c->tcp.total_retrans;
+    }
+
+    int n = 0;
+    for (size_t i = 0; i < cap; i++) {
+        if (!slots[i].conns) continue;
+        slots[i].avg_rtt_us /= slots[i].conns;
+        int j = n < max ? n++ : max;
+        if (j == max && !prefix_worse(&slots[i], &out[max - 1])) continue;
+        if (j == max) j = max - 1;
+        while (j > 0 && prefix_worse(&slots[i], &out[j - 1])) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = slots[i];
+    }
+    return n;
+}
@@ -0,0 +1,353 @@
+#include "lib/metrics_http.h"
+
+#ifdef _WIN32
+int metrics_http_start(const char *listen_spec) { (void)listen_spec; return -1; }
+void metrics_http_publish(const ConnectionInfo *conns, int count, const ConnectionStats *stats, double scan_ms) {
+    (void)conns; (void)count; (void)stats; (void)scan_ms;
+}
+int metrics_http_fill_fds(fd_set *rfds, fd_set *wfds, int max_fd) { (void)rfds; (void)wfds; return max_fd; }
+void metrics_http_handle(fd_set *rfds, fd_set *wfds) { (void)rfds; (void)wfds; }
+void metrics_http_stop(void) {}
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "lib/strbuf.h"
+#include "lib/phase_timer.h"
+#include "lib/scan_sched.h"
+
+#define METRICS_MAX_CLIENTS 16     // 同时服务的抓取连接上限
+#define METRICS_REQ_MAX 2048       // 请求头最大长度
+#define METRICS_IDLE_NS 5000000000ull  // 连接超过 5 秒无进展即回收，避免空闲连接占满槽位
+
+// 抓取客户端槽位
+typedef struct {
+    int fd;
+    char req[METRICS_REQ_MAX];
+    size_t req_len;
+    StrBuf out;     // 仅在一次 send 未写完时暂存剩余部分
+    size_t out_off;
+    uint64_t active_ns;  // 接受或最近一次收发的时刻（单调时钟）
+} MetricsClient;
+
+// 进程名计数哈希表（开放寻址，跨扫描复用）
+typedef struct {
+    const char *name;
+    int count;
+} ProcSlot;
+
+static int listen_fd = -1;
+static MetricsClient clients[METRICS_MAX_CLIENTS];
+static StrBuf body;             // 最新快照渲染结果
+static ProcSlot *proc_slots = NULL;
+static size_t proc_cap = 0;
+static unsigned long long scans_total = 0;
+
+// OpenMetrics 标签值转义：\ " 与换行
+static void buf_label_value(StrBuf *b, const char *s) {
+    for (; *s; s++) {
+        if (*s == '\\') strbuf_append(b, "\\\\", 2);
+        else if (*s == '"') strbuf_append(b, "\\\"", 2);
+        else if (*s == '\n') strbuf_append(b, "\\n", 2);
+        else strbuf_append(b, s, 1);
+    }
+}
+
+static uint32_t hash_str(const char *s) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+static int set_non_blocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int parse_listen_spec(const char *spec, struct sockaddr_in *sa) {
+    char host[64] = "127.0.0.1";
+    const char *port_str = spec;
+    const char *colon = strrchr(spec, ':');
+    if (colon) {
+        size_t hl = (size_t)(colon - spec);
+        if (hl >= sizeof(host)) return -1;
+        if (hl > 0) {
+            memcpy(host, spec, hl);
+            host[hl] = '\0';
+        }
+        port_str = colon + 1;
+    }
+    char *end = NULL;
+    long port = strtol(port_str, &end, 10);
+    if (!end || *end != '\0' || port <= 0 || port > 65535) return -1;
+
+    memset(sa, 0, sizeof(*sa));
+    sa->sin_family = AF_INET;
+    sa->sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &sa->sin_addr) != 1) return -1;
+    return 0;
+}
+
+int metrics_http_start(const char *listen_spec) {
+    struct sockaddr_in sa;
+    if (parse_listen_spec(listen_spec, &sa) != 0) {
+        fprintf(stderr, "Error: invalid --metrics-listen address: %s\n", listen_spec);
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) == -1 || listen(fd, 16) == -1 || set_non_blocking(fd) == -1) {
+        fprintf(stderr, "Error: cannot listen on %s: %s\n", listen_spec, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) clients[i].fd = -1;
+    listen_fd = fd;
+    // 首次扫描前的抓取也返回合法（空）文档
+    strbuf_printf(&body, "# EOF\n");
+    return 0;
+}
+
+// 每状态计数 + 每进程计数 + 总体统计，O(N) 渲染
+void metrics_http_publish(const ConnectionInfo *conns, int count, const ConnectionStats *stats, double scan_ms) {
+    if (listen_fd == -1) return;
+    scans_total++;
+
+    int by_state[CONN_STATUS_COUNT] = {0};
+
+    // 哈希表容量保持为 2 的幂且不低于 2 倍元素数
+    size_t need = 16;
+    while (need < (size_t)count * 2) need <<= 1;
+    if (need > proc_cap) {
+        ProcSlot *tmp = realloc(proc_slots, sizeof(ProcSlot) * need);
+        if (tmp) {
+            proc_slots = tmp;
+            proc_cap = need;
+        }
+    }
+    if (proc_slots) memset(proc_slots, 0, sizeof(ProcSlot) * proc_cap);
+
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        if (c->status_enum >= 0 && c->status_enum < CONN_STATUS_COUNT) by_state[c->status_enum]++;
+        if (!proc_slots || strcmp(c->process, "N/A") == 0) continue;
+
+        size_t mask = proc_cap - 1;
+        size_t pos = hash_str(c->process) & mask;
+        while (proc_slots[pos].name && strcmp(proc_slots[pos].name, c->process) != 0) pos = (pos + 1) & mask;
+        if (!proc_slots[pos].name) proc_slots[pos].name = c->process;
+        proc_slots[pos].count++;
+    }
+
+    body.len = 0;
+    strbuf_printf(&body, "# HELP ncm_connections Number of sockets in the latest scan.\n"
+                         "# TYPE ncm_connections gauge\n"
+                         "ncm_connections %d\n", stats->total);
+    strbuf_printf(&body, "# HELP ncm_connections_established Established TCP connections.\n"
+                         "# TYPE ncm_connections_established gauge\n"
+                         "ncm_connections_established %d\n", stats->established);
+    strbuf_printf(&body, "# HELP ncm_connections_listening Listening sockets.\n"
+                         "# TYPE ncm_connections_listening gauge\n"
+                         "ncm_connections_listening %d\n", stats->listening);
+    strbuf_printf(&body, "# HELP ncm_connections_suspicious Connections flagged by risk rules.\n"
+                         "# TYPE ncm_connections_suspicious gauge\n"
+                         "ncm_connections_suspicious %d\n", stats->suspicious);
+    strbuf_printf(&body, "# HELP ncm_connections_stuck Connections held in one state past its --stuck-threshold.\n"
+                         "# TYPE ncm_connections_stuck gauge\n"
+                         "ncm_connections_stuck %d\n", stats->stuck);
+    strbuf_printf(&body, "# HELP ncm_ephemeral_port_destinations_at_risk Destinations whose ephemeral port use reached the warning threshold.\n"
+                         "# TYPE ncm_ephemeral_port_destinations_at_risk gauge\n"
+                         "ncm_ephemeral_port_destinations_at_risk %d\n", stats->port_at_risk);
+    strbuf_printf(&body, "# HELP ncm_ephemeral_port_utilization_max Highest ephemeral port utilization of any (local IP, remote IP:port) destination.\n"
+                         "# TYPE ncm_ephemeral_port_utilization_max gauge\n"
+                         "ncm_ephemeral_port_utilization_max %.2f\n", stats->port_util_max / 100.0);
+    strbuf_printf(&body, "# HELP ncm_processes_leaking Processes whose socket fds or CLOSE_WAIT count keep growing.\n"
+                         "# TYPE ncm_processes_leaking gauge\n"
+                         "ncm_processes_leaking %d\n", stats->leaking);
+
+    strbuf_printf(&body, "# HELP ncm_connections_by_state Sockets per TCP state.\n"
+                         "# TYPE ncm_connections_by_state gauge\n");
+    for (int s = 0; s < CONN_STATUS_COUNT; s++) {
+        if (by_state[s] == 0) continue;
+        strbuf_printf(&body, "ncm_connections_by_state{state=\"%s\"} %d\n", conn_status_name((ConnectionStatus)s), by_state[s]);
+    }
+
+    strbuf_printf(&body, "# HELP ncm_process_connections Sockets owned per process name.\n"
+                         "# TYPE ncm_process_connections gauge\n");
+    for (size_t i = 0; proc_slots && i < proc_cap; i++) {
+        if (!proc_slots[i].name) continue;
+        strbuf_printf(&body, "ncm_process_connections{process=\"");
+        buf_label_value(&body, proc_slots[i].name);
+        strbuf_printf(&body, "\"} %d\n", proc_slots[i].count);
+    }
+
+    strbuf_printf(&body, "# HELP ncm_scan_duration_seconds Wall time of the latest scan.\n"
+                         "# TYPE ncm_scan_duration_seconds gauge\n"
+                         "ncm_scan_duration_seconds %.6f\n", scan_ms / 1000.0);
+    strbuf_printf(&body, "# HELP ncm_scans Completed scans.\n"
+                         "# TYPE ncm_scans counter\n"
+                         "ncm_scans_total %llu\n", scans_total);
+    strbuf_printf(&body, "# HELP ncm_last_scan_timestamp_seconds Unix time of the latest scan.\n"
+                         "# TYPE ncm_last_scan_timestamp_seconds gauge\n"
+                         "ncm_last_scan_timestamp_seconds %lld\n", (long long)time(NULL));
+    strbuf_printf(&body, "# HELP ncm_scan_interval_seconds Current interval between scans (adaptive under --cpu-budget).\n"
+                         "# TYPE ncm_scan_interval_seconds gauge\n"
+                         "ncm_scan_interval_seconds %.3f\n", scan_sched_interval_ms() / 1000.0);
+
+    // 分阶段耗时直方图：内部桶更细，这里只导出 16us..16.8s 间每 4 倍一个累积桶
+    const PhaseProcess *pp = phase_process();
+    strbuf_printf(&body, "# HELP ncm_scan_syscalls System calls issued by the latest scan (approximate).\n"
+                         "# TYPE ncm_scan_syscalls gauge\n"
+                         "ncm_scan_syscalls %llu\n", (unsigned long long)pp->syscalls);
+    strbuf_printf(&body, "# HELP process_resident_memory_bytes Resident memory size.\n"
+                         "# TYPE process_resident_memory_bytes gauge\n"
+                         "process_resident_memory_bytes %llu\n", (unsigned long long)pp->rss_bytes);
+    strbuf_printf(&body, "# HELP ncm_phase_duration_seconds Time spent per scan and frame pipeline phase.\n"
+                         "# TYPE ncm_phase_duration_seconds histogram\n");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseHist *h = phase_hist((PhaseId)i);
+        const char *name = phase_name((PhaseId)i);
+        for (int k = 4; k <= 24; k += 2) {
+            strbuf_printf(&body, "ncm_phase_duration_seconds_bucket{phase=\"%s\",le=\"%.6f\"} %llu\n",
+                          name, (double)(1ull << k) / 1e6, (unsigned long long)phase_count_le((PhaseId)i, 1ull << k));
+        }
+        strbuf_printf(&body, "ncm_phase_duration_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n"
+                             "ncm_phase_duration_seconds_sum{phase=\"%s\"} %.6f\n"
+                             "ncm_phase_duration_seconds_count{phase=\"%s\"} %llu\n",
+                      name, (unsigned long long)h->count, name, h->sum_ns / 1e9, name, (unsigned long long)h->count);
+    }
+    strbuf_printf(&body, "# EOF\n");
+}
+
+static void client_close(MetricsClient *c) {
+    close(c->fd);
+    c->fd = -1;
+    c->req_len = 0;
+    c->out.len = 0;
+    c->out_off = 0;
+}
+
+// 尽量一次写完；写不完的部分拷入客户端缓冲区，等待可写事件
+static void client_send(MetricsClient *c, const char *data, size_t len) {
+    ssize_t n = send(c->fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) { client_close(c); return; }
+        n = 0;
+    }
+    if ((size_t)n < len) strbuf_append(&c->out, data + n, len - (size_t)n);
+}
+
+static void client_respond(MetricsClient *c) {
+    char header[256];
+    int is_metrics = (strncmp(c->req, "GET /metrics ", 13) == 0 || strncmp(c->req, "GET /metrics?", 13) == 0);
+    if (!is_metrics) {
+        static const char not_found[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        client_send(c, not_found, sizeof(not_found) - 1);
+    } else {
+        int hl = snprintf(header, sizeof(header),
+                          "HTTP/1.0 200 OK\r\n"
+                          "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                          "Content-Length: %zu\r\n"
+                          "Connection: close\r\n\r\n", body.len);
+        client_send(c, header, (size_t)hl);
+        if (c->fd != -1) {
+            if (c->out.len > 0) strbuf_append(&c->out, body.data, body.len); // 头部都未写完，正文整体排队
+            else client_send(c, body.data, body.len);
+        }
+    }
+    if (c->fd != -1 && c->out.len == 0) client_close(c);
+}
+
+int metrics_http_fill_fds(fd_set *rfds, fd_set *wfds, int max_fd) {
+    if (listen_fd == -1) return max_fd;
+    FD_SET(listen_fd, rfds);
+    if (listen_fd > max_fd) max_fd = listen_fd;
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (clients[i].fd == -1) continue;
+        if (clients[i].out.len > clients[i].out_off) FD_SET(clients[i].fd, wfds);
+        else FD_SET(clients[i].fd, rfds);
+        if (clients[i].fd > max_fd) max_fd = clients[i].fd;
+    }
+    return max_fd;
+}
+
+void metrics_http_handle(fd_set *rfds, fd_set *wfds) {
+    if (listen_fd == -1) return;
+
+    // 先回收停滞的连接，新来的抓取才有槽位可用
+    uint64_t now = phase_now_ns();
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (clients[i].fd != -1 && now - clients[i].active_ns > METRICS_IDLE_NS) client_close(&clients[i]);
+    }
+
+    if (FD_ISSET(listen_fd, rfds)) {
+        // 一次性接收所有排队连接，槽位满则直接拒绝
+        while (1) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd == -1) break;
+            int slot = -1;
+            for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+                if (clients[i].fd == -1) { slot = i; break; }
+            }
+            if (slot == -1 || set_non_blocking(fd) == -1) { close(fd); continue; }
+            clients[slot].fd = fd;
+            clients[slot].req_len = 0;
+            clients[slot].active_ns = now;
+        }
+    }
+
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        MetricsClient *c = &clients[i];
+        if (c->fd == -1) continue;
+
+        if (c->out.len > c->out_off) {
+            if (!FD_ISSET(c->fd, wfds)) continue;
+            ssize_t n = send(c->fd, c->out.data + c->out_off, c->out.len - c->out_off, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) { client_close(c); continue; }
+            if (n > 0) {
+                c->out_off += (size_t)n;
+                c->active_ns = now;
+            }
+            if (c->out_off >= c->out.len) client_close(c);
+            continue;
+        }
+
+        if (!FD_ISSET(c->fd, rfds)) continue;
+        ssize_t n = recv(c->fd, c->req + c->req_len, sizeof(c->req) - 1 - c->req_len, MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) { client_close(c); continue; }
+        if (n < 0) continue;
+        c->active_ns = now;
+        c->req_len += (size_t)n;
+        c->req[c->req_len] = '\0';
+        if (strstr(c->req, "\r\n\r\n") || strstr(c->req, "\n\n")) client_respond(c);
+        else if (c->req_len >= sizeof(c->req) - 1) client_close(c); // 请求头过长
+    }
+}
+
+void metrics_http_stop(void) {
+    if (listen_fd == -1) return;
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (clients[i].fd != -1) client_close(&clients[i]);
+        strbuf_free(&clients[i].out);
+    }
+    close(listen_fd);
+    listen_fd = -1;
+    strbuf_free(&body);
+    free(proc_slots);
+    proc_slots = NULL;
+    proc_cap = 0;
+}
+#endif
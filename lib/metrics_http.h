@@ -0,0 +1,28 @@
+#ifndef METRICS_HTTP_H
+#define METRICS_HTTP_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/select.h>
+#endif
+
+#include "backend/scanner.h"
+
+// 启动 OpenMetrics 监听（格式 "127.0.0.1:9100"、":9100" 或 "9100"）
+// 成功返回 0，失败返回 -1
+int metrics_http_start(const char *listen_spec);
+
+// 每轮扫描后调用：把最新快照渲染进复用缓冲区，抓取请求直接读取该缓冲区
+void metrics_http_publish(const ConnectionInfo *conns, int count, const ConnectionStats *stats, double scan_ms);
+
+// 把监听/客户端 FD 挂入主循环 select 集合，返回新的 max_fd
+int metrics_http_fill_fds(fd_set *rfds, fd_set *wfds, int max_fd);
+
+// select 返回后处理就绪的监听/客户端 FD（全程非阻塞）
+void metrics_http_handle(fd_set *rfds, fd_set *wfds);
+
+// 关闭监听及所有客户端
+void metrics_http_stop(void);
+
+#endif // METRICS_HTTP_H
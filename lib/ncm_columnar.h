@@ -0,0 +1,57 @@
+#ifndef NCM_COLUMNAR_H
+#define NCM_COLUMNAR_H
+
+// NCM 列式快照文件（ncm --format bin 输出）
+// 本头文件不依赖 NCM 内部结构，可直接拷贝给外部工具使用
+// 所有整数字段为主机字节序（小端），IPv4 地址为网络字节序
+//
+// 文件布局（各段起始偏移均按 8 字节对齐）：
+//   NcmColHeader
+//   NcmColDesc[n_columns]
+//   字符串表：uint32 offsets[n_strings + 1]，随后为不含结尾 NUL 的 UTF-8 字节
+//            第 i 个字符串为 bytes[offsets[i] .. offsets[i+1])，与 Arrow 字符串数组布局一致
+//   各列数据：n_rows 个定宽元素的连续数组
+//
+// 列（v1）：proto(U8, 6/17) state(STR8) local_ip(IPV4) local_port(U16) remote_ip(IPV4) remote_port(U16)
+//          pid(I32) process(STR) exe(STR) risk(STR) flags(U8, bit0 可疑, bit1 外部连接)
+// 读端应按列名查找，不要依赖列的顺序
+//
+// 读取示例（numpy）：按 NcmColDesc 的 offset/type 对整个文件 np.frombuffer 切片即可，无需逐行解析
+
+#include <stdint.h>
+
+#define NCM_COL_MAGIC   0x434D434Eu  // "NCMC"（小端）
+#define NCM_COL_VERSION 1
+#define NCM_COL_ALIGN   8
+
+// 列元素类型
+#define NCM_COL_U8   1
+#define NCM_COL_U16  2
+#define NCM_COL_U32  3
+#define NCM_COL_I32  4
+#define NCM_COL_STR  5  // uint32 字符串表下标
+#define NCM_COL_IPV4 6  // uint32，网络字节序
+#define NCM_COL_STR8 7  // uint8 字符串表下标（取值较少的枚举列，如 state）
+
+// 文件头（40 字节）
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t n_columns;
+    uint32_t n_rows;
+    uint32_t n_strings;
+    uint64_t timestamp;      // 导出时刻（Unix 秒）
+    uint64_t strtab_offset;  // 字符串表起始偏移
+    uint64_t strtab_size;    // offsets 数组 + 字节区的总长度
+} NcmColHeader;
+
+// 列描述（32 字节）
+typedef struct {
+    char     name[16];       // NUL 结尾列名
+    uint8_t  type;           // NCM_COL_*
+    uint8_t  width;          // 单个元素字节数
+    uint8_t  reserved[6];
+    uint64_t offset;         // 列数据起始偏移
+} NcmColDesc;
+
+#endif // NCM_COLUMNAR_H
@@ -0,0 +1,133 @@
+#ifndef NCM_SHM_H
+#define NCM_SHM_H
+
+// NCM 共享内存快照布局与只读访问库（仅头文件，可直接拷贝给外部工具）
+//
+// 写端每轮扫描把 NcmWireRecord 数组写入 shm_open 区域，并用 seqlock 保护：
+//   seq 为奇数表示正在写入；读端在 begin/end 之间直接读取映射内存（零拷贝），
+//   end 校验 seq 未变化即为一致视图，否则丢弃本次结果重读。
+// 稳态读取不产生任何系统调用；仅当写端扩容时读端重新映射一次。
+//
+// 用法：
+//   NcmShmReader r;
+//   if (ncm_shm_reader_open(&r, "/ncm") == 0) {
+//       uint64_t s;
+//       do {
+//           s = ncm_shm_read_begin(&r);
+//           uint32_t n = ncm_shm_count(&r);
+//           const NcmWireRecord *recs = ncm_shm_records(&r);
+//           ... 处理 recs[0..n) ...
+//       } while (!ncm_shm_read_end(&r, s));
+//       ncm_shm_reader_close(&r);
+//   }
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "lib/ncm_wire.h"
+
+#define NCM_SHM_MAGIC   0x4D48534Eu  // "NSHM"（小端）
+#define NCM_SHM_VERSION 1
+
+// 区域头（64 字节），其后紧跟 capacity 个 NcmWireRecord
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;      // sizeof(NcmWireRecord)，供读端校验
+    uint32_t capacity;         // 当前可容纳的记录数（仅在写入期间增大）
+    uint32_t reserved0;
+    _Atomic uint64_t seq;      // seqlock 序号，奇数表示写入中
+    uint64_t generation;       // 扫描轮次
+    uint64_t timestamp_ns;     // 扫描完成时间（CLOCK_REALTIME）
+    uint32_t count;            // 有效记录数
+    uint32_t reserved1;
+    uint8_t  pad[16];
+} NcmShmHeader;
+
+#define NCM_SHM_REGION_SIZE(cap) (sizeof(NcmShmHeader) + (size_t)(cap) * sizeof(NcmWireRecord))
+
+static inline NcmWireRecord *ncm_shm_header_records(NcmShmHeader *h) {
+    return (NcmWireRecord *)(h + 1);
+}
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct {
+    int fd;
+    NcmShmHeader *hdr;
+    size_t map_size;
+    uint32_t map_capacity;
+} NcmShmReader;
+
+static inline int ncm_shm__map(NcmShmReader *r) {
+    struct stat st;
+    if (fstat(r->fd, &st) != 0 || (size_t)st.st_size < sizeof(NcmShmHeader)) return -1;
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, r->fd, 0);
+    if (p == MAP_FAILED) return -1;
+    if (r->hdr) munmap((void *)r->hdr, r->map_size);
+    r->hdr = (NcmShmHeader *)p;
+    r->map_size = (size_t)st.st_size;
+    r->map_capacity = (uint32_t)((r->map_size - sizeof(NcmShmHeader)) / sizeof(NcmWireRecord));
+    return 0;
+}
+
+// 打开并映射区域（name 形如 "/ncm"），成功返回 0
+static inline int ncm_shm_reader_open(NcmShmReader *r, const char *name) {
+    r->hdr = NULL;
+    r->map_size = 0;
+    r->map_capacity = 0;
+    r->fd = shm_open(name, O_RDONLY, 0);
+    if (r->fd == -1) return -1;
+    if (ncm_shm__map(r) != 0 || r->hdr->magic != NCM_SHM_MAGIC ||
+        r->hdr->version != NCM_SHM_VERSION || r->hdr->record_size != sizeof(NcmWireRecord)) {
+        if (r->hdr) munmap((void *)r->hdr, r->map_size);
+        close(r->fd);
+        r->hdr = NULL;
+        r->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// 开始一次读取：等待写入结束并返回当前序号；写端扩容后在此处重新映射
+static inline uint64_t ncm_shm_read_begin(NcmShmReader *r) {
+    for (;;) {
+        uint64_t s = atomic_load_explicit(&r->hdr->seq, memory_order_acquire);
+        if (s & 1) continue;
+        if (r->hdr->capacity > r->map_capacity) {
+            ncm_shm__map(r);
+            continue;
+        }
+        return s;
+    }
+}
+
+// 结束读取：返回 1 表示 begin 之后读到的数据一致，0 表示需要重读
+static inline int ncm_shm_read_end(const NcmShmReader *r, uint64_t s) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&r->hdr->seq, memory_order_relaxed) == s;
+}
+
+// 在 begin/end 之间调用；记录数按本地映射容量截断，保证不越界
+static inline uint32_t ncm_shm_count(const NcmShmReader *r) {
+    uint32_t n = r->hdr->count;
+    return n < r->map_capacity ? n : r->map_capacity;
+}
+
+static inline const NcmWireRecord *ncm_shm_records(const NcmShmReader *r) {
+    return (const NcmWireRecord *)(r->hdr + 1);
+}
+
+static inline void ncm_shm_reader_close(NcmShmReader *r) {
+    if (r->hdr) munmap((void *)r->hdr, r->map_size);
+    if (r->fd != -1) close(r->fd);
+    r->hdr = NULL;
+    r->fd = -1;
+}
+#endif // !_WIN32
+
+#endif // NCM_SHM_H
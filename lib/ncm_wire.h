@@ -0,0 +1,48 @@
+#ifndef NCM_WIRE_H
+#define NCM_WIRE_H
+
+// NCM 对外二进制协议（查询套接字等本地消费者共用）
+// 本头文件不依赖 NCM 内部结构，可直接拷贝给外部工具使用
+// 所有整数字段为主机字节序，IPv4 地址为网络字节序
+
+#include <stdint.h>
+
+#define NCM_WIRE_MAGIC   0x514D434Eu  // "NCMQ"（小端）
+#define NCM_WIRE_VERSION 1
+
+// 消息类型
+#define NCM_WIRE_SNAPSHOT 0  // 全量结果：n_added 条记录
+#define NCM_WIRE_DIFF     1  // 订阅增量：依次为 added / removed / changed 记录
+
+// 协议号
+#define NCM_WIRE_PROTO_TCP 6
+#define NCM_WIRE_PROTO_UDP 17
+
+// 消息头（紧随其后为 n_added + n_removed + n_changed 条 NcmWireRecord）
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t seq;        // 扫描序号
+    uint32_t n_added;
+    uint32_t n_removed;
+    uint32_t n_changed;
+} NcmWireHeader;
+
+// 固定长度连接记录（40 字节）
+typedef struct {
+    uint8_t  proto;       // NCM_WIRE_PROTO_*
+    uint8_t  state;       // ConnectionStatus 枚举值
+    uint16_t local_port;
+    uint16_t remote_port;
+    uint16_t flags;       // bit0: 可疑
+    uint32_t local_ip;
+    uint32_t remote_ip;
+    int32_t  pid;
+    char     process[16]; // 进程名（截断，保证 NUL 结尾）
+    uint32_t reserved;
+} NcmWireRecord;
+
+#define NCM_WIRE_FLAG_SUSPICIOUS 0x1
+
+#endif // NCM_WIRE_H
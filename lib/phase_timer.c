@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+#include "lib/phase_timer.h"
+#include "backend/scanner.h"
+
+static const char *phase_names[PHASE_COUNT] = {
+    "inode_index", "net_table", "scan", "stats", "risk", "enrich", "publish", "filter", "render", "frame"
+};
+
+static PhaseHist hists[PHASE_COUNT];
+static PhaseProcess process;
+static uint64_t syscalls_at_begin = 0;
+
+uint64_t phase_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER cnt;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (uint64_t)((double)cnt.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// 微秒值 -> 桶下标：小于 4us 逐微秒一桶，其后每个 2 的幂区间按最高位之后的 2 位再分 4 份
+static int bucket_of(uint64_t us) {
+    if (us < (1u << PHASE_SUB_BITS)) return (int)us;
+    int msb = 63;
+    while (!(us >> msb)) msb--;
+    int b = ((msb - PHASE_SUB_BITS + 1) << PHASE_SUB_BITS) + (int)((us >> (msb - PHASE_SUB_BITS)) & ((1u << PHASE_SUB_BITS) - 1));
+    return b < PHASE_BUCKETS ? b : PHASE_BUCKETS - 1;
+}
+
+// 桶的上界（微秒，不含）
+static uint64_t bucket_upper_us(int b) {
+    if (b < (1 << PHASE_SUB_BITS)) return (uint64_t)b + 1;
+    int msb = (b >> PHASE_SUB_BITS) + PHASE_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b & ((1 << PHASE_SUB_BITS) - 1));
+    return ((1ull << PHASE_SUB_BITS) + sub + 1) << (msb - PHASE_SUB_BITS);
+}
+
+void phase_record(PhaseId id, uint64_t ns) {
+    PhaseHist *h = &hists[id];
+    h->count++;
+    h->sum_ns += ns;
+    h->last_ns = ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+    h->buckets[bucket_of(ns / 1000)]++;
+}
+
+uint64_t phase_end(PhaseId id, uint64_t start_ns) {
+    uint64_t now = phase_now_ns();
+    phase_record(id, now - start_ns);
+    return now;
+}
+
+const char *phase_name(PhaseId id) {
+    return phase_names[id];
+}
+
+const PhaseHist *phase_hist(PhaseId id) {
+    return &hists[id];
+}
+
+uint64_t phase_percentile_ns(PhaseId id, int pct) {
+    const PhaseHist *h = &hists[id];
+    if (h->count == 0) return 0;
+    uint64_t rank = (h->count * (uint64_t)pct + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < PHASE_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen < rank) continue;
+        uint64_t ns = bucket_upper_us(b) * 1000;
+        return ns < h->max_ns ? ns : h->max_ns;
+    }
+    return h->max_ns;
+}
+
+uint64_t phase_count_le(PhaseId id, uint64_t le_us) {
+    const PhaseHist *h = &hists[id];
+    uint64_t n = 0;
+    for (int b = 0; b < PHASE_BUCKETS && bucket_upper_us(b) <= le_us; b++) n += h->buckets[b];
+    return n;
+}
+
+// 读类 / 写类系统调用累计数（内核在 /proc/self/io 中按 syscr / syscw 计数）
+static uint64_t self_io_syscalls(void) {
+#ifdef _WIN32
+    return 0;
+#else
+    FILE *f = fopen("/proc/self/io", "r");
+    if (!f) return 0;
+    char line[64];
+    uint64_t total = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long v;
+        if (sscanf(line, "syscr: %llu", &v) == 1 || sscanf(line, "syscw: %llu", &v) == 1) total += v;
+    }
+    fclose(f);
+    return total;
+#endif
+}
+
+static uint64_t self_rss_bytes(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (uint64_t)pmc.WorkingSetSize;
+#else
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long long size = 0, resident = 0;
+    int ok = fscanf(f, "%llu %llu", &size, &resident) == 2;
+    fclose(f);
+    long page = sysconf(_SC_PAGESIZE);
+    return ok && page > 0 ? resident * (uint64_t)page : 0;
+#endif
+}
+
+void phase_scan_begin(void) {
+    syscalls_at_begin = self_io_syscalls() + scanner_syscall_count();
+}
+
+// 系统调用数 = 内核计的 read/write 类调用 + 扫描器自行计数的 open/close/readlink/stat；
+// getdents 与 sock_diag 的收发未计入，读取 /proc/self/io 本身的 2 次读也算在内
+void phase_scan_end(int rows) {
+    uint64_t now = self_io_syscalls() + scanner_syscall_count();
+    process.syscalls = now > syscalls_at_begin ? now - syscalls_at_begin : 0;
+    process.rows = rows;
+    process.rss_bytes = self_rss_bytes();
+}
+
+const PhaseProcess *phase_process(void) {
+    return &process;
+}
+
+void phase_format_json(StrBuf *b) {
+    strbuf_printf(b, "{\"rows\":%d,\"syscalls\":%llu,\"rss_bytes\":%llu,\"phases\":{",
+                  process.rows, (unsigned long long)process.syscalls, (unsigned long long)process.rss_bytes);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseHist *h = &hists[i];
+        strbuf_printf(b, "%s\"%s\":{\"count\":%llu,\"last_ms\":%.3f,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}",
+                      i ? "," : "", phase_names[i], (unsigned long long)h->count, h->last_ns / 1e6,
+                      h->count ? (double)h->sum_ns / (double)h->count / 1e6 : 0.0,
+                      phase_percentile_ns((PhaseId)i, 50) / 1e6, phase_percentile_ns((PhaseId)i, 90) / 1e6,
+                      phase_percentile_ns((PhaseId)i, 99) / 1e6, h->max_ns / 1e6);
+    }
+    strbuf_puts(b, "}}");
+}
@@ -0,0 +1,66 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <stdint.h>
+#include "lib/strbuf.h"
+
+// 扫描 / 帧流水线的分阶段计时：单调时钟 + 固定桶直方图
+// 桶按微秒取对数：每个 2 的幂区间再等分 4 份（分位数相对误差 < 25%），覆盖 1us .. 约 33s；
+// 记录一次只是一次移位定位和几次自增，不分配内存，可常开
+
+typedef enum {
+    PHASE_INODE_INDEX,   // 遍历 /proc/<pid>/fd 建立 inode -> 进程索引
+    PHASE_NET_TABLE,     // 读取并解析 /proc/net/{tcp,udp}（或 sock_diag 转储），含进程名解析
+    PHASE_SCAN,          // scanner_get_connections 合计
+    PHASE_STATS,         // calculate_stats
+    PHASE_RISK,          // is_suspicious 与频率突增检测
+    PHASE_ENRICH,        // tcp_info、backlog 与各监测模块
+    PHASE_PUBLISH,       // metrics / 查询套接字 / 共享内存发布
+    PHASE_FILTER,        // 排序与视图过滤
+    PHASE_RENDER,        // 绘制整屏
+    PHASE_FRAME,         // 一帧合计（排序到刷新输出，不含等待输入）
+    PHASE_COUNT
+} PhaseId;
+
+#define PHASE_SUB_BITS 2
+#define PHASE_BUCKETS (24 << PHASE_SUB_BITS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t last_ns;
+    uint64_t max_ns;
+    uint32_t buckets[PHASE_BUCKETS];
+} PhaseHist;
+
+// 进程级采样，每轮扫描结束时更新
+typedef struct {
+    int rows;              // 最近一轮扫描的行数
+    uint64_t syscalls;     // 最近一轮扫描发出的系统调用数（近似，见 phase_scan_end）
+    uint64_t rss_bytes;    // 常驻内存，不可用时为 0
+} PhaseProcess;
+
+uint64_t phase_now_ns(void);
+
+// 记录一段耗时并返回当前时刻，便于连续阶段串接：t = phase_end(PHASE_A, t); ...; t = phase_end(PHASE_B, t);
+uint64_t phase_end(PhaseId id, uint64_t start_ns);
+void phase_record(PhaseId id, uint64_t ns);
+
+const char *phase_name(PhaseId id);
+const PhaseHist *phase_hist(PhaseId id);
+
+// 按桶估计的分位数（取所在桶的上界，不超过观测到的最大值）；无样本返回 0
+uint64_t phase_percentile_ns(PhaseId id, int pct);
+
+// 小于 le_us 微秒的样本数（le_us 为 2 的幂时恰好落在桶边界上），用于 OpenMetrics 累积桶
+uint64_t phase_count_le(PhaseId id, uint64_t le_us);
+
+// 包住一轮扫描：前后各读一次系统调用计数，结束时顺带采样 RSS
+void phase_scan_begin(void);
+void phase_scan_end(int rows);
+const PhaseProcess *phase_process(void);
+
+// 追加一个 JSON 对象（无换行）：{"rows":..,"syscalls":..,"rss_bytes":..,"phases":{"scan":{...},...}}
+void phase_format_json(StrBuf *b);
+
+#endif // PHASE_TIMER_H
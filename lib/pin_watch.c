@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <string.h>
+#include "lib/pin_watch.h"
+#include "backend/sock_diag.h"
+
+static PinnedConn pins[PIN_WATCH_MAX];
+static int pin_count = 0;
+static int64_t last_poll_ms = 0;
+
+static int find_pin(const char *local_addr, const char *remote_addr) {
+    for (int i = 0; i < pin_count; i++) {
+        if (strcmp(pins[i].local_addr, local_addr) == 0 && strcmp(pins[i].remote_addr, remote_addr) == 0) return i;
+    }
+    return -1;
+}
+
+int pin_watch_toggle(const char *local_addr, const char *remote_addr) {
+    int idx = find_pin(local_addr, remote_addr);
+    if (idx >= 0) {
+        memmove(&pins[idx], &pins[idx + 1], sizeof(PinnedConn) * (pin_count - idx - 1));
+        pin_count--;
+        return 0;
+    }
+    if (pin_count == PIN_WATCH_MAX) return -1;
+
+    PinnedConn p;
+    memset(&p, 0, sizeof(p));
+    if (parse_ipv4_endpoint(local_addr, &p.src, &p.sport) != 0) return -1;
+    if (parse_ipv4_endpoint(remote_addr, &p.dst, &p.dport) != 0) return -1;
+    snprintf(p.local_addr, sizeof(p.local_addr), "%s", local_addr);
+    snprintf(p.remote_addr, sizeof(p.remote_addr), "%s", remote_addr);
+    p.state = CONN_STATUS_UNKNOWN;
+    pins[pin_count++] = p;
+    last_poll_ms = 0; // 新固定的连接立即查询一次
+    return 1;
+}
+
+int pin_watch_parse(const char *spec) {
+    char buf[80];
+    snprintf(buf, sizeof(buf), "%s", spec);
+    char *comma = strchr(buf, ',');
+    if (!comma) return -1;
+    *comma = '\0';
+    if (find_pin(buf, comma + 1) >= 0) return 0;
+    return pin_watch_toggle(buf, comma + 1) == 1 ? 0 : -1;
+}
+
+int pin_watch_is_pinned(const char *local_addr, const char *remote_addr) {
+    return find_pin(local_addr, remote_addr) >= 0;
+}
+
+int pin_watch_count(void) {
+    return pin_count;
+}
+
+const PinnedConn *pin_watch_get(int index) {
+    return (index >= 0 && index < pin_count) ? &pins[index] : NULL;
+}
+
+const char *pin_state_name(uint8_t state) {
+    if (state == PIN_STATE_GONE) return "GONE";
+    if (state == CONN_STATUS_UNKNOWN) return "-";
+    return conn_status_name((ConnectionStatus)state);
+}
+
+// 查询单条固定连接，返回是否有可见变化
+static int poll_pin(PinnedConn *p, int64_t now_ms) {
+    DiagSocket s;
+    TcpDiag t;
+    memset(&t, 0, sizeof(t));
+    int rc = sock_diag_query(p->src, p->sport, p->dst, p->dport, &s, &t);
+    if (rc < 0) return 0; // sock_diag 不可用，保持上次结果
+
+    uint8_t state = rc == 0 ? (uint8_t)sock_diag_status(s.state) : PIN_STATE_GONE;
+    uint32_t rxq = rc == 0 ? s.rqueue : 0;
+    uint32_t txq = rc == 0 ? s.wqueue : 0;
+    int changed = state != p->state || rxq != p->rx_queue || txq != p->tx_queue;
+
+    if (state != p->state) {
+        // 首次查询只记录初始状态，不算迁移
+        if (p->state != CONN_STATUS_UNKNOWN) {
+            PinEvent *e = &p->events[p->event_pos];
+            e->at_ms = now_ms;
+            e->from = p->state;
+            e->to = state;
+            p->event_pos = (p->event_pos + 1) % PIN_EVENT_HISTORY;
+            if (p->event_count < PIN_EVENT_HISTORY) p->event_count++;
+        }
+        p->state = state;
+        p->state_since_ms = now_ms;
+    }
+    p->rx_queue = rxq;
+    p->tx_queue = txq;
+    if (rxq > p->peak_rx_queue) p->peak_rx_queue = rxq;
+    if (txq > p->peak_tx_queue) p->peak_tx_queue = txq;
+    // RTT 每次查询都会抖动，只随下次重绘展示，不单独触发重绘
+    if (rc == 0) p->tcp = t;
+    else p->tcp.valid = 0;
+    return changed;
+}
+
+int pin_watch_poll(int64_t now_ms) {
+    if (pin_count == 0 || now_ms - last_poll_ms < PIN_POLL_INTERVAL_MS) return 0;
+    last_poll_ms = now_ms;
+    int changed = 0;
+    for (int i = 0; i < pin_count; i++) changed += poll_pin(&pins[i], now_ms);
+    return changed;
+}
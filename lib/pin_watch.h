@@ -0,0 +1,54 @@
+#ifndef PIN_WATCH_H
+#define PIN_WATCH_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 固定连接观察：对少数关键 TCP 连接按四元组用 sock_diag 精确查询，
+// 以独立于全量扫描的高频定时器刷新状态、队列与 RTT，并记录状态迁移
+
+#define PIN_WATCH_MAX 8            // 最多固定的连接数
+#define PIN_POLL_INTERVAL_MS 100   // 查询间隔
+#define PIN_EVENT_HISTORY 4        // 每条连接保留的最近状态迁移数
+#define PIN_STATE_GONE CONN_STATUS_COUNT  // 套接字已不存在
+
+typedef struct {
+    int64_t at_ms;                 // 迁移发生时刻（Unix 毫秒）
+    uint8_t from;                  // ConnectionStatus 或 PIN_STATE_GONE
+    uint8_t to;
+} PinEvent;
+
+typedef struct {
+    char local_addr[32];
+    char remote_addr[32];
+    uint32_t src, dst;             // 网络字节序
+    uint16_t sport, dport;
+    uint8_t state;                 // ConnectionStatus 或 PIN_STATE_GONE；尚未查询时为 CONN_STATUS_UNKNOWN
+    int64_t state_since_ms;
+    uint32_t rx_queue;
+    uint32_t tx_queue;
+    uint32_t peak_rx_queue;        // 固定以来的最大值
+    uint32_t peak_tx_queue;
+    TcpDiag tcp;                   // 仅 rtt / 重传等计数有效
+    PinEvent events[PIN_EVENT_HISTORY];  // 环形，event_pos 为下一次写入位置
+    int event_pos;
+    int event_count;
+} PinnedConn;
+
+// 固定 / 取消固定一条 TCP 连接（地址为 "a.b.c.d:port"），返回 1 已固定、0 已取消，地址非法或已满返回 -1
+int pin_watch_toggle(const char *local_addr, const char *remote_addr);
+
+// 解析命令行 "LOCAL,REMOTE"（如 "10.0.0.5:40312,10.0.0.9:5432"）并固定，成功返回 0
+int pin_watch_parse(const char *spec);
+
+int pin_watch_is_pinned(const char *local_addr, const char *remote_addr);
+int pin_watch_count(void);
+const PinnedConn *pin_watch_get(int index);
+
+// 到期时（距上次查询满 PIN_POLL_INTERVAL_MS）查询全部固定连接，返回状态或队列发生变化的连接数（RTT 变化不计）
+int pin_watch_poll(int64_t now_ms);
+
+// 状态显示名（含 GONE）
+const char *pin_state_name(uint8_t state);
+
+#endif // PIN_WATCH_H
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lib/port_exhaust.h"
+
+#ifdef _WIN32
+static uint16_t range_lo = 49152, range_hi = 65535;  // Windows 动态端口默认范围
+#else
+static uint16_t range_lo = 32768, range_hi = 60999;
+#endif
+
+// 本轮计数用的开放寻址哈希表，跨轮复用；gen 不等于当前轮次的槽视为空，免去每轮清表
+typedef struct {
+    uint32_t local_ip, remote_ip;
+    uint16_t remote_port;
+    uint32_t gen;
+    uint32_t in_use;
+    uint32_t time_wait;
+    int first_row;                 // 首个计入的行，用于取进程名
+} DestSlot;
+
+static DestSlot *slots = NULL;
+static uint32_t slot_cap = 0;
+static uint32_t generation = 0;
+static uint32_t *used = NULL;      // 本轮用到的槽下标
+static uint32_t used_count = 0;
+
+// 本轮监听中的本地端口：被动接受的连接沿用监听端口，不占用临时端口
+static uint32_t listen_gen[65536];
+
+static PortDest tracked[PORT_TRACK_MAX];
+static int tracked_count = 0;
+static const PortDest *ranked[PORT_TRACK_MAX];
+static int ranked_count = 0;
+
+// 范围可能被运维在运行中调整，每轮重读（单个小文件，开销可忽略）
+static void load_range(void) {
+#ifndef _WIN32
+    char path[512];
+    snprintf(path, sizeof(path), "%s/sys/net/ipv4/ip_local_port_range", scanner_proc_root());
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    unsigned int lo, hi;
+    if (fscanf(f, "%u %u", &lo, &hi) == 2 && lo > 0 && lo <= hi && hi <= 65535) {
+        range_lo = (uint16_t)lo;
+        range_hi = (uint16_t)hi;
+    }
+    fclose(f);
+#endif
+}
+
+void port_exhaust_range(uint16_t *lo, uint16_t *hi) {
+    *lo = range_lo;
+    *hi = range_hi;
+}
+
+int port_exhaust_pct(const PortDest *d) {
+    uint32_t size = (uint32_t)range_hi - range_lo + 1;
+    uint64_t pct = (uint64_t)d->in_use * 100 / size;
+    return pct > 100 ? 100 : (int)pct;
+}
+
+static uint32_t dest_hash(uint32_t lip, uint32_t rip, uint16_t rport) {
+    uint64_t h = ((uint64_t)lip << 32 | rip) * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)rport * 0xC2B2AE3D27D4EB4FULL;
+    return (uint32_t)(h >> 32);
+}
+
+// 容量保持为 2 的幂且不低于行数的两倍，装载率不超过 50%
+static int ensure_capacity(int rows) {
+    uint32_t need = 64;
+    while (need < (uint32_t)rows * 2) need <<= 1;
+    if (need <= slot_cap) return 0;
+    DestSlot *ns = calloc(need, sizeof(DestSlot));
+    uint32_t *nu = malloc(sizeof(uint32_t) * need);
+    if (!ns || !nu) {
+        free(ns);
+        free(nu);
+        return -1;
+    }
+    free(slots);
+    free(used);
+    slots = ns;
+    used = nu;
+    slot_cap = need;
+    return 0;
+}
+
+static DestSlot *lookup_slot(uint32_t lip, uint32_t rip, uint16_t rport, int create) {
+    uint32_t mask = slot_cap - 1;
+    uint32_t i = dest_hash(lip, rip, rport) & mask;
+    while (slots[i].gen == generation) {
+        DestSlot *s = &slots[i];
+        if (s->local_ip == lip && s->remote_ip == rip && s->remote_port == rport) return s;
+        i = (i + 1) & mask;
+    }
+    if (!create) return NULL;
+    DestSlot *s = &slots[i];
+    s->local_ip = lip;
+    s->remote_ip = rip;
+    s->remote_port = rport;
+    s->gen = generation;
+    s->in_use = 0;
+    s->time_wait = 0;
+    s->first_row = -1;
+    used[used_count++] = i;
+    return s;
+}
+
+static PortDest *find_tracked(uint32_t lip, uint32_t rip, uint16_t rport) {
+    for (int i = 0; i < tracked_count; i++) {
+        PortDest *d = &tracked[i];
+        if (d->local_ip == lip && d->remote_ip == rip && d->remote_port == rport) return d;
+    }
+    return NULL;
+}
+
+// 把计数较多的目标纳入跟踪；表满时替换当前占用最少的目标，无可替换时返回 NULL
+static PortDest *track(const DestSlot *s) {
+    PortDest *d = NULL;
+    if (tracked_count < PORT_TRACK_MAX) {
+        d = &tracked[tracked_count++];
+    } else {
+        for (int i = 0; i < tracked_count; i++) {
+            if (!d || tracked[i].in_use < d->in_use) d = &tracked[i];
+        }
+        if (d->in_use >= s->in_use) return NULL;
+    }
+    memset(d, 0, sizeof(*d));
+    d->local_ip = s->local_ip;
+    d->remote_ip = s->remote_ip;
+    d->remote_port = s->remote_port;
+    return d;
+}
+
+static int dest_worse(const PortDest *a, const PortDest *b) {
+    if (a->in_use != b->in_use) return a->in_use > b->in_use;
+    return a->time_wait > b->time_wait;
+}
+
+void port_exhaust_update(const ConnectionInfo *conns, int count, int64_t now_ms) {
+    load_range();
+    if (ensure_capacity(count) != 0) return;
+    generation++;
+    if (generation == 0) {
+        // 轮次回绕：清表后从 1 重新开始
+        memset(slots, 0, sizeof(DestSlot) * slot_cap);
+        memset(listen_gen, 0, sizeof(listen_gen));
+        generation = 1;
+    }
+    used_count = 0;
+
+    // 1. 登记监听端口（落在临时端口范围内的服务端口上的入站连接不计）
+    for (int i = 0; i < count; i++) {
+        uint32_t lip;
+        uint16_t lport;
+        if (conns[i].status_enum != CONN_STATUS_LISTEN || parse_ipv4_endpoint(conns[i].local_addr, &lip, &lport) != 0) continue;
+        listen_gen[lport] = generation;
+    }
+
+    // 2. 一次遍历，按目标累计占用的临时端口
+    for (int i = 0; i < count; i++) {
+        const ConnectionInfo *c = &conns[i];
+        uint32_t lip, rip;
+        uint16_t lport, rport;
+        if (c->status_enum == CONN_STATUS_LISTEN || strcmp(c->protocol, "TCP") != 0) continue;
+        if (parse_ipv4_endpoint(c->local_addr, &lip, &lport) != 0 || lport < range_lo || lport > range_hi) continue;
+        if (listen_gen[lport] == generation) continue;
+        if (parse_ipv4_endpoint(c->remote_addr, &rip, &rport) != 0 || rport == 0) continue;
+        DestSlot *s = lookup_slot(lip, rip, rport, 1);
+        s->in_use++;
+        if (c->status_enum == CONN_STATUS_TIME_WAIT) s->time_wait++;
+        if (s->first_row < 0 || (conns[s->first_row].pid <= 0 && c->pid > 0)) s->first_row = i;
+    }
+
+    // 3. 已跟踪目标刷新计数并记录历史
+    int kept = 0;
+    for (int i = 0; i < tracked_count; i++) {
+        PortDest *d = &tracked[i];
+        const DestSlot *s = lookup_slot(d->local_ip, d->remote_ip, d->remote_port, 0);
+        d->in_use = s ? s->in_use : 0;
+        d->time_wait = s ? s->time_wait : 0;
+        if (s) snprintf(d->process, sizeof(d->process), "%.*s", (int)sizeof(d->process) - 1, conns[s->first_row].process);
+        if (d->in_use > d->peak_in_use) d->peak_in_use = d->in_use;
+        d->idle_rounds = d->in_use ? 0 : d->idle_rounds + 1;
+        if (d->idle_rounds > PORT_TRACK_GRACE) continue;
+        d->history[d->history_pos] = d->in_use;
+        d->history_ms[d->history_pos] = now_ms;
+        d->history_pos = (d->history_pos + 1) % PORT_HISTORY_LEN;
+        if (d->history_len < PORT_HISTORY_LEN) d->history_len++;
+        if (kept != i) tracked[kept] = *d;
+        kept++;
+    }
+    tracked_count = kept;
+
+    // 4. 本轮计数最高的目标纳入跟踪（插入排序取前 PORT_TRACK_TOP）
+    const DestSlot *top[PORT_TRACK_TOP];
+    int n = 0;
+    for (uint32_t k = 0; k < used_count; k++) {
+        const DestSlot *s = &slots[used[k]];
+        int j = n < PORT_TRACK_TOP ? n++ : PORT_TRACK_TOP;
+        if (j == PORT_TRACK_TOP && s->in_use <= top[PORT_TRACK_TOP - 1]->in_use) continue;
+        if (j == PORT_TRACK_TOP) j = PORT_TRACK_TOP - 1;
+        while (j > 0 && s->in_use > top[j - 1]->in_use) {
+            top[j] = top[j - 1];
+            j--;
+        }
+        top[j] = s;
+    }
+    for (int k = 0; k < n; k++) {
+        if (find_tracked(top[k]->local_ip, top[k]->remote_ip, top[k]->remote_port)) continue;
+        PortDest *d = track(top[k]);
+        if (!d) continue;
+        const ConnectionInfo *c = &conns[top[k]->first_row];
+        const char *colon = strrchr(c->local_addr, ':');
+        snprintf(d->local_ip_str, sizeof(d->local_ip_str), "%.*s", colon ? (int)(colon - c->local_addr) : 0, c->local_addr);
+        // 展示字段：IPv4 "a.b.c.d:port" 放得下，进程名过长时截断
+        snprintf(d->remote_addr, sizeof(d->remote_addr), "%.*s", (int)sizeof(d->remote_addr) - 1, c->remote_addr);
+        snprintf(d->process, sizeof(d->process), "%.*s", (int)sizeof(d->process) - 1, c->process);
+        d->in_use = d->peak_in_use = top[k]->in_use;
+        d->time_wait = top[k]->time_wait;
+        d->history[0] = d->in_use;
+        d->history_ms[0] = now_ms;
+        d->history_pos = 1;
+        d->history_len = 1;
+    }
+
+    // 5. 排名缓存，供视图与逐行查询使用
+    ranked_count = 0;
+    for (int i = 0; i < tracked_count; i++) {
+        const PortDest *d = &tracked[i];
+        if (d->in_use == 0) continue;
+        int j = ranked_count++;
+        while (j > 0 && dest_worse(d, ranked[j - 1])) {
+            ranked[j] = ranked[j - 1];
+            j--;
+        }
+        ranked[j] = d;
+    }
+}
+
+int port_exhaust_ranked(const PortDest **out, int max) {
+    int n = ranked_count < max ? ranked_count : max;
+    for (int i = 0; i < n; i++) out[i] = ranked[i];
+    return n;
+}
+
+int port_exhaust_at_risk(void) {
+    int n = 0;
+    for (int i = 0; i < ranked_count; i++) {
+        if (port_exhaust_pct(ranked[i]) < PORT_EXHAUST_WARN_PCT) break;
+        n++;
+    }
+    return n;
+}
+
+int port_exhaust_eta_sec(const PortDest *d) {
+    if (d->history_len < 2) return -1;
+    int newest = (d->history_pos - 1 + PORT_HISTORY_LEN) % PORT_HISTORY_LEN;
+    int oldest = (d->history_pos - d->history_len + PORT_HISTORY_LEN) % PORT_HISTORY_LEN;
+    int64_t grown = (int64_t)d->history[newest] - d->history[oldest];
+    int64_t span_ms = d->history_ms[newest] - d->history_ms[oldest];
+    if (grown <= 0 || span_ms <= 0) return -1;
+    uint32_t size = (uint32_t)range_hi - range_lo + 1;
+    if (d->in_use >= size) return 0;
+    int64_t eta = (int64_t)(size - d->in_use) * span_ms / grown / 1000;
+    return eta > 0x7fffffff ? 0x7fffffff : (int)eta;
+}
+
+int port_exhaust_rank(const ConnectionInfo *c, int max) {
+    uint32_t lip, rip;
+    uint16_t lport, rport;
+    if (ranked_count == 0 || strcmp(c->protocol, "TCP") != 0) return -1;
+    if (parse_ipv4_endpoint(c->local_addr, &lip, &lport) != 0 || lport < range_lo || lport > range_hi) return -1;
+    if (parse_ipv4_endpoint(c->remote_addr, &rip, &rport) != 0) return -1;
+    int n = ranked_count < max ? ranked_count : max;
+    for (int i = 0; i < n; i++) {
+        const PortDest *d = ranked[i];
+        if (d->local_ip == lip && d->remote_ip == rip && d->remote_port == rport) return i;
+    }
+    return -1;
+}
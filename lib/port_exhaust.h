@@ -0,0 +1,56 @@
+#ifndef PORT_EXHAUST_H
+#define PORT_EXHAUST_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 临时端口耗尽监测：同一 (本地 IP, 远端 IP:端口) 目标上，每条出站连接（含 TIME_WAIT）各占用一个
+// ip_local_port_range 内的本地端口，占满后 connect() 返回 EADDRNOTAVAIL。
+// 每轮对扫描结果做一次遍历、以哈希表按目标计数；计数最高的目标保留最近若干轮的历史用于趋势与耗尽预估
+
+#define PORT_EXHAUST_WARN_PCT 70       // 占用率达到该值即在看板告警
+#define PORT_TRACK_MAX 64              // 最多跟踪历史的目标数
+#define PORT_TRACK_TOP 16              // 每轮把计数最高的若干目标纳入跟踪
+#define PORT_HISTORY_LEN 30            // 每个目标保留的历史轮数
+#define PORT_TRACK_GRACE 3             // 连续无占用超过该轮数即淘汰
+
+typedef struct {
+    uint32_t local_ip;                 // 网络字节序
+    uint32_t remote_ip;
+    uint16_t remote_port;
+    char local_ip_str[16];             // 展示用，"a.b.c.d"
+    char remote_addr[32];              // 展示用，"a.b.c.d:port"
+    char process[32];                  // 首个可归属进程的行对应的进程名
+    uint32_t in_use;                   // 当前占用的临时端口数（含 TIME_WAIT）
+    uint32_t time_wait;                // 其中处于 TIME_WAIT 的数量
+    uint32_t peak_in_use;              // 跟踪期间的最大值
+    uint32_t history[PORT_HISTORY_LEN];     // in_use，环形
+    int64_t history_ms[PORT_HISTORY_LEN];   // 对应的采样时刻
+    int history_pos;                   // 下一次写入位置
+    int history_len;
+    int idle_rounds;                   // 连续 in_use 为 0 的轮数
+} PortDest;
+
+// 当前的临时端口范围
+void port_exhaust_range(uint16_t *lo, uint16_t *hi);
+
+// 每轮扫描后调用：重读 /proc/sys/net/ipv4/ip_local_port_range（读取失败时沿用内核默认范围），
+// 按目标重新计数并更新跟踪表与历史
+void port_exhaust_update(const ConnectionInfo *conns, int count, int64_t now_ms);
+
+// 取得占用最多的至多 max 个目标，返回数量
+int port_exhaust_ranked(const PortDest **out, int max);
+
+// 占用率（0..100）
+int port_exhaust_pct(const PortDest *d);
+
+// 占用率达到 PORT_EXHAUST_WARN_PCT 的目标数
+int port_exhaust_at_risk(void);
+
+// 按历史增长斜率估算距耗尽的秒数；未在增长时返回 -1
+int port_exhaust_eta_sec(const PortDest *d);
+
+// 该连接所属目标的排名（0 起，与 port_exhaust_ranked 的前 max 项对应），不属于其中时返回 -1
+int port_exhaust_rank(const ConnectionInfo *c, int max);
+
+#endif // PORT_EXHAUST_H
@@ -0,0 +1,482 @@
+#include "lib/query_server.h"
+
+#ifdef _WIN32
+int query_server_start(const char *path) { (void)path; return -1; }
+void query_server_publish(const ConnectionInfo *conns, int count) { (void)conns; (void)count; }
+int query_server_fill_fds(fd_set *rfds, fd_set *wfds, int max_fd) { (void)rfds; (void)wfds; return max_fd; }
+void query_server_handle(fd_set *rfds, fd_set *wfds) { (void)rfds; (void)wfds; }
+void query_server_stop(void) {}
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "lib/strbuf.h"
+#include "lib/conn_filter.h"
+#include "lib/phase_timer.h"
+#include "lib/heavy_hitters.h"
+
+#define QUERY_MAX_CLIENTS 32
+#define QUERY_LINE_MAX 512
+#define QUERY_MAX_PENDING (8u << 20)  // 待发送积压超过 8MiB 视为消费过慢，断开
+
+typedef enum { FMT_JSON, FMT_BIN } QueryFormat;
+
+typedef struct {
+    int fd;
+    char line[QUERY_LINE_MAX];
+    size_t line_len;
+    StrBuf out;
+    size_t out_off;
+    int subscribed;
+    QueryFormat fmt;
+    ConnFilter filter;
+} QueryClient;
+
+// 一轮快照（记录数组跨扫描复用）
+typedef struct {
+    NcmWireRecord *recs;
+    int count;
+    int cap;
+} QuerySnapshot;
+
+static int listen_fd = -1;
+static char socket_path[108];
+static QueryClient clients[QUERY_MAX_CLIENTS];
+static QuerySnapshot snap_a, snap_b;
+static QuerySnapshot *cur = &snap_a, *prev = &snap_b;
+static uint32_t seq = 0;
+
+// 增量计算用的哈希索引与标记（复用）
+static int *diff_index = NULL;
+static size_t diff_index_cap = 0;
+static unsigned char *prev_seen = NULL;
+static int prev_seen_cap = 0;
+static unsigned char *cur_kind = NULL;   // 0 不变 / 1 新增 / 2 变化
+static int cur_kind_cap = 0;
+
+static int set_non_blocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+int query_server_start(const char *path) {
+    struct sockaddr_un sa;
+    if (strlen(path) >= sizeof(sa.sun_path)) {
+        fprintf(stderr, "Error: query socket path too long: %s\n", path);
+        return -1;
+    }
+
+    // 清理上次异常退出遗留的套接字文件（仅限套接字类型）
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, path);
+
+    mode_t old_mask = umask(0077);
+    int rc = bind(fd, (struct sockaddr *)&sa, sizeof(sa));
+    umask(old_mask);
+    if (rc == -1 || listen(fd, 16) == -1 || set_non_blocking(fd) == -1) {
+        fprintf(stderr, "Error: cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    for (int i = 0; i < QUERY_MAX_CLIENTS; i++) clients[i].fd = -1;
+    strcpy(socket_path, path);
+    listen_fd = fd;
+    return 0;
+}
+
+static uint32_t hash_identity(const NcmWireRecord *r) {
+    uint32_t h = 2166136261u; // FNV-1a over identity fields
+    uint32_t parts[5] = { r->proto, r->local_ip, ((uint32_t)r->local_port << 16) | r->remote_port, r->remote_ip, (uint32_t)r->pid };
+    const unsigned char *p = (const unsigned char *)parts;
+    for (size_t i = 0; i < sizeof(parts); i++) { h ^= p[i]; h *= 16777619u; }
+    return h;
+}
+
+static int same_identity(const NcmWireRecord *a, const NcmWireRecord *b) {
+    return a->proto == b->proto && a->local_ip == b->local_ip && a->local_port == b->local_port &&
+           a->remote_ip == b->remote_ip && a->remote_port == b->remote_port && a->pid == b->pid;
+}
+
+static void format_ip(uint32_t ip, uint16_t port, char *out, size_t n) {
+    const unsigned char *o = (const unsigned char *)&ip;
+    snprintf(out, n, "%u.%u.%u.%u:%u", o[0], o[1], o[2], o[3], port);
+}
+
+static void append_json_record(StrBuf *b, const NcmWireRecord *r) {
+    char local[32], remote[32];
+    format_ip(r->local_ip, r->local_port, local, sizeof(local));
+    format_ip(r->remote_ip, r->remote_port, remote, sizeof(remote));
+    strbuf_printf(b, "{\"proto\":\"%s\",\"local\":\"%s\",\"remote\":\"%s\",\"state\":\"%s\",\"pid\":%d,\"process\":",
+                  r->proto == NCM_WIRE_PROTO_UDP ? "UDP" : "TCP", local, remote,
+                  conn_status_name((ConnectionStatus)r->state), r->pid);
+    strbuf_json_str(b, r->process);
+    strbuf_printf(b, ",\"suspicious\":%s}", (r->flags & NCM_WIRE_FLAG_SUSPICIOUS) ? "true" : "false");
+}
+
+static void append_header(StrBuf *b, uint16_t type, uint32_t added, uint32_t removed, uint32_t changed) {
+    NcmWireHeader h;
+    h.magic = NCM_WIRE_MAGIC;
+    h.version = NCM_WIRE_VERSION;
+    h.type = type;
+    h.seq = seq;
+    h.n_added = added;
+    h.n_removed = removed;
+    h.n_changed = changed;
+    strbuf_append(b, &h, sizeof(h));
+}
+
+// 把快照中匹配过滤条件的记录写入客户端输出缓冲
+static void send_snapshot(QueryClient *c) {
+    if (c->fmt == FMT_BIN) {
+        size_t hdr_pos = c->out.len;
+        append_header(&c->out, NCM_WIRE_SNAPSHOT, 0, 0, 0);
+        uint32_t n = 0;
+        for (int i = 0; i < cur->count; i++) {
+            if (!conn_filter_match(&c->filter, &cur->recs[i])) continue;
+            strbuf_append(&c->out, &cur->recs[i], sizeof(NcmWireRecord));
+            n++;
+        }
+        // 回填记录数
+        if (c->out.data && c->out.len >= hdr_pos + sizeof(NcmWireHeader)) {
+            memcpy(c->out.data + hdr_pos + offsetof(NcmWireHeader, n_added), &n, sizeof(n));
+        }
+    } else {
+        strbuf_printf(&c->out, "{\"type\":\"snapshot\",\"seq\":%u,\"connections\":[", seq);
+        int first = 1;
+        for (int i = 0; i < cur->count; i++) {
+            if (!conn_filter_match(&c->filter, &cur->recs[i])) continue;
+            if (!first) strbuf_append(&c->out, ",", 1);
+            append_json_record(&c->out, &cur->recs[i]);
+            first = 0;
+        }
+        strbuf_puts(&c->out, "]}\n");
+    }
+}
+
+static void send_error(QueryClient *c, const char *msg) {
+    strbuf_puts(&c->out, "{\"type\":\"error\",\"message\":");
+    strbuf_json_str(&c->out, msg);
+    strbuf_puts(&c->out, "}\n");
+}
+
+static void client_close(QueryClient *c) {
+    close(c->fd);
+    c->fd = -1;
+    c->line_len = 0;
+    c->out.len = 0;
+    c->out_off = 0;
+    c->subscribed = 0;
+}
+
+// HITTERS [by=host|prefix] [n=N]：近一小时（衰减）平均并发连接数最高的远端主机或网段
+static void send_hitters(QueryClient *c, char *save) {
+    HhMode mode = HH_BY_HOST;
+    int n = 10;
+    for (char *tok = strtok_r(NULL, " \t\r", &save); tok; tok = strtok_r(NULL, " \t\r", &save)) {
+        if (strcmp(tok, "by=host") == 0) mode = HH_BY_HOST;
+        else if (strcmp(tok, "by=prefix") == 0) mode = HH_BY_PREFIX;
+        else if (strncmp(tok, "n=", 2) == 0 && atoi(tok + 2) > 0) n = atoi(tok + 2);
+        else { send_error(c, "expected by=host|prefix or n=N"); return; }
+    }
+    if (n > HH_TOP_MAX) n = HH_TOP_MAX;
+    const HeavyHitter *top[HH_TOP_MAX];
+    n = heavy_hitters_ranked(mode, top, n);
+    strbuf_printf(&c->out, "{\"type\":\"hitters\",\"seq\":%u,\"by\":\"%s\",\"window_sec\":%.0f,\"top\":[",
+                  seq, mode == HH_BY_PREFIX ? "prefix" : "host", heavy_hitters_window_sec());
+    for (int i = 0; i < n; i++) {
+        strbuf_puts(&c->out, i ? ",{\"remote\":" : "{\"remote\":");
+        strbuf_json_str(&c->out, top[i]->label);
+        strbuf_printf(&c->out, ",\"avg\":%.3f,\"err\":%.3f,\"share\":%.4f}",
+                      heavy_hitters_avg(top[i]), heavy_hitters_err(top[i]), heavy_hitters_share(top[i]));
+    }
+    strbuf_puts(&c->out, "]}\n");
+}
+
+// 解析并执行一条命令
+static void handle_command(QueryClient *c, char *line) {
+    char *save = NULL;
+    char *cmd = strtok_r(line, " \t\r", &save);
+    if (!cmd) return;
+
+    if (strcmp(cmd, "UNSUBSCRIBE") == 0) {
+        c->subscribed = 0;
+        return;
+    }
+    if (strcmp(cmd, "PROFILE") == 0) {
+        strbuf_printf(&c->out, "{\"type\":\"profile\",\"seq\":%u,\"profile\":", seq);
+        phase_format_json(&c->out);
+        strbuf_puts(&c->out, "}\n");
+        return;
+    }
+    if (strcmp(cmd, "HITTERS") == 0) {
+        send_hitters(c, save);
+        return;
+    }
+    int is_query = strcmp(cmd, "QUERY") == 0;
+    int is_sub = strcmp(cmd, "SUBSCRIBE") == 0;
+    if (!is_query && !is_sub) {
+        send_error(c, "unknown command");
+        return;
+    }
+
+    ConnFilter filter;
+    conn_filter_init(&filter);
+    QueryFormat fmt = FMT_JSON;
+    for (char *tok = strtok_r(NULL, " \t\r", &save); tok; tok = strtok_r(NULL, " \t\r", &save)) {
+        char *eq = strchr(tok, '=');
+        if (!eq) { send_error(c, "expected key=value"); return; }
+        *eq = '\0';
+        const char *val = eq + 1;
+        if (strcmp(tok, "format") == 0) {
+            if (strcmp(val, "json") == 0) fmt = FMT_JSON;
+            else if (strcmp(val, "bin") == 0) fmt = FMT_BIN;
+            else { send_error(c, "format must be json or bin"); return; }
+        } else if (conn_filter_set(&filter, tok, val) != 0) {
+            send_error(c, "invalid filter");
+            return;
+        }
+    }
+
+    c->filter = filter;
+    c->fmt = fmt;
+    c->subscribed = is_sub;
+    send_snapshot(c);
+}
+
+// 计算 prev -> cur 的增量并推送给所有订阅者，O(N)
+static void push_diffs(void) {
+    // prev 哈希索引：容量为 2 的幂且不低于 2 倍元素数
+    size_t need = 16;
+    while (need < (size_t)prev->count * 2) need <<= 1;
+    if (need > diff_index_cap) {
+        int *tmp = realloc(diff_index, sizeof(int) * need);
+        if (!tmp) return;
+        diff_index = tmp;
+        diff_index_cap = need;
+    }
+    if (prev->count > prev_seen_cap) {
+        unsigned char *tmp = realloc(prev_seen, (size_t)prev->count);
+        if (!tmp) return;
+        prev_seen = tmp;
+        prev_seen_cap = prev->count;
+    }
+    if (cur->count > cur_kind_cap) {
+        unsigned char *tmp = realloc(cur_kind, (size_t)cur->count);
+        if (!tmp) return;
+        cur_kind = tmp;
+        cur_kind_cap = cur->count;
+    }
+
+    size_t mask = need - 1;
+    for (size_t i = 0; i < need; i++) diff_index[i] = -1;
+    for (int i = 0; i < prev->count; i++) {
+        size_t pos = hash_identity(&prev->recs[i]) & mask;
+        while (diff_index[pos] != -1) pos = (pos + 1) & mask;
+        diff_index[pos] = i;
+    }
+    if (prev->count > 0) memset(prev_seen, 0, (size_t)prev->count);
+
+    for (int i = 0; i < cur->count; i++) {
+        const NcmWireRecord *r = &cur->recs[i];
+        size_t pos = hash_identity(r) & mask;
+        int match = -1;
+        while (diff_index[pos] != -1) {
+            int j = diff_index[pos];
+            if (!prev_seen[j] && same_identity(&prev->recs[j], r)) { match = j; break; }
+            pos = (pos + 1) & mask;
+        }
+        if (match == -1) {
+            cur_kind[i] = 1;
+        } else {
+            prev_seen[match] = 1;
+            cur_kind[i] = (prev->recs[match].state != r->state || prev->recs[match].flags != r->flags) ? 2 : 0;
+        }
+    }
+
+    for (int k = 0; k < QUERY_MAX_CLIENTS; k++) {
+        QueryClient *c = &clients[k];
+        if (c->fd == -1 || !c->subscribed) continue;
+        if (c->out.len - c->out_off > QUERY_MAX_PENDING) { client_close(c); continue; }
+
+        uint32_t n_add = 0, n_rm = 0, n_chg = 0;
+        if (c->fmt == FMT_BIN) {
+            size_t hdr_pos = c->out.len;
+            append_header(&c->out, NCM_WIRE_DIFF, 0, 0, 0);
+            for (int i = 0; i < cur->count; i++) {
+                if (cur_kind[i] == 1 && conn_filter_match(&c->filter, &cur->recs[i])) { strbuf_append(&c->out, &cur->recs[i], sizeof(NcmWireRecord)); n_add++; }
+            }
+            for (int j = 0; j < prev->count; j++) {
+                if (!prev_seen[j] && conn_filter_match(&c->filter, &prev->recs[j])) { strbuf_append(&c->out, &prev->recs[j], sizeof(NcmWireRecord)); n_rm++; }
+            }
+            for (int i = 0; i < cur->count; i++) {
+                if (cur_kind[i] == 2 && conn_filter_match(&c->filter, &cur->recs[i])) { strbuf_append(&c->out, &cur->recs[i], sizeof(NcmWireRecord)); n_chg++; }
+            }
+            // 回填三类记录数（n_added/n_removed/n_changed 在头部连续排列）
+            if (c->out.data && c->out.len >= hdr_pos + sizeof(NcmWireHeader)) {
+                uint32_t counts[3] = { n_add, n_rm, n_chg };
+                memcpy(c->out.data + hdr_pos + offsetof(NcmWireHeader, n_added), counts, sizeof(counts));
+            }
+        } else {
+            strbuf_printf(&c->out, "{\"type\":\"diff\",\"seq\":%u,\"added\":[", seq);
+            for (int i = 0; i < cur->count; i++) {
+                if (cur_kind[i] != 1 || !conn_filter_match(&c->filter, &cur->recs[i])) continue;
+                if (n_add++) strbuf_append(&c->out, ",", 1);
+                append_json_record(&c->out, &cur->recs[i]);
+            }
+            strbuf_puts(&c->out, "],\"removed\":[");
+            for (int j = 0; j < prev->count; j++) {
+                if (prev_seen[j] || !conn_filter_match(&c->filter, &prev->recs[j])) continue;
+                if (n_rm++) strbuf_append(&c->out, ",", 1);
+                append_json_record(&c->out, &prev->recs[j]);
+            }
+            strbuf_puts(&c->out, "],\"changed\":[");
+            for (int i = 0; i < cur->count; i++) {
+                if (cur_kind[i] != 2 || !conn_filter_match(&c->filter, &cur->recs[i])) continue;
+                if (n_chg++) strbuf_append(&c->out, ",", 1);
+                append_json_record(&c->out, &cur->recs[i]);
+            }
+            strbuf_puts(&c->out, "]}\n");
+        }
+    }
+}
+
+void query_server_publish(const ConnectionInfo *conns, int count) {
+    if (listen_fd == -1) return;
+
+    // 交换前后快照，复用记录数组
+    QuerySnapshot *tmp = prev;
+    prev = cur;
+    cur = tmp;
+    if (count > cur->cap) {
+        NcmWireRecord *recs = realloc(cur->recs, sizeof(NcmWireRecord) * (size_t)count);
+        if (!recs) { cur->count = 0; return; }
+        cur->recs = recs;
+        cur->cap = count;
+    }
+    for (int i = 0; i < count; i++) conn_to_wire(&conns[i], &cur->recs[i]);
+    cur->count = count;
+    seq++;
+
+    int has_subscriber = 0;
+    for (int k = 0; k < QUERY_MAX_CLIENTS; k++) {
+        if (clients[k].fd != -1 && clients[k].subscribed) { has_subscriber = 1; break; }
+    }
+    if (has_subscriber) push_diffs();
+}
+
+int query_server_fill_fds(fd_set *rfds, fd_set *wfds, int max_fd) {
+    if (listen_fd == -1) return max_fd;
+    FD_SET(listen_fd, rfds);
+    if (listen_fd > max_fd) max_fd = listen_fd;
+    for (int i = 0; i < QUERY_MAX_CLIENTS; i++) {
+        if (clients[i].fd == -1) continue;
+        FD_SET(clients[i].fd, rfds);
+        if (clients[i].out.len > clients[i].out_off) FD_SET(clients[i].fd, wfds);
+        if (clients[i].fd > max_fd) max_fd = clients[i].fd;
+    }
+    return max_fd;
+}
+
+static void client_flush(QueryClient *c) {
+    if (c->out.len <= c->out_off) return;
+    ssize_t n = send(c->fd, c->out.data + c->out_off, c->out.len - c->out_off, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) client_close(c);
+        return;
+    }
+    c->out_off += (size_t)n;
+    if (c->out_off == c->out.len) {
+        c->out.len = 0;
+        c->out_off = 0;
+    } else if (c->out_off > c->out.len / 2) {
+        // 已发送部分过半时前移剩余数据，避免缓冲区无限增长
+        memmove(c->out.data, c->out.data + c->out_off, c->out.len - c->out_off);
+        c->out.len -= c->out_off;
+        c->out_off = 0;
+    }
+}
+
+void query_server_handle(fd_set *rfds, fd_set *wfds) {
+    if (listen_fd == -1) return;
+
+    if (FD_ISSET(listen_fd, rfds)) {
+        while (1) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd == -1) break;
+            int slot = -1;
+            for (int i = 0; i < QUERY_MAX_CLIENTS; i++) {
+                if (clients[i].fd == -1) { slot = i; break; }
+            }
+            if (slot == -1 || set_non_blocking(fd) == -1) { close(fd); continue; }
+            clients[slot].fd = fd;
+            clients[slot].line_len = 0;
+            clients[slot].subscribed = 0;
+        }
+    }
+
+    for (int i = 0; i < QUERY_MAX_CLIENTS; i++) {
+        QueryClient *c = &clients[i];
+        if (c->fd == -1) continue;
+
+        if (FD_ISSET(c->fd, rfds)) {
+            ssize_t n = recv(c->fd, c->line + c->line_len, sizeof(c->line) - 1 - c->line_len, MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) { client_close(c); continue; }
+            if (n > 0) {
+                c->line_len += (size_t)n;
+                c->line[c->line_len] = '\0';
+                // 逐行执行，剩余半行保留到下次
+                // 不读取回复而连发命令的客户端与过慢的订阅者同样处理：积压超限即断开
+                char *start = c->line, *nl;
+                while ((nl = strchr(start, '\n')) != NULL && c->out.len - c->out_off <= QUERY_MAX_PENDING) {
+                    *nl = '\0';
+                    handle_command(c, start);
+                    start = nl + 1;
+                }
+                if (c->out.len - c->out_off > QUERY_MAX_PENDING) { client_close(c); continue; }
+                size_t rest = c->line_len - (size_t)(start - c->line);
+                if (rest >= sizeof(c->line) - 1) { client_close(c); continue; } // 单行过长
+                memmove(c->line, start, rest);
+                c->line_len = rest;
+                c->line[rest] = '\0';
+            }
+        }
+        if (c->fd != -1 && (FD_ISSET(c->fd, wfds) || c->out.len > c->out_off)) client_flush(c);
+    }
+}
+
+void query_server_stop(void) {
+    if (listen_fd == -1) return;
+    for (int i = 0; i < QUERY_MAX_CLIENTS; i++) {
+        if (clients[i].fd != -1) client_close(&clients[i]);
+        strbuf_free(&clients[i].out);
+    }
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(socket_path);
+    free(snap_a.recs);
+    free(snap_b.recs);
+    memset(&snap_a, 0, sizeof(snap_a));
+    memset(&snap_b, 0, sizeof(snap_b));
+    free(diff_index);
+    free(prev_seen);
+    free(cur_kind);
+    diff_index = NULL; prev_seen = NULL; cur_kind = NULL;
+    diff_index_cap = 0; prev_seen_cap = 0; cur_kind_cap = 0;
+}
+#endif
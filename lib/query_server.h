@@ -0,0 +1,34 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/select.h>
+#endif
+
+#include "backend/scanner.h"
+
+// Unix 域套接字查询接口：本地工具复用 NCM 的快照，无需各自遍历 /proc
+// 协议为按行文本命令，响应为 JSON 行或 NcmWireHeader + NcmWireRecord 二进制：
+//   QUERY [format=json|bin] [pid=N] [port=N] [state=S[,S]] [cidr=A.B.C.D/len]
+//   SUBSCRIBE [同上参数]   先推送一次全量，此后每轮扫描推送增量
+//   UNSUBSCRIBE
+//   PROFILE                分阶段耗时、行数、系统调用数与 RSS（JSON 行，见 lib/phase_timer.h）
+
+// 在 path 创建监听套接字（权限 0600），成功返回 0，失败返回 -1
+int query_server_start(const char *path);
+
+// 每轮扫描后调用：更新快照并向订阅者推送增量
+void query_server_publish(const ConnectionInfo *conns, int count);
+
+// 把监听/客户端 FD 挂入主循环 select 集合，返回新的 max_fd
+int query_server_fill_fds(fd_set *rfds, fd_set *wfds, int max_fd);
+
+// select 返回后处理就绪的 FD（全程非阻塞）
+void query_server_handle(fd_set *rfds, fd_set *wfds);
+
+// 关闭所有连接并删除套接字文件
+void query_server_stop(void);
+
+#endif // QUERY_SERVER_H
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+#include "lib/rollup.h"
+
+#define ROLLUP_RING_TOTAL (ROLLUP_LEN_1S + ROLLUP_LEN_1M + ROLLUP_LEN_1H)
+
+static const struct {
+    int seconds;
+    int len;
+    int offset;                              // 在每条序列桶数组中的起点
+    const char *name;
+} RES[ROLLUP_RES_COUNT] = {
+    { 1, ROLLUP_LEN_1S, 0, "1s" },
+    { 60, ROLLUP_LEN_1M, ROLLUP_LEN_1S, "1m" },
+    { 3600, ROLLUP_LEN_1H, ROLLUP_LEN_1S + ROLLUP_LEN_1M, "1h" },
+};
+
+static const char *FIXED_NAMES[ROLLUP_FIXED_SERIES] = { "total", "established", "listen", "suspicious" };
+
+static RollupBucket buckets[ROLLUP_SERIES][ROLLUP_RING_TOTAL];
+static char proc_names[ROLLUP_PROC_SERIES][32];   // 空串为未分配
+static int64_t proc_last_sec[ROLLUP_PROC_SERIES];  // 最近一次在排名中的时刻
+static int64_t last_sample_sec[ROLLUP_SERIES];
+static int32_t last_value[ROLLUP_SERIES];
+static int64_t prev_scan_sec = 0;
+
+static void bucket_add(RollupBucket *ring, int len, int64_t id, int32_t v) {
+    RollupBucket *b = &ring[id % len];
+    if (b->n == 0 || b->id != id) {
+        b->id = id;
+        b->min = b->max = v;
+        b->sum = v;
+        b->n = 1;
+        return;
+    }
+    if (v < b->min) b->min = v;
+    if (v > b->max) b->max = v;
+    b->sum += v;
+    b->n++;
+}
+
+static void sample(int series, int64_t now_sec, int32_t v) {
+    RollupBucket *all = buckets[series];
+    // 上一轮也有该序列的样本时，1 秒环中间的空档按上一轮的值补齐
+    int64_t last = last_sample_sec[series];
+    if (last > 0 && last == prev_scan_sec && now_sec - last <= ROLLUP_HOLD_MAX_SEC) {
+        for (int64_t t = last + 1; t < now_sec; t++) bucket_add(all + RES[ROLLUP_1S].offset, RES[ROLLUP_1S].len, t, last_value[series]);
+    }
+    for (int r = 0; r < ROLLUP_RES_COUNT; r++) {
+        bucket_add(all + RES[r].offset, RES[r].len, now_sec / RES[r].seconds, v);
+    }
+    last_sample_sec[series] = now_sec;
+    last_value[series] = v;
+}
+
+static void clear_series(int series) {
+    memset(buckets[series], 0, sizeof(buckets[series]));
+    last_sample_sec[series] = 0;
+    last_value[series] = 0;
+}
+
+void rollup_ingest(const ConnectionStats *stats, int64_t now_sec) {
+    if (now_sec < prev_scan_sec) return; // 时钟回拨：等追上再写，避免覆盖较新的桶
+
+    sample(0, now_sec, stats->total);
+    sample(1, now_sec, stats->established);
+    sample(2, now_sec, stats->listening);
+    sample(3, now_sec, stats->suspicious);
+
+    // 进程槽位：已有槽位的直接写入；新进入排名的占用空槽，或替换本轮不在排名中、最久未上榜的槽位
+    int placed[STATS_TOP_PROCS] = {0};
+    for (int i = 0; i < stats->top_proc_count; i++) {
+        for (int s = 0; s < ROLLUP_PROC_SERIES; s++) {
+            if (proc_names[s][0] && strcmp(proc_names[s], stats->top_procs[i].name) == 0) {
+                proc_last_sec[s] = now_sec;
+                sample(ROLLUP_FIXED_SERIES + s, now_sec, stats->top_procs[i].count);
+                placed[i] = 1;
+                break;
+            }
+        }
+    }
+    for (int i = 0; i < stats->top_proc_count; i++) {
+        if (placed[i]) continue;
+        int victim = -1;
+        for (int s = 0; s < ROLLUP_PROC_SERIES; s++) {
+            if (!proc_names[s][0]) {
+                victim = s;
+                break;
+            }
+            if (proc_last_sec[s] == now_sec) continue;
+            if (victim < 0 || proc_last_sec[s] < proc_last_sec[victim]) victim = s;
+        }
+        if (victim < 0) break;
+        clear_series(ROLLUP_FIXED_SERIES + victim);
+        snprintf(proc_names[victim], sizeof(proc_names[victim]), "%s", stats->top_procs[i].name);
+        proc_last_sec[victim] = now_sec;
+        sample(ROLLUP_FIXED_SERIES + victim, now_sec, stats->top_procs[i].count);
+    }
+    prev_scan_sec = now_sec;
+}
+
+const char *rollup_series_name(int series) {
+    if (series < 0 || series >= ROLLUP_SERIES) return NULL;
+    if (series < ROLLUP_FIXED_SERIES) return FIXED_NAMES[series];
+    const char *name = proc_names[series - ROLLUP_FIXED_SERIES];
+    return name[0] ? name : NULL;
+}
+
+int rollup_res_seconds(RollupRes res) {
+    return RES[res].seconds;
+}
+
+const char *rollup_res_name(RollupRes res) {
+    return RES[res].name;
+}
+
+int rollup_read(int series, RollupRes res, int64_t now_sec, RollupBucket *out, int width) {
+    if (width > RES[res].len) width = RES[res].len;
+    const RollupBucket *ring = buckets[series] + RES[res].offset;
+    int64_t last = now_sec / RES[res].seconds;
+    for (int i = 0; i < width; i++) {
+        int64_t id = last - (width - 1 - i);
+        const RollupBucket *b = id >= 0 ? &ring[id % RES[res].len] : NULL;
+        if (b && b->n > 0 && b->id == id) {
+            out[i] = *b;
+        } else {
+            memset(&out[i], 0, sizeof(out[i]));
+            out[i].id = id;
+        }
+    }
+    return width;
+}
@@ -0,0 +1,44 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdint.h>
+#include "backend/scanner.h"
+
+// 多分辨率滚动指标：每条序列三个定长环（1 秒、1 分钟、1 小时粒度），每个桶保存最小 / 最大 / 平均，
+// 序列为总数、已建立、监听、可疑与活跃进程前 ROLLUP_PROC_SERIES 名。每轮扫描只读 calculate_stats
+// 的汇总写入各环当前桶，开销与序列数成正比，与连接数无关；内存为静态数组，不随运行时间增长。
+// 计数在两次扫描之间保持不变，因此 1 秒环把距上一次采样的空档（不超过 ROLLUP_HOLD_MAX_SEC）补为上一次的值
+
+#define ROLLUP_FIXED_SERIES 4                // 总数、已建立、监听、可疑
+#define ROLLUP_PROC_SERIES STATS_TOP_PROCS   // 进程序列槽位，按每轮的排名分配，让出槽位时清空
+#define ROLLUP_SERIES (ROLLUP_FIXED_SERIES + ROLLUP_PROC_SERIES)
+#define ROLLUP_LEN_1S 300                    // 5 分钟
+#define ROLLUP_LEN_1M 240                    // 4 小时
+#define ROLLUP_LEN_1H 48                     // 2 天
+#define ROLLUP_HOLD_MAX_SEC 60               // 超过该空档（进程挂起等）不补值，留作缺口
+
+typedef enum { ROLLUP_1S, ROLLUP_1M, ROLLUP_1H, ROLLUP_RES_COUNT } RollupRes;
+
+typedef struct {
+    int64_t id;                              // 桶的序号（Unix 秒 / 粒度）
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint32_t n;                              // 样本数，0 表示该时段没有数据
+} RollupBucket;
+
+// 每轮扫描后调用（now_sec 为 Unix 秒）
+void rollup_ingest(const ConnectionStats *stats, int64_t now_sec);
+
+// 序列名；未分配的进程槽位返回 NULL
+const char *rollup_series_name(int series);
+
+// 粒度的秒数与简称（"1s" / "1m" / "1h"）
+int rollup_res_seconds(RollupRes res);
+const char *rollup_res_name(RollupRes res);
+
+// 以 now_sec 所在的桶为最后一个，按时间顺序取出 width 个桶（缺口的 n 为 0），返回 width；
+// width 超过该粒度的环长时只取环长个
+int rollup_read(int series, RollupRes res, int64_t now_sec, RollupBucket *out, int width);
+
+#endif // ROLLUP_H
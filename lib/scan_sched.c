@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "lib/scan_sched.h"
+
+#define CHURN_FAST 0.02      // 变化行数占比不低于 2%：间隔减半
+#define CHURN_STABLE 0.005   // 低于 0.5%：间隔放宽 1/4
+#define COST_EWMA_ALPHA 0.3  // 扫描开销的平滑系数，避免单次抖动让间隔大起大落
+
+static int base_interval_ms = 2000;
+static int force_slack_ms = 3000;    // 用户操作时最多在间隔之外再推迟这么久
+static double budget = 0;
+static double cost_ms = 0;           // 平滑后的单轮扫描 CPU 开销
+static int have_cost = 0;
+static double interval_ms = 2000;
+
+void scan_sched_init(int interval, int force_ms) {
+    base_interval_ms = interval;
+    force_slack_ms = force_ms > interval ? force_ms - interval : 0;
+    interval_ms = interval;
+}
+
+int scan_sched_parse_budget(const char *spec) {
+    char *end;
+    double v = strtod(spec, &end);
+    if (end == spec) return -1;
+    if (*end == '%') {
+        v /= 100.0;
+        end++;
+    }
+    if (*end != '\0' || !(v > 0) || v > 1.0) return -1;
+    budget = v;
+    return 0;
+}
+
+int scan_sched_adaptive(void) {
+    return budget > 0;
+}
+
+double scan_sched_budget(void) {
+    return budget;
+}
+
+uint64_t scan_sched_cpu_ns(void) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (k + u) * 100; // 100ns 单位
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int scan_sched_floor_ms(void) {
+    if (budget <= 0 || !have_cost) return 0;
+    return (int)(cost_ms / budget);
+}
+
+void scan_sched_record(uint64_t cpu_ns, int rows, int churn) {
+    double cost = cpu_ns / 1e6;
+    cost_ms = have_cost ? cost_ms + COST_EWMA_ALPHA * (cost - cost_ms) : cost;
+    have_cost = 1;
+    if (budget <= 0) return;
+
+    double ratio = rows > 0 ? (double)churn / rows : 0;
+    if (ratio >= CHURN_FAST) interval_ms /= 2;
+    else if (ratio < CHURN_STABLE) interval_ms *= 1.25;
+    if (interval_ms < SCAN_SCHED_MIN_MS) interval_ms = SCAN_SCHED_MIN_MS;
+    if (interval_ms > SCAN_SCHED_MAX_MS) interval_ms = SCAN_SCHED_MAX_MS;
+
+    // 预算是硬约束：开销上升时即使连接变化很快也不再缩短
+    double floor_ms = cost_ms / budget;
+    if (interval_ms < floor_ms) interval_ms = floor_ms;
+}
+
+int scan_sched_interval_ms(void) {
+    return budget > 0 ? (int)interval_ms : base_interval_ms;
+}
+
+int scan_sched_force_ms(void) {
+    return scan_sched_interval_ms() + force_slack_ms;
+}
+
+double scan_sched_cpu_share(void) {
+    int interval = scan_sched_interval_ms();
+    return interval > 0 && have_cost ? cost_ms / interval : 0;
+}
+
+void scan_sched_format_interval(int ms, char *buf, int size) {
+    if (ms < 1000) snprintf(buf, (size_t)size, "%dms", ms);
+    else if (ms < 10000) snprintf(buf, (size_t)size, "%.1fs", ms / 1000.0);
+    else snprintf(buf, (size_t)size, "%ds", ms / 1000);
+}
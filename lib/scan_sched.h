@@ -0,0 +1,42 @@
+#ifndef SCAN_SCHED_H
+#define SCAN_SCHED_H
+
+#include <stdint.h>
+
+// 扫描调度：决定两次全量扫描之间的间隔
+// 未设置 CPU 预算时保持固定间隔（与 scan_sched_init 传入的一致）；
+// 设置预算后按每轮扫描自身消耗的 CPU 时间与连接变化量自适应：
+//   - 变化快（新建 / 关闭 / 状态迁移占行数的比例高）时间隔减半，稳定时每轮放宽 1/4
+//   - 间隔不低于 扫描开销 / 预算，保证扫描占用的 CPU 不超过预算（可超出上限）
+
+#define SCAN_SCHED_MIN_MS 250        // 自适应下的最短间隔
+#define SCAN_SCHED_MAX_MS 30000      // 自适应下仅因"稳定"放宽到的最长间隔（预算要求时可更长）
+
+// 固定间隔与用户持续操作时最长推迟到的时刻（均为毫秒）
+void scan_sched_init(int interval_ms, int force_ms);
+
+// 解析 --cpu-budget："1%"、"0.5%" 或小数 "0.01"，范围 (0, 100%]；成功返回 0 并启用自适应
+int scan_sched_parse_budget(const char *spec);
+
+int scan_sched_adaptive(void);
+double scan_sched_budget(void);      // 预算（占一个核的比例），未设置为 0
+
+// 进程累计 CPU 时间（用户 + 内核，纳秒），用于度量一轮扫描的开销
+uint64_t scan_sched_cpu_ns(void);
+
+// 每轮扫描后调用：cpu_ns 为本轮扫描流水线消耗的 CPU 时间，churn 为相对上一轮的变化行数
+void scan_sched_record(uint64_t cpu_ns, int rows, int churn);
+
+int scan_sched_interval_ms(void);
+int scan_sched_force_ms(void);
+
+// 预算允许的最短间隔（未设置预算为 0）：驱动事件触发的重扫也不早于此
+int scan_sched_floor_ms(void);
+
+// 按当前间隔估计的扫描 CPU 占用（比例）
+double scan_sched_cpu_share(void);
+
+// 间隔的简短文本："250ms" / "1.5s" / "45s"
+void scan_sched_format_interval(int ms, char *buf, int size);
+
+#endif // SCAN_SCHED_H
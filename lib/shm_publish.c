@@ -0,0 +1,99 @@
+#include "lib/shm_publish.h"
+
+#ifdef _WIN32
+int shm_publish_start(const char *name) { (void)name; return -1; }
+void shm_publish_update(const ConnectionInfo *conns, int count) { (void)conns; (void)count; }
+void shm_publish_stop(void) {}
+#else
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "lib/ncm_shm.h"
+#include "lib/conn_filter.h"
+
+#define SHM_INITIAL_CAPACITY 1024
+
+static int shm_fd = -1;
+static char shm_name[256];
+static NcmShmHeader *shm_hdr = NULL;
+static size_t shm_size = 0;
+
+// 扩容：仅增不减，读端持有的旧映射在文件变大后依然有效
+static int shm_grow(uint32_t capacity) {
+    size_t size = NCM_SHM_REGION_SIZE(capacity);
+    if (ftruncate(shm_fd, (off_t)size) != 0) return -1;
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (p == MAP_FAILED) return -1;
+    if (shm_hdr) munmap(shm_hdr, shm_size);
+    shm_hdr = (NcmShmHeader *)p;
+    shm_size = size;
+    return 0;
+}
+
+int shm_publish_start(const char *name) {
+    if (name[0] != '/' || strlen(name) >= sizeof(shm_name)) {
+        fprintf(stderr, "Error: shm name must look like /ncm: %s\n", name);
+        return -1;
+    }
+    // 先删除旧对象再新建：仍映射旧区域的读端不会因截断而 SIGBUS
+    shm_unlink(name);
+    shm_fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (shm_fd == -1) {
+        fprintf(stderr, "Error: shm_open %s failed: %s\n", name, strerror(errno));
+        return -1;
+    }
+    if (shm_grow(SHM_INITIAL_CAPACITY) != 0) {
+        fprintf(stderr, "Error: cannot size shm region %s: %s\n", name, strerror(errno));
+        close(shm_fd);
+        shm_unlink(name);
+        shm_fd = -1;
+        return -1;
+    }
+    strcpy(shm_name, name);
+    memset(shm_hdr, 0, sizeof(NcmShmHeader));
+    shm_hdr->magic = NCM_SHM_MAGIC;
+    shm_hdr->version = NCM_SHM_VERSION;
+    shm_hdr->record_size = sizeof(NcmWireRecord);
+    shm_hdr->capacity = SHM_INITIAL_CAPACITY;
+    atomic_store_explicit(&shm_hdr->seq, 0, memory_order_release);
+    return 0;
+}
+
+void shm_publish_update(const ConnectionInfo *conns, int count) {
+    if (!shm_hdr) return;
+
+    // 进入写临界区：seq 置为奇数，之后的数据写入对读端不可见为一致视图
+    uint64_t s = atomic_load_explicit(&shm_hdr->seq, memory_order_relaxed);
+    atomic_store_explicit(&shm_hdr->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if ((uint32_t)count > shm_hdr->capacity) {
+        uint32_t cap = shm_hdr->capacity;
+        while (cap < (uint32_t)count) cap *= 2;
+        if (shm_grow(cap) == 0) shm_hdr->capacity = cap;
+        else count = (int)shm_hdr->capacity; // 扩容失败时截断发布
+    }
+
+    NcmWireRecord *recs = ncm_shm_header_records(shm_hdr);
+    for (int i = 0; i < count; i++) conn_to_wire(&conns[i], &recs[i]);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    shm_hdr->count = (uint32_t)count;
+    shm_hdr->generation++;
+    shm_hdr->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+
+    atomic_store_explicit(&shm_hdr->seq, s + 2, memory_order_release);
+}
+
+void shm_publish_stop(void) {
+    if (!shm_hdr) return;
+    munmap(shm_hdr, shm_size);
+    close(shm_fd);
+    shm_unlink(shm_name);
+    shm_hdr = NULL;
+    shm_size = 0;
+    shm_fd = -1;
+}
+#endif
@@ -0,0 +1,17 @@
+#ifndef SHM_PUBLISH_H
+#define SHM_PUBLISH_H
+
+#include "backend/scanner.h"
+
+// 共享内存快照发布（布局与读端见 lib/ncm_shm.h）
+
+// 创建 name（如 "/ncm"）对应的共享内存区域，成功返回 0，失败返回 -1
+int shm_publish_start(const char *name);
+
+// 每轮扫描后调用：在 seqlock 保护下写入全部记录
+void shm_publish_update(const ConnectionInfo *conns, int count);
+
+// 解除映射并删除区域
+void shm_publish_stop(void);
+
+#endif // SHM_PUBLISH_H
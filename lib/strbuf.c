@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "lib/strbuf.h"
+
+int strbuf_reserve(StrBuf *b, size_t extra) {
+    if (b->len + extra <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + extra) cap *= 2;
+    char *tmp = realloc(b->data, cap);
+    if (!tmp) return -1;
+    b->data = tmp;
+    b->cap = cap;
+    return 0;
+}
+
+void strbuf_append(StrBuf *b, const void *s, size_t n) {
+    if (strbuf_reserve(b, n) != 0) return;
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+void strbuf_puts(StrBuf *b, const char *s) {
+    strbuf_append(b, s, strlen(s));
+}
+
+void strbuf_vprintf(StrBuf *b, const char *fmt, va_list ap) {
+    va_list retry;
+    va_copy(retry, ap);
+    size_t room = b->cap - b->len;
+    int n = vsnprintf(b->data ? b->data + b->len : NULL, room, fmt, ap);
+    if (n >= 0 && (size_t)n >= room) {
+        if (strbuf_reserve(b, (size_t)n + 1) == 0) vsnprintf(b->data + b->len, (size_t)n + 1, fmt, retry);
+        else n = -1;
+    }
+    va_end(retry);
+    if (n >= 0) b->len += (size_t)n;
+}
+
+void strbuf_printf(StrBuf *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    strbuf_vprintf(b, fmt, ap);
+    va_end(ap);
+}
+
+void strbuf_json_str(StrBuf *b, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    size_t n = strlen(s);
+    // 最坏情况每字节 6 字节 (\u00XX)，一次性预留避免逐字节检查
+    if (strbuf_reserve(b, n * 6 + 2) != 0) return;
+    char *out = b->data + b->len;
+    *out++ = '"';
+    for (const unsigned char *p = (const unsigned char *)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            *out++ = '\\';
+            *out++ = (char)*p;
+        } else if (*p < 0x20) {
+            *out++ = '\\'; *out++ = 'u'; *out++ = '0'; *out++ = '0';
+            *out++ = hex[*p >> 4];
+            *out++ = hex[*p & 0xF];
+        } else {
+            *out++ = (char)*p;
+        }
+    }
+    *out++ = '"';
+    b->len = (size_t)(out - b->data);
+}
+
+void strbuf_free(StrBuf *b) {
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
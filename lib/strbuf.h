@@ -0,0 +1,26 @@
+#ifndef STRBUF_H
+#define STRBUF_H
+
+#include <stddef.h>
+#include <stdarg.h>
+
+// 可复用的增长缓冲区：只增不减，清空时仅重置 len，稳态下不再分配
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} StrBuf;
+
+// 预留 extra 字节，失败返回 -1
+int strbuf_reserve(StrBuf *b, size_t extra);
+void strbuf_append(StrBuf *b, const void *s, size_t n);
+void strbuf_puts(StrBuf *b, const char *s);
+void strbuf_printf(StrBuf *b, const char *fmt, ...);
+void strbuf_vprintf(StrBuf *b, const char *fmt, va_list ap);
+
+// 追加带引号的 JSON 字符串（转义 " \ 与控制字符）
+void strbuf_json_str(StrBuf *b, const char *s);
+
+void strbuf_free(StrBuf *b);
+
+#endif // STRBUF_H
@@ -0,0 +1,119 @@
+#include <string.h>
+#include "lib/stream_writer.h"
+
+void sw_init(StreamWriter *w, FILE *fp) {
+    w->fp = fp;
+    w->len = 0;
+    w->error = 0;
+}
+
+static void sw_drain(StreamWriter *w) {
+    if (w->len == 0) return;
+    if (!w->error && fwrite(w->buf, 1, w->len, w->fp) != w->len) w->error = 1;
+    w->len = 0;
+}
+
+void sw_write(StreamWriter *w, const void *data, size_t n) {
+    if (n > sizeof(w->buf) - w->len) {
+        sw_drain(w);
+        // 大块数据直接写出，不经缓冲区
+        if (n >= sizeof(w->buf)) {
+            if (!w->error && fwrite(data, 1, n, w->fp) != n) w->error = 1;
+            return;
+        }
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+}
+
+void sw_puts(StreamWriter *w, const char *s) {
+    sw_write(w, s, strlen(s));
+}
+
+void sw_putc(StreamWriter *w, char c) {
+    if (w->len == sizeof(w->buf)) sw_drain(w);
+    w->buf[w->len++] = c;
+}
+
+void sw_int(StreamWriter *w, long long v) {
+    char tmp[24];
+    int i = sizeof(tmp);
+    unsigned long long u = v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v;
+    do {
+        tmp[--i] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) tmp[--i] = '-';
+    sw_write(w, tmp + i, sizeof(tmp) - (size_t)i);
+}
+
+// 需要转义的字节：控制字符、" \ 以及 < > &
+static const unsigned char JSON_ESCAPE[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    ['"'] = 1, ['\\'] = 1, ['<'] = 1, ['>'] = 1, ['&'] = 1,
+};
+
+void sw_json_str(StreamWriter *w, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    sw_putc(w, '"');
+    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *run = p;
+    for (; *p; p++) {
+        unsigned char ch = *p;
+        if (!JSON_ESCAPE[ch]) continue;
+        // 先整段写出无需转义的部分
+        sw_write(w, run, (size_t)(p - run));
+        run = p + 1;
+        if (ch == '"' || ch == '\\') {
+            char esc[2] = { '\\', (char)ch };
+            sw_write(w, esc, 2);
+        } else {
+            char esc[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xF] };
+            sw_write(w, esc, 6);
+        }
+    }
+    sw_write(w, run, (size_t)(p - run));
+    sw_putc(w, '"');
+}
+
+void sw_csv_field(StreamWriter *w, const char *s) {
+    if (!strpbrk(s, ",\"\r\n")) {
+        sw_puts(w, s);
+        return;
+    }
+    sw_putc(w, '"');
+    const char *run = s;
+    for (; *s; s++) {
+        if (*s != '"') continue;
+        sw_write(w, run, (size_t)(s - run + 1)); // 含当前引号
+        sw_putc(w, '"');
+        run = s + 1;
+    }
+    sw_write(w, run, (size_t)(s - run));
+    sw_putc(w, '"');
+}
+
+void sw_html(StreamWriter *w, const char *s) {
+    const char *run = s;
+    for (; *s; s++) {
+        const char *rep = NULL;
+        switch (*s) {
+            case '<': rep = "&lt;"; break;
+            case '>': rep = "&gt;"; break;
+            case '&': rep = "&amp;"; break;
+            case '"': rep = "&quot;"; break;
+            default: continue;
+        }
+        sw_write(w, run, (size_t)(s - run));
+        sw_puts(w, rep);
+        run = s + 1;
+    }
+    sw_write(w, run, (size_t)(s - run));
+}
+
+int sw_flush(StreamWriter *w) {
+    sw_drain(w);
+    if (!w->error && fflush(w->fp) != 0) w->error = 1;
+    return w->error ? -1 : 0;
+}
@@ -0,0 +1,36 @@
+#ifndef STREAM_WRITER_H
+#define STREAM_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 导出用流式写入器：固定大小缓冲区，满即整块 fwrite，逐行输出不做任何堆分配
+#define STREAM_WRITER_BUF_SIZE (64 * 1024)
+
+typedef struct {
+    FILE *fp;
+    size_t len;
+    int error;                       // 任一次 fwrite 失败后置 1，后续写入直接丢弃
+    char buf[STREAM_WRITER_BUF_SIZE];
+} StreamWriter;
+
+void sw_init(StreamWriter *w, FILE *fp);
+void sw_write(StreamWriter *w, const void *data, size_t n);
+void sw_puts(StreamWriter *w, const char *s);
+void sw_putc(StreamWriter *w, char c);
+void sw_int(StreamWriter *w, long long v);
+
+// JSON 字符串（带引号）：转义 " \ 控制字符，并把 < > & 写成 \u003c 形式，可安全内嵌于 <script>
+void sw_json_str(StreamWriter *w, const char *s);
+
+// CSV 字段（RFC 4180）：含 , " 换行时加引号并把 " 写成 ""
+void sw_csv_field(StreamWriter *w, const char *s);
+
+// HTML 文本转义：< > & "
+void sw_html(StreamWriter *w, const char *s);
+
+// 刷新缓冲区，返回 0 表示全部写入成功
+int sw_flush(StreamWriter *w);
+
+#endif // STREAM_WRITER_H
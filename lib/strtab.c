@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "lib/strtab.h"
+
+static uint32_t hash_str(const char *s) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+static int strtab_rehash(StringTable *t, size_t slot_cap) {
+    int *slots = malloc(sizeof(int) * slot_cap);
+    if (!slots) return -1;
+    for (size_t i = 0; i < slot_cap; i++) slots[i] = -1;
+    for (int i = 0; i < t->count; i++) {
+        size_t pos = hash_str(t->strs[i]) & (slot_cap - 1);
+        while (slots[pos] != -1) pos = (pos + 1) & (slot_cap - 1);
+        slots[pos] = i;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->slot_cap = slot_cap;
+    return 0;
+}
+
+void strtab_init(StringTable *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+int strtab_intern(StringTable *t, const char *s) {
+    if (t->failed) return 0;
+    if ((size_t)(t->count + 1) * 2 > t->slot_cap && strtab_rehash(t, t->slot_cap ? t->slot_cap * 2 : 1024) != 0) {
+        t->failed = 1;
+        return 0;
+    }
+    size_t pos = hash_str(s) & (t->slot_cap - 1);
+    while (t->slots[pos] != -1) {
+        if (strcmp(t->strs[t->slots[pos]], s) == 0) return t->slots[pos];
+        pos = (pos + 1) & (t->slot_cap - 1);
+    }
+    if (t->count == t->cap) {
+        int cap = t->cap ? t->cap * 2 : 1024;
+        const char **tmp = realloc(t->strs, sizeof(char *) * (size_t)cap);
+        if (!tmp) {
+            t->failed = 1;
+            return 0;
+        }
+        t->strs = tmp;
+        t->cap = cap;
+    }
+    t->strs[t->count] = s;
+    t->slots[pos] = t->count;
+    return t->count++;
+}
+
+void strtab_reset(StringTable *t) {
+    for (size_t i = 0; i < t->slot_cap; i++) t->slots[i] = -1;
+    t->count = 0;
+    t->failed = 0;
+}
+
+void strtab_free(StringTable *t) {
+    free(t->strs);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
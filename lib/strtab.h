@@ -0,0 +1,27 @@
+#ifndef STRTAB_H
+#define STRTAB_H
+
+#include <stddef.h>
+
+// 字符串表：把重复的字符串列（远端地址、进程、路径等）去重为下标，开放寻址哈希按需扩容
+// 表内只保存指针，被引用的字符串在表的生命周期内必须保持有效
+typedef struct {
+    const char **strs;     // 按首次出现顺序排列
+    int count;
+    int cap;
+    int *slots;            // 哈希槽，存 strs 下标，-1 表示空
+    size_t slot_cap;
+    int failed;            // 内存不足时置 1，调用方据此放弃导出
+} StringTable;
+
+void strtab_init(StringTable *t);
+
+// 返回字符串下标；内存不足时返回 0 并置 failed
+int strtab_intern(StringTable *t, const char *s);
+
+// 清空表内字符串但保留已分配的空间，供按段反复使用的调用方复用
+void strtab_reset(StringTable *t);
+
+void strtab_free(StringTable *t);
+
+#endif // STRTAB_H
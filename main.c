@@ -19,133 +19,46 @@
 #include "backend/scanner.h"
 #include "backend/kernel_probe.h"
 #include "backend/nl_listener.h"
+#include "backend/sock_diag.h"
+#include "lib/metrics_http.h"
+#include "lib/query_server.h"
+#include "lib/shm_publish.h"
+#include "lib/conn_filter.h"
+#include "lib/conn_track.h"
+#include "lib/listen_watch.h"
+#include "lib/pin_watch.h"
+#include "lib/port_exhaust.h"
+#include "lib/leak_watch.h"
+#include "lib/fanout.h"
+#include "lib/heavy_hitters.h"
+#include "lib/rollup.h"
+#include "lib/history.h"
+#include "lib/phase_timer.h"
+#include "lib/scan_sched.h"
+#include "tui.h"
 
 // 配置常量
 #define MAX_OVERVIEW_DISPLAY 12      // 总览最多显示的连接数
 #define REFRESH_POLL_ITERATIONS 20   // 刷新轮询次数
+#define SCAN_INTERVAL_MS 2000        // 全量扫描的定时间隔
+#define PID_SCAN_INTERVAL_MS 250     // PID 观察模式的扫描间隔（只读少数进程，开销很小）
+#define SCAN_FORCE_MS 5000           // 用户持续操作时最长推迟的扫描间隔（自适应时为当前间隔再加 3 秒）
+#define MAX_WATCH_PIDS 64
 #define POLL_INTERVAL_US 100000      // 轮询间隔（微秒），默认0.1秒
 
 
-// 颜色定义
-#define CLR_RST  "\033[0m"
-#define CL_BLD   "\033[1m"
-#define CL_GRN   "\033[32m"
-#define CL_YLW   "\033[33m"
-#define CL_CYN   "\033[36m"
-#define CL_MAG   "\033[35m"
-#define CL_RED   "\033[31m"
-#define BG_RED   "\033[41;37m"
-
-// 语言与视图状态
-typedef enum { LANG_CN, LANG_EN } LangType;
-typedef enum { VIEW_OVERVIEW = 1, VIEW_ALL, VIEW_ESTABLISHED, VIEW_LISTEN, VIEW_SUSPICIOUS } ViewType;
-// 全局配置与状态
-LangType current_lang = LANG_CN;
-ViewType current_view = VIEW_OVERVIEW;
-int scroll_offset = 0;
-char search_filter[64] = "";
-int is_searching = 0;
-SortMode current_sort = SORT_NONE;
-int selected_idx = 0; // 当前选中的列表行索引
-int show_detail = 0;  // 是否显示详情浮窗
-int kill_confirm = 0; // 是否处于终止确认状态
 
 // 驱动状态
 DriverTier current_tier = DRIVER_POLLING;
 int nl_fd = -1;
 
-// 国际化文本结构
-struct {
-    const char *title;
-    const char *ctrl_hint;
-    const char *scroll_hint;
-    const char *search_hint;
-    const char *sort_hint;
-    const char *driver_label;
-    const char *search_label;
-    const char *sort_label;
-    const char *board_total;
-    const char *board_est;
-    const char *board_listen;
-    const char *board_suspicious;
-    const char *top_proc_label;
-    const char *view_ov;
-    const char *view_all;
-    const char *view_conn;
-    const char *view_list;
-    const char *view_susp;
-    const char *col_proto;
-    const char *col_local;
-    const char *col_remote;
-    const char *col_status;
-    const char *col_proc;
-    const char *no_data;
-} ui_text;
-
-void update_ui_text() {
-    if (current_lang == LANG_CN) {
-        ui_text.title = "NCM 网络连接监测器 v2.0";
-        ui_text.ctrl_hint = "按 Q 退出 | L 切换 English | 1-5 切换视图";
-        ui_text.scroll_hint = "J/K/↑/↓ 滚动";
-        ui_text.search_hint = "/ 搜索";
-        ui_text.sort_hint = "S 排序";
-        ui_text.driver_label = "驱动级别";
-        ui_text.search_label = "搜索关键词";
-        ui_text.sort_label = "排序模式";
-        ui_text.board_total = "总连接数";
-        ui_text.board_est = "正在通信";
-        ui_text.board_listen = "监听中";
-        ui_text.board_suspicious = "可疑连接";
-        ui_text.top_proc_label = "最活跃进程";
-        ui_text.view_ov = "1.总览";
-        ui_text.view_all = "2.全量";
-        ui_text.view_conn = "3.通信中";
-        ui_text.view_list = "4.监听中";
-        ui_text.view_susp = "5.可疑连接";
-        ui_text.col_proto = "协议";
-        ui_text.col_local = "本地地址";
-        ui_text.col_remote = "远端地址";
-        ui_text.col_status = "状态";
-        ui_text.col_proc = "进程";
-        ui_text.no_data = "暂无匹配数据";
-    } else {
-        ui_text.title = "NCM - Network Monitor v2.0";
-        ui_text.ctrl_hint = "Q:Exit | L:Language | 1-5:Switch View";
-        ui_text.scroll_hint = "J/K/↑/↓:Scroll";
-        ui_text.search_hint = "/:Search";
-        ui_text.sort_hint = "S:Sort";
-        ui_text.driver_label = "DRIVER";
-        ui_text.search_label = "Filter";
-        ui_text.sort_label = "Sort";
-        ui_text.board_total = "TOTAL CONNS";
-        ui_text.board_est = "ESTABLISHED";
-        ui_text.board_listen = "LISTENING";
-        ui_text.board_suspicious = "SUSPICIOUS";
-        ui_text.top_proc_label = "Top Process";
-        ui_text.view_ov = "1.Overview";
-        ui_text.view_all = "2.All";
-        ui_text.view_conn = "3.Comm";
-        ui_text.view_list = "4.Listen";
-        ui_text.view_susp = "5.Suspicious";
-        ui_text.col_proto = "PROTO";
-        ui_text.col_local = "LOCAL ADDR";
-        ui_text.col_remote = "REMOTE ADDR";
-        ui_text.col_status = "STATUS";
-        ui_text.col_proc = "PROCESS";
-        ui_text.no_data = "No matching data";
-    }
-}
-
-// 状态翻译
-const char* trans_status(const char* st) {
-    if (current_lang == LANG_EN) return st;
-    if (strcmp(st, "ESTABLISHED") == 0) return "已连接";
-    if (strcmp(st, "LISTEN") == 0) return "监听中";
-    if (strcmp(st, "TIME_WAIT") == 0) return "等待关闭";
-    if (strcmp(st, "CLOSE_WAIT") == 0) return "等待关闭";
-    if (strcmp(st, "NONE") == 0) return "无状态";
-    return st;
-}
+// 运行模式
+int headless = 0;     // 无 TUI，仅扫描并对外服务（配合 --metrics-listen 等）
+double last_scan_ms = 0; // 最近一次扫描耗时
+int tcp_info_enabled = 0; // --tcp-info：每轮额外通过 sock_diag 采集 tcp_info 计数
+int collapse_requested = 0; // --collapse：界面模式下启用行折叠（扫描侧的监测、记录与发布始终逐行，只折叠界面所用的数据）
+FILE *profile_log = NULL; // --profile-log：每轮扫描追加一行 JSON 计时
+int history_mb = HISTORY_DEFAULT_MB; // --history-mb：界面模式下回放历史的内存预算，0 不记录
 
 // 非阻塞输入处理 (跨平台)
 // 特殊按键定义
@@ -211,173 +124,45 @@ int get_key() {
 }
 #endif
 
-// 清屏
-void clear_screen() {
-#ifdef _WIN32
-    system("cls");
-#else
-    // 恢复全屏清除模式以消除视图切换时的样式错乱和残影
-    printf("\033[2J\033[H");
-#endif
-}
-
-// 宽度感知打印 (处理 UTF-8 中文双倍宽度)
-void print_padded(const char* s, int target_width) {
-    int visual_width = 0;
-    const unsigned char *p = (const unsigned char *)s;
-    while (*p) {
-        if (*p < 128) { visual_width += 1; p += 1; }
-        else if (*p < 224) { visual_width += 1; p += 2; }
-        else if (*p < 240) { visual_width += 2; p += 3; } // 中文通常是 3 字节，2 列宽
-        else { visual_width += 2; p += 4; }
-    }
-    printf("%s", s);
-    for (int i = 0; i < target_width - visual_width; i++) printf(" ");
-}
-
-// 绘制单个统计盒子（封装以减少代码重复）
-void draw_stat_box(const char *label, int value, const char *color) {
-    printf("%s", color);
-    print_padded(label, 16);
-    printf(CLR_RST);
-}
-
-void draw_stats_board(ConnectionStats *stats) {
-    // 盒式布局：┌ + 16个─ + ┐ (总宽18)
-    printf(CL_BLD "┌────────────────┐ ┌────────────────┐ ┌────────────────┐ ┌────────────────┐\n");
-    
-    // 内容行：│ + 16位对齐内容 + │
-    printf("│" CL_CYN); print_padded(ui_text.board_total, 16); printf(CLR_RST "│ │" CL_GRN); print_padded(ui_text.board_est, 16); printf(CLR_RST "│ │" CL_YLW); print_padded(ui_text.board_listen, 16); printf(CLR_RST "│ │" CL_RED); print_padded(ui_text.board_suspicious, 16); printf(CLR_RST "│\n");
-    
-    // 数据行：同样 16 位宽度
-    printf("│" CL_BLD "%-16d" CLR_RST "│ │" CL_BLD "%-16d" CLR_RST "│ │" CL_BLD "%-16d" CLR_RST "│ │" CL_BLD "%-16d" CLR_RST "│\n", 
-           stats->total, stats->established, stats->listening, stats->suspicious);
-           
-    printf("└────────────────┘ └────────────────┘ └────────────────┘ └────────────────┘\n");
-    printf(CL_BLD " %s: " CLR_RST CL_MAG "%s" CLR_RST " (%d %s) | " CL_CYN "%s" CLR_RST " | " CL_YLW "%s" CLR_RST " | " CL_GRN "%s" CLR_RST "\n", 
-           ui_text.top_proc_label, stats->top_process, stats->top_process_count, 
-           (current_lang == LANG_CN ? "连接" : "conns"), ui_text.scroll_hint, ui_text.search_hint, ui_text.sort_hint);
-    
-    // 显示搜索和排序状态
-    if (is_searching || strlen(search_filter) > 0 || current_sort != SORT_NONE) {
-        printf(CL_CYN " %s: " CLR_RST CL_BLD "[ %s ]" CLR_RST " %s", 
-               ui_text.search_label, search_filter, (is_searching ? "_" : ""));
-        
-        if (current_sort != SORT_NONE) {
-            const char *sort_name = "NONE";
-            if (current_lang == LANG_CN) {
-                if (current_sort == SORT_BY_PID) sort_name = "PID";
-                else if (current_sort == SORT_BY_PROCESS) sort_name = "进程名";
-                else if (current_sort == SORT_BY_REMOTE) sort_name = "远端地址";
-            } else {
-                if (current_sort == SORT_BY_PID) sort_name = "PID";
-                else if (current_sort == SORT_BY_PROCESS) sort_name = "Process";
-                else if (current_sort == SORT_BY_REMOTE) sort_name = "Remote";
-            }
-            printf(" | " CL_YLW "%s: " CLR_RST CL_BLD "%s" CLR_RST, ui_text.sort_label, sort_name);
-        }
-        printf("\n");
-    }
-    printf("────────────────────────────────────────────────────────────────────────────────────\n");
-}
-
-// 聚合历史缓存 (60个点)
-#define TREND_HISTORY_SIZE 60
-int total_conn_history[TREND_HISTORY_SIZE];
-int history_idx = 0;
-
-// 全量快照缓存 (5轮)
+// 进程连接数突增检测：保存最近 BEHAVIOR_SNAPSHOTS 轮各进程的连接数（按 PID 的开放寻址表），
+// 本轮与其中的最高值比较；每轮只按 PID 计数一次，不再保存连接数组
 #define BEHAVIOR_SNAPSHOTS 5
+#define SPIKE_PID_SLOTS 4096         // 2 的幂；填到 3/4 后不再登记新 PID
 typedef struct {
-    ConnectionInfo *conns;
+    int32_t pid;                     // 0 为空槽
     int count;
-} HistorySnapshot;
+} PidCount;
 
-HistorySnapshot history_snapshots[BEHAVIOR_SNAPSHOTS];
-int snapshot_idx = 0;
+PidCount pid_counts[BEHAVIOR_SNAPSHOTS + 1][SPIKE_PID_SLOTS]; // 环形，pid_count_idx 为本轮
+int pid_count_idx = 0;
 
-void push_history(int total) {
-    total_conn_history[history_idx] = total;
-    history_idx = (history_idx + 1) % TREND_HISTORY_SIZE;
+PidCount *pid_count_slot(PidCount *table, int32_t pid) {
+    uint32_t s = ((uint32_t)pid * 2654435761u) & (SPIKE_PID_SLOTS - 1);
+    while (table[s].pid != 0 && table[s].pid != pid) s = (s + 1) & (SPIKE_PID_SLOTS - 1);
+    return &table[s];
 }
 
-// 绘制趋势字符图
-void draw_sparkline() {
-    const char* bars[] = {" ", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
-    int max = 1;
-    for (int i=0; i<TREND_HISTORY_SIZE; i++) if(total_conn_history[i] > max) max = total_conn_history[i];
-    
-    printf(CL_CYN " TREND: " CLR_RST);
-    for (int i=0; i<TREND_HISTORY_SIZE; i++) {
-        int idx = (history_idx + i) % TREND_HISTORY_SIZE;
-        int bar_idx = (total_conn_history[idx] * 7) / max;
-        printf("%s", bars[bar_idx]);
-    }
-    printf("\n");
-}
-
-// 显示详情浮窗
-void show_detail_overlay(ConnectionInfo *conn) {
-    printf("\033[2J\033[H"); // 全屏清除，进入详情
-    printf("\n\n" CL_BLD "  ┌────────────────────────────────────────────────────────────┐\n");
-    
-    // 标题行
-    printf("  │ " CL_MAG); print_padded("PROCESS DETAILS", 58); printf(CLR_RST " │\n");
-    printf("  ├────────────────────────────────────────────────────────────┤\n");
-    
-    char buf[64];
-    // PID
-    snprintf(buf, sizeof(buf), "%d", conn->pid);
-    printf("  │ " CL_CYN); print_padded("PID:       ", 11); printf(CLR_RST); print_padded(buf, 47); printf(" │\n");
-    
-    // COMM
-    printf("  │ " CL_CYN); print_padded("COMM:      ", 11); printf(CLR_RST); print_padded(conn->process, 47); printf(" │\n");
-    
-    // PROTO/ST
-    printf("  │ " CL_CYN); print_padded("PROTO/ST:  ", 11); printf(CLR_RST); print_padded(conn->status, 47); printf(" │\n");
-    
-    // LOCAL
-    printf("  │ " CL_CYN); print_padded("LOCAL:     ", 11); printf(CLR_RST); print_padded(conn->local_addr, 47); printf(" │\n");
-    
-    // REMOTE
-    printf("  │ " CL_CYN); print_padded("REMOTE:    ", 11); printf(CLR_RST); print_padded(conn->remote_addr, 47); printf(" │\n");
-    
-    // EXE PATH (处理换行)
-    printf("  │ " CL_CYN); print_padded("EXE PATH:  ", 11); printf(CLR_RST); 
-    if (strlen(conn->exe_path) <= 47) {
-        print_padded(conn->exe_path, 47); printf(" │\n");
-    } else {
-        char path_part[48];
-        strncpy(path_part, conn->exe_path, 47); path_part[47] = '\0';
-        print_padded(path_part, 47); printf(" │\n");
-        printf("  │            "); print_padded(conn->exe_path + 47, 47); printf(" │\n");
+// 统计本轮各进程的连接数
+void count_pid_conns(const ConnectionInfo *conns, int count) {
+    PidCount *table = pid_counts[pid_count_idx];
+    memset(table, 0, sizeof(pid_counts[0]));
+    int used = 0;
+    for (int i = 0; i < count; i++) {
+        if (conns[i].pid <= 0) continue;
+        PidCount *slot = pid_count_slot(table, conns[i].pid);
+        if (slot->pid == 0) {
+            if (used >= SPIKE_PID_SLOTS * 3 / 4) continue;
+            slot->pid = conns[i].pid;
+            used++;
+        }
+        slot->count++;
     }
-    
-    // RISK
-    printf("  │ " CL_RED); print_padded("RISK:      ", 11); printf(CLR_RST); 
-    print_padded(strlen(conn->risk_reason) ? conn->risk_reason : "Safe", 47); printf(" │\n");
-    
-    printf("  ├────────────────────────────────────────────────────────────┤\n");
-    // 底部提示
-    printf("  │ " CL_YLW); print_padded("Press ANY KEY to return", 58); printf(CLR_RST " │\n");
-    printf("  └────────────────────────────────────────────────────────────┘\n");
-    fflush(stdout);
 }
 
-void push_snapshot(ConnectionInfo *conns, int count) {
-    // 释放最旧的
-    if (history_snapshots[snapshot_idx].conns) {
-        free(history_snapshots[snapshot_idx].conns);
-    }
-    
-    // 深度拷贝当前快照
-    history_snapshots[snapshot_idx].count = count;
-    history_snapshots[snapshot_idx].conns = malloc(sizeof(ConnectionInfo) * count);
-    if (history_snapshots[snapshot_idx].conns) {
-        memcpy(history_snapshots[snapshot_idx].conns, conns, sizeof(ConnectionInfo) * count);
-    }
-    
-    snapshot_idx = (snapshot_idx + 1) % BEHAVIOR_SNAPSHOTS;
+// back 轮之前（0 为本轮）该进程的连接数
+int pid_conn_count(int back, int32_t pid) {
+    PidCount *table = pid_counts[(pid_count_idx + BEHAVIOR_SNAPSHOTS + 1 - back) % (BEHAVIOR_SNAPSHOTS + 1)];
+    return pid_count_slot(table, pid)->count;
 }
 
 // 检查某个进程是否在短时间内发起了大量新连接
@@ -385,12 +170,8 @@ int check_frequency_spike(int32_t pid, int current_count) {
     if (pid <= 0) return 0;
     
     int max_prev = 0;
-    for (int s = 0; s < BEHAVIOR_SNAPSHOTS; s++) {
-        if (!history_snapshots[s].conns) continue;
-        int prev_count = 0;
-        for (int i = 0; i < history_snapshots[s].count; i++) {
-            if (history_snapshots[s].conns[i].pid == pid) prev_count++;
-        }
+    for (int back = 1; back <= BEHAVIOR_SNAPSHOTS; back++) {
+        int prev_count = pid_conn_count(back, pid);
         if (prev_count > max_prev) max_prev = prev_count;
     }
     
@@ -398,14 +179,109 @@ int check_frequency_spike(int32_t pid, int current_count) {
     return (current_count > max_prev + 5);
 }
 
-void draw_sidebar() {
-    printf(CL_BLD " [%s] " CLR_RST, (current_lang == LANG_CN ? "菜单选择" : "VIEW"));
-    printf(current_view == VIEW_OVERVIEW ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_ov);
-    printf(current_view == VIEW_ALL ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_all);
-    printf(current_view == VIEW_ESTABLISHED ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_conn);
-    printf(current_view == VIEW_LISTEN ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_list);
-    printf(current_view == VIEW_SUSPICIOUS ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_susp);
-    printf("\n");
+// --profile-log：每轮扫描一行 {"ts_ms":..,"profile":{..}}，逐行刷新以便 tail -f / jq 实时消费
+void write_profile_log(long long now_ms) {
+    static StrBuf line;
+    line.len = 0;
+    strbuf_printf(&line, "{\"ts_ms\":%lld,\"profile\":", now_ms);
+    phase_format_json(&line);
+    strbuf_puts(&line, "}\n");
+    fwrite(line.data, 1, line.len, profile_log);
+    fflush(profile_log);
+}
+
+// 墙上时钟（Unix 毫秒）
+long long wall_clock_ms() {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    unsigned long long tt = ft.dwHighDateTime;
+    tt <<= 32;
+    tt |= ft.dwLowDateTime;
+    tt /= 10000;
+    tt -= 11644473600000ULL;
+    return (long long)tt;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+// 统一事件轮询：等待键盘 / Netlink / 对外服务 FD，最长阻塞 timeout_us 微秒
+// 对外服务（metrics 等）在此处非阻塞处理，不会拖慢扫描；select 出错返回 -1
+int poll_events(long timeout_us, int *key, int *has_netlink) {
+    *key = -1;
+    *has_netlink = 0;
+#ifdef _WIN32
+    Sleep(timeout_us / 1000);
+    if (!headless && _kbhit()) *key = get_key();
+    return 0;
+#else
+    fd_set readfds, writefds;
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    int max_fd = -1;
+    if (!headless) {
+        FD_SET(STDIN_FILENO, &readfds);
+        max_fd = STDIN_FILENO;
+    }
+    if (current_tier == DRIVER_NETLINK && nl_fd != -1) {
+        FD_SET(nl_fd, &readfds);
+        if (nl_fd > max_fd) max_fd = nl_fd;
+    }
+    max_fd = metrics_http_fill_fds(&readfds, &writefds, max_fd);
+    max_fd = query_server_fill_fds(&readfds, &writefds, max_fd);
+
+    struct timeval tv;
+    tv.tv_sec = timeout_us / 1000000;
+    tv.tv_usec = timeout_us % 1000000;
+
+    int activity = select(max_fd + 1, &readfds, &writefds, NULL, &tv);
+    if (activity < 0) return (errno == EINTR) ? 0 : -1;
+
+    if (activity > 0) {
+        if (!headless && FD_ISSET(STDIN_FILENO, &readfds)) {
+            *key = get_key();
+        }
+        if (current_tier == DRIVER_NETLINK && nl_fd != -1 && FD_ISSET(nl_fd, &readfds)) {
+            *has_netlink = 1;
+        }
+        metrics_http_handle(&readfds, &writefds);
+        query_server_handle(&readfds, &writefds);
+    }
+    return 0;
+#endif
+}
+
+void print_usage(const char *prog) {
+    printf("NCM - Network Connection Monitor v2.0\n");
+    printf("Usage: %s [options]\n", prog);
+    printf("Options:\n");
+    printf("  -e <file>                  Export connection report (HTML by default, - for stdout)\n");
+    printf("  --format <fmt>             Export format: html|json|csv|bin (default: by file extension)\n");
+    printf("  --metrics-listen <ip:port> Serve OpenMetrics at http://<ip:port>/metrics\n");
+    printf("  --query-socket <path>      Serve snapshot queries on a Unix domain socket\n");
+    printf("  --shm-publish <name>       Publish each snapshot to POSIX shm (e.g. /ncm)\n");
+    printf("  --stuck-threshold <ST=sec> Alert when a socket stays in state ST longer than sec\n");
+    printf("                             (defaults: SYN_SENT=30 CLOSE_WAIT=60 FIN_WAIT2=60, 0 disables)\n");
+    printf("  --state <ST[,ST...]>       Only scan sockets in these states (e.g. ESTABLISHED,CLOSE_WAIT)\n");
+    printf("  --port <port>              Only scan sockets whose local or remote port matches\n");
+    printf("  --cidr <a.b.c.d[/len]>     Only scan sockets whose remote address is in the range\n");
+    printf("                             (filters are applied in the kernel via sock_diag on Linux)\n");
+    printf("  -p <pid[,pid...]>          Only watch sockets owned by these processes (refreshes every %dms)\n", PID_SCAN_INTERVAL_MS);
+    printf("  --children                 With -p, also watch all descendant processes\n");
+    printf("  --pin <local,remote>       Pin a TCP connection and poll it every %dms in the TUI (repeatable)\n", PIN_POLL_INTERVAL_MS);
+    printf("  --collapse                 Collapse rows sharing process, remote address and state (TUI; G toggles)\n");
+    printf("  --proc-root <dir>          Read sockets and processes from this procfs (e.g. /host/proc)\n");
+    printf("  --tcp-info                 Collect per-socket byte/segment counters via sock_diag\n");
+    printf("  --headless                 Run without TUI (scan and serve only)\n");
+    printf("  --profile-log <file>       Append per-phase timings as one JSON line per scan (- for stdout)\n");
+    printf("  --cpu-budget <pct>         Adapt the scan interval to connection churn, keeping scan CPU under pct\n");
+    printf("                             of one core (e.g. 1%%; default: fixed %dms interval)\n", SCAN_INTERVAL_MS);
+    printf("  --history-mb <n>           Memory budget for scan history replay in the TUI (default: %d, 0 disables;\n"
+           "                             encoder scratch of ~0.5 KB per connection, plus ~1.5 KB once replaying, is extra)\n", HISTORY_DEFAULT_MB);
+    printf("  -h, --help                 Show this help message\n");
 }
 
 int main(int argc, char **argv) {
@@ -428,182 +304,242 @@ int main(int argc, char **argv) {
     current_tier = probe_kernel_features();
     if (current_tier == DRIVER_NETLINK) nl_fd = nl_init_listener();
     
-    // 原有参数处理
-    if (argc > 1 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0)) {
-        printf("NCM - Network Connection Monitor v2.0\n");
-        printf("Usage: %s [options]\n", argv[0]);
-        printf("Options:\n");
-        printf("  -e <file>  Export connection report to HTML\n");
-        printf("  -h, --help Show this help message\n");
-        return 0;
+    // 参数处理
+    const char *export_file = NULL;
+    const char *export_format = NULL;
+    const char *metrics_listen = NULL;
+    const char *query_socket = NULL;
+    const char *shm_name = NULL;
+    ConnFilter scan_filter;
+    conn_filter_init(&scan_filter);
+    int32_t watch_pids[MAX_WATCH_PIDS];
+    int watch_pid_count = 0;
+    int watch_children = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            export_file = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            export_format = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-listen") == 0 && i + 1 < argc) {
+            metrics_listen = argv[++i];
+        } else if (strcmp(argv[i], "--query-socket") == 0 && i + 1 < argc) {
+            query_socket = argv[++i];
+        } else if (strcmp(argv[i], "--shm-publish") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--stuck-threshold") == 0 && i + 1 < argc) {
+            if (conn_track_parse_threshold(argv[++i]) != 0) {
+                fprintf(stderr, "Invalid --stuck-threshold: %s (expected STATE=SECONDS)\n", argv[i]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--state") == 0 || strcmp(argv[i], "--port") == 0 ||
+                    strcmp(argv[i], "--cidr") == 0) && i + 1 < argc) {
+            if (conn_filter_set(&scan_filter, argv[i] + 2, argv[i + 1]) != 0) {
+                fprintf(stderr, "Invalid %s: %s\n", argv[i], argv[i + 1]);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            char buf[512];
+            snprintf(buf, sizeof(buf), "%s", argv[++i]);
+            for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+                char *end = NULL;
+                long pid = strtol(tok, &end, 10);
+                if (!end || *end != '\0' || pid <= 0 || pid > 0x7FFFFFFF || watch_pid_count == MAX_WATCH_PIDS) {
+                    fprintf(stderr, "Invalid -p: %s (expected pid[,pid...], at most %d)\n", argv[i], MAX_WATCH_PIDS);
+                    return 1;
+                }
+                watch_pids[watch_pid_count++] = (int32_t)pid;
+            }
+        } else if (strcmp(argv[i], "--children") == 0) {
+            watch_children = 1;
+        } else if (strcmp(argv[i], "--pin") == 0 && i + 1 < argc) {
+            if (pin_watch_parse(argv[++i]) != 0) {
+                fprintf(stderr, "Invalid --pin: %s (expected a.b.c.d:port,a.b.c.d:port, at most %d)\n", argv[i], PIN_WATCH_MAX);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--collapse") == 0) {
+            collapse_requested = 1;
+        } else if (strcmp(argv[i], "--proc-root") == 0 && i + 1 < argc) {
+            if (scanner_set_proc_root(argv[++i]) != 0) {
+                fprintf(stderr, "Invalid --proc-root: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tcp-info") == 0) {
+            tcp_info_enabled = 1;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else if (strcmp(argv[i], "--cpu-budget") == 0 && i + 1 < argc) {
+            if (scan_sched_parse_budget(argv[++i]) != 0) {
+                fprintf(stderr, "Invalid --cpu-budget: %s (expected a percentage such as 1%%)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--history-mb") == 0 && i + 1 < argc) {
+            char *end = NULL;
+            long mb = strtol(argv[++i], &end, 10);
+            if (!end || *end != '\0' || mb < 0 || mb > 4096) {
+                fprintf(stderr, "Invalid --history-mb: %s (expected 0..4096)\n", argv[i]);
+                return 1;
+            }
+            history_mb = (int)mb;
+        } else if (strcmp(argv[i], "--profile-log") == 0 && i + 1 < argc) {
+            const char *path = argv[++i];
+            profile_log = strcmp(path, "-") == 0 ? stdout : fopen(path, "a");
+            if (!profile_log) {
+                fprintf(stderr, "Cannot open --profile-log: %s\n", path);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
     }
 
-    if (argc == 3 && strcmp(argv[1], "-e") == 0) {
+    scanner_set_filter(&scan_filter);
+    if (watch_pid_count > 0) scanner_set_pids(watch_pids, watch_pid_count, watch_children);
+    scan_sched_init(watch_pid_count > 0 ? PID_SCAN_INTERVAL_MS : SCAN_INTERVAL_MS, SCAN_FORCE_MS);
+
+    if (export_file) {
         int count = 0;
         ConnectionInfo *conns = scanner_get_connections(&count);
         if (!conns && count == 0) return 1;
-        int result = export_html_report(argv[2], conns, count);
+        heavy_hitters_update(conns, count, wall_clock_ms());
+        int result = export_report(export_file, export_format, conns, count);
         scanner_free_connections(conns, count);
         return result;
     }
+
+    if (collapse_requested && !headless) conn_collapse_enable(1);
+    // 固定连接只在界面循环中轮询与展示，无界面模式下不会被轮询：直接拒绝，不静默忽略
+    if (headless && pin_watch_count() > 0) {
+        fprintf(stderr, "--pin needs the TUI and cannot be combined with --headless\n");
+        return 1;
+    }
+
+    if (metrics_listen && metrics_http_start(metrics_listen) != 0) return 1;
+    if (query_socket && query_server_start(query_socket) != 0) return 1;
+    if (shm_name && shm_publish_start(shm_name) != 0) return 1;
     
-    set_non_blocking_input(1);
-    memset(history_snapshots, 0, sizeof(history_snapshots));
+    if (!headless) set_non_blocking_input(1);
+    if (!headless && history_init((size_t)history_mb << 20) != 0) {
+        fprintf(stderr, "Cannot allocate %d MB for --history-mb\n", history_mb);
+        set_non_blocking_input(0);
+        return 1;
+    }
     
     int needs_data_scan = 1;
-    time_t last_scan_time = 0;
+    long long last_scan_at = 0; // 上次扫描时刻（毫秒）
     long long last_interaction_time = 0; // 毫秒级交互记录
     ConnectionInfo *conns = NULL;
     int count = 0;
     ConnectionStats stats;
+    ConnectionStats replay_stats;
+    int64_t replay_seq = -1; // 回放中的扫描序号，-1 为实时
 
     while (1) {
-        update_ui_text();
-        
-        long long now_ms;
-        time_t now_sec;
-
-        #ifdef _WIN32
-        FILETIME ft;
-        GetSystemTimeAsFileTime(&ft);
-        unsigned long long tt = ft.dwHighDateTime;
-        tt <<= 32;
-        tt |= ft.dwLowDateTime;
-        tt /= 10000;
-        tt -= 11644473600000ULL;
-        now_ms = (long long)tt;
-        now_sec = (time_t)(tt / 1000);
-        #else
-        struct timeval tv_now;
-        gettimeofday(&tv_now, NULL);
-        now_ms = (long long)tv_now.tv_sec * 1000 + tv_now.tv_usec / 1000;
-        now_sec = tv_now.tv_sec;
-        #endif
+        long long now_ms = wall_clock_ms();
+        // 两次扫描之间的轮询次数随扫描间隔缩放，保证 PID 观察模式或自适应缩短间隔时界面同样以亚秒级刷新
+        int poll_iterations = scan_sched_interval_ms() * 1000 / POLL_INTERVAL_US;
+        if (poll_iterations < 1) poll_iterations = 1;
+        if (poll_iterations > REFRESH_POLL_ITERATIONS) poll_iterations = REFRESH_POLL_ITERATIONS;
 
         // 策略：如果用户正在操作（过去 500ms 内有按键），推迟扫描
-        // 除非数据已经超过 5 秒没有更新，必须强制刷新
+        // 除非数据已经超过强制刷新时限（默认 5 秒）没有更新
         int user_is_busy = (now_ms - last_interaction_time < 500);
-        if (now_sec - last_scan_time >= 5) needs_data_scan = 1; // 强迫症更新
-        else if (now_sec - last_scan_time >= 2 && !user_is_busy) needs_data_scan = 1; // 正常定时更新
+        if (now_ms - last_scan_at >= scan_sched_force_ms()) needs_data_scan = 1; // 强迫症更新
+        else if (now_ms - last_scan_at >= scan_sched_interval_ms() && !user_is_busy) needs_data_scan = 1; // 正常定时更新
 
         if (needs_data_scan) {
-            last_scan_time = now_sec;
+            last_scan_at = now_ms;
             if (conns) scanner_free_connections(conns, count); 
+            phase_scan_begin();
+            uint64_t cpu_start = scan_sched_cpu_ns();
+            uint64_t t = phase_now_ns();
             conns = scanner_get_connections(&count);
+            t = phase_end(PHASE_SCAN, t);
+            last_scan_ms = phase_hist(PHASE_SCAN)->last_ns / 1e6;
             if (!conns && count == 0) {
                 printf(CL_BLD CL_RED "Error: Connection Scan Failed\n" CLR_RST);
                 sleep(1); continue;
             }
-            push_history(count);
             calculate_stats(conns, count, &stats);
+            rollup_ingest(&stats, (int64_t)(now_ms / 1000));
+            t = phase_end(PHASE_STATS, t);
+            int fanout = fanout_update(conns, count);
+            count_pid_conns(conns, count);
             for (int i = 0; i < count; i++) {
                 is_suspicious(&conns[i]);
-                int cur_proc_conns = 0;
                 if (conns[i].pid > 0) {
-                    for(int j=0; j<count; j++) if(conns[j].pid == conns[i].pid) cur_proc_conns++;
-                    if (check_frequency_spike(conns[i].pid, cur_proc_conns)) strcpy(conns[i].risk_reason, "Spike");
+                    if (check_frequency_spike(conns[i].pid, pid_conn_count(0, conns[i].pid))) strcpy(conns[i].risk_reason, "Spike");
+                    // 连向的不同远端 IP / 端口数相对该进程自身基线跳升（扫描器、蠕虫）
+                    if (fanout && fanout_is_flagged(conns[i].pid)) strcpy(conns[i].risk_reason, "FanOut");
                 }
             }
+            pid_count_idx = (pid_count_idx + 1) % (BEHAVIOR_SNAPSHOTS + 1);
+            t = phase_end(PHASE_RISK, t);
+            // sock_diag 查的是本机内核：--proc-root 指向其他目录时行与之对不上，不补充
+            if (scanner_proc_root_is_live()) {
+                if (tcp_info_enabled) sock_diag_fill_tcp_info(conns, count);
+                sock_diag_fill_listen_backlog(conns, count);
+            }
+            listen_watch_update(conns, count);
+            port_exhaust_update(conns, count, (int64_t)now_ms);
+            int leaking = leak_watch_update(conns, count, (int64_t)now_ms);
+            heavy_hitters_update(conns, count, (int64_t)now_ms);
+            stats.stuck = conn_track_update(conns, count, (int64_t)now_ms);
+            const PortDest *worst;
+            stats.port_at_risk = port_exhaust_at_risk();
+            stats.leaking = leaking;
+            stats.port_util_max = port_exhaust_ranked(&worst, 1) == 1 ? port_exhaust_pct(worst) : 0;
+            t = phase_end(PHASE_ENRICH, t);
+            phase_scan_end(count);
+            history_record(conns, count, &stats, (int64_t)now_ms);
+            metrics_http_publish(conns, count, &stats, last_scan_ms);
+            query_server_publish(conns, count);
+            shm_publish_update(conns, count);
+            phase_end(PHASE_PUBLISH, t);
+            scan_sched_record(scan_sched_cpu_ns() - cpu_start, count, conn_track_churn());
+            if (profile_log) write_profile_log(now_ms);
+            // 以上都在逐行数据上完成（分组的代表行每轮不同，不适合作为跟踪与发布的键），之后只为界面折叠
+            count = conn_collapse_rows(conns, count);
             needs_data_scan = 0;
         }
 
-        if (current_sort != SORT_NONE) sort_connections(conns, count, current_sort);
-
-        clear_screen();
-        printf(CL_BLD CL_GRN " %s " CLR_RST "  [%s]  " CL_YLW "[%s: %s]" CLR_RST "\n", 
-               ui_text.title, ui_text.ctrl_hint, ui_text.driver_label, get_driver_name(current_tier));
-        draw_sparkline();
-        printf("\n");
-        
-        draw_stats_board(&stats);
-        draw_sidebar();
-        printf("\n");
-
-        printf(CL_BLD);
-        print_padded(ui_text.col_proto, 6);
-        print_padded(ui_text.col_local, 22);
-        print_padded(ui_text.col_remote, 22);
-        print_padded(ui_text.col_status, 12);
-        print_padded(ui_text.col_proc, 12);
-        print_padded("RISK", 10);
-        printf(CLR_RST "\n");
-        printf(" ───────────────────────────────────────────────────────────────────────────────────\n");
-
-        int match_count = 0;
-        ConnectionInfo **filtered_conns = malloc(sizeof(ConnectionInfo*) * (count > 0 ? count : 1));
-        if (!filtered_conns) {
-            scanner_free_connections(conns, count);
-            continue; 
-        }
-
-        for (int i = 0; i < count; i++) {
-            int vm = 0;
-            switch (current_view) {
-                case VIEW_OVERVIEW: if (conns[i].status_enum == CONN_STATUS_ESTABLISHED && is_external_connection(&conns[i])) vm = 1; break;
-                case VIEW_ALL: vm = 1; break;
-                case VIEW_ESTABLISHED: if (conns[i].status_enum == CONN_STATUS_ESTABLISHED) vm = 1; break;
-                case VIEW_LISTEN: if (conns[i].status_enum == CONN_STATUS_LISTEN) vm = 1; break;
-                case VIEW_SUSPICIOUS: if (strlen(conns[i].risk_reason) > 0) vm = 1; break;
+        if (headless) {
+            // 无界面模式：两次扫描之间只服务外部请求与驱动事件
+            for (int i = 0; i < poll_iterations; i++) {
+                int key, has_netlink;
+                if (poll_events(POLL_INTERVAL_US, &key, &has_netlink) < 0) break;
+                // 驱动事件触发的重扫同样不早于 CPU 预算允许的最短间隔
+                if (has_netlink && nl_wait_for_event(nl_fd) == 1 && wall_clock_ms() - last_scan_at >= scan_sched_floor_ms()) { needs_data_scan = 1; break; }
             }
-
-            if (vm && strlen(search_filter) > 0) {
-                if (strstr(conns[i].process, search_filter) == NULL && 
-                    strstr(conns[i].remote_addr, search_filter) == NULL) {
-                    vm = 0;
-                }
-            }
-            if (vm) filtered_conns[match_count++] = &conns[i];
-        }
-
-        // 滚动与选择自适应
-        int display_limit = 15; 
-        if (selected_idx >= match_count && match_count > 0) selected_idx = match_count - 1;
-        if (selected_idx < 0) selected_idx = 0;
-        
-        if (selected_idx < scroll_offset) scroll_offset = selected_idx;
-        if (selected_idx >= scroll_offset + display_limit) scroll_offset = selected_idx - display_limit + 1;
-
-        int rendered = 0;
-        for (int i = scroll_offset; i < match_count && rendered < display_limit; i++) {
-            const char *st_clr = CLR_RST;
-            if (filtered_conns[i]->status_enum == CONN_STATUS_ESTABLISHED) st_clr = CL_GRN;
-            if (strlen(filtered_conns[i]->risk_reason) > 0) st_clr = BG_RED;
-
-            if (i == selected_idx) printf("\033[7m"); 
-            
-            print_padded(filtered_conns[i]->protocol, 6);
-            print_padded(filtered_conns[i]->local_addr, 22);
-            print_padded(filtered_conns[i]->remote_addr, 22);
-            printf("%s", st_clr);
-            print_padded(trans_status(filtered_conns[i]->status), 12);
-            printf(CLR_RST);
-            if (i == selected_idx) printf("\033[7m");
-            print_padded(filtered_conns[i]->process, 12);
-            printf(CL_YLW);
-            print_padded(filtered_conns[i]->risk_reason, 10);
-            printf(CLR_RST "\n");
-            rendered++;
+            continue;
         }
 
-        if (rendered == 0) printf("\n   (%s)\n", ui_text.no_data);
-        else {
-            printf("\n" CL_CYN "   [#%d/%d %s | Enter:%s | K:%s]\n" CLR_RST, 
-                   selected_idx + 1, match_count, 
-                   (current_lang == LANG_CN ? "已选中" : "Selected"),
-                   (current_lang == LANG_CN ? "详情" : "Detail"),
-                   (current_lang == LANG_CN ? "终止" : "Kill"));
-        }
-        
-        if (kill_confirm && match_count > 0 && selected_idx < match_count) {
-            printf(BG_RED " CONFIRM KILL PID %d (%s)? [y/N]: " CLR_RST, 
-                   filtered_conns[selected_idx]->pid, filtered_conns[selected_idx]->process);
-            fflush(stdout);
+        TuiFrame frame = { .conns = conns, .count = count, .stats = &stats, .now_ms = now_ms,
+                           .driver_name = get_driver_name(current_tier), .tcp_info = tcp_info_enabled };
+        if (replay_seq >= 0) {
+            // 回放：以历史中该轮的连接表与统计代替实时数据，所有视图与过滤照常生效；扫描与记录在后台继续
+            int64_t first, last;
+            history_range(&first, &last);
+            if (replay_seq < first) replay_seq = first; // 所在的段已被淘汰时停在最旧的一轮
+            if (replay_seq < last && history_load(replay_seq, &frame.conns, &frame.count, &replay_stats) == 0) {
+                frame.count = conn_collapse_rows(frame.conns, frame.count);
+                frame.stats = &replay_stats;
+                frame.now_ms = history_time_ms(replay_seq);
+                frame.live_ms = now_ms;
+                frame.replay_back = (int)(last - replay_seq);
+            } else {
+                replay_seq = -1;
+            }
         }
-        // 渲染完成后清除屏幕剩余部分，确保长列表切短列表时没有残影
-        printf("\033[J");
-        fflush(stdout);
+        tui_render_frame(&frame);
+        int match_count = 0;
+        ConnectionInfo **filtered_conns = tui_rows(&match_count);
 
-        push_snapshot(conns, count);
         // scanner_free_connections(conns, count); // 现在由 data_scan 逻辑控制释放时机
         fflush(stdout);
 
@@ -612,58 +548,18 @@ int main(int argc, char **argv) {
         
         // 降低轮询强度：将外部 20 次循环改为 1 次阻塞等待
         // 这里的 REFRESH_POLL_ITERATIONS 调整为内部逻辑控制
-        for (int i = 0; i < REFRESH_POLL_ITERATIONS; i++) {
+        for (int i = 0; i < poll_iterations; i++) {
             int key = -1;
             int has_netlink = 0;
 
-            #ifdef _WIN32
-            Sleep(POLL_INTERVAL_US / 1000);
-            if (_kbhit()) {
-                key = get_key();
-            }
-            #else
-            int max_fd = (nl_fd > STDIN_FILENO) ? nl_fd : STDIN_FILENO;
-            fd_set readfds;
-            FD_ZERO(&readfds);
-            FD_SET(STDIN_FILENO, &readfds);
-            if (current_tier == DRIVER_NETLINK && nl_fd != -1) {
-                FD_SET(nl_fd, &readfds);
-            }
+            if (poll_events(POLL_INTERVAL_US, &key, &has_netlink) < 0) break;
 
-            struct timeval tv;
-            tv.tv_sec = 0;
-            tv.tv_usec = POLL_INTERVAL_US; // 0.1s 阻塞/超时
-
-            int activity = select(max_fd + 1, &readfds, NULL, NULL, &tv);
-            
-            if (activity < 0 && errno != EINTR) break;
-            
-            if (activity > 0) {
-                if (FD_ISSET(STDIN_FILENO, &readfds)) {
-                    key = get_key();
-                }
-                if (current_tier == DRIVER_NETLINK && nl_fd != -1 && FD_ISSET(nl_fd, &readfds)) {
-                    has_netlink = 1;
-                }
-            }
-            #endif
+            // 固定连接走独立的高频定时器，状态或队列变化时立即重绘
+            if (pin_watch_poll(wall_clock_ms()) > 0) force_refresh = 1;
 
             // A. 处理用户输入
             if (key != -1) {
-                #ifdef _WIN32
-                FILETIME ft_int;
-                GetSystemTimeAsFileTime(&ft_int);
-                unsigned long long tt_int = ft_int.dwHighDateTime;
-                tt_int <<= 32;
-                tt_int |= ft_int.dwLowDateTime;
-                tt_int /= 10000;
-                tt_int -= 11644473600000ULL;
-                last_interaction_time = (long long)tt_int;
-                #else
-                struct timeval tv_int;
-                gettimeofday(&tv_int, NULL);
-                last_interaction_time = (long long)tv_int.tv_sec * 1000 + tv_int.tv_usec / 1000;
-                #endif
+                last_interaction_time = wall_clock_ms();
 
                 if (kill_confirm) {
                     if (key == 'y' || key == 'Y') {
@@ -683,13 +579,65 @@ int main(int argc, char **argv) {
                     }
                     force_refresh = 1;
                 } else {
-                    if (key == 'q' || key == 'Q') { set_non_blocking_input(0); printf("\nExiting...\n"); return 0; }
+                    if (key == 'q' || key == 'Q') { set_non_blocking_input(0); metrics_http_stop(); query_server_stop(); shm_publish_stop(); conn_track_free(); sock_diag_close(); history_free(); tui_free(); printf("\nExiting...\n"); return 0; }
+                    if ((key == 'p' || key == 'P') && match_count > 0) {
+                        // 只有 TCP 非监听连接才有唯一四元组可供精确查询
+                        const ConnectionInfo *c = filtered_conns[selected_idx];
+                        if (strcmp(c->protocol, "TCP") == 0 && c->status_enum != CONN_STATUS_LISTEN) {
+                            pin_watch_toggle(c->local_addr, c->remote_addr);
+                            force_refresh = 1;
+                        }
+                    }
+                    if (key == 'g' || key == 'G') {
+                        conn_collapse_enable(!conn_collapse_enabled());
+                        needs_data_scan = 1; selected_idx = 0; scroll_offset = 0; force_refresh = 1;
+                    }
+                    if ((key == 'e' || key == 'E') && match_count > 0 && conn_collapse_enabled()) {
+                        // 展开 / 收起选中的分组，下一轮扫描按逐行明细采集该分组
+                        const ConnectionInfo *c = filtered_conns[selected_idx];
+                        if (c->group_count > 1 || conn_collapse_is_expanded(c)) {
+                            conn_collapse_toggle_expand(c);
+                            needs_data_scan = 1; force_refresh = 1;
+                        }
+                    }
+                    if ((key == 'r' || key == 'R') && current_view == VIEW_HEALTH) { health_by_rtt = !health_by_rtt; force_refresh = 1; }
+                    if (key == 'z' || key == 'Z') { trend_res = (trend_res + 1) % ROLLUP_RES_COUNT; force_refresh = 1; }
+                    if (key == 'x' || key == 'X') {
+                        // 跳过尚未分配进程的序列槽位
+                        do trend_series = (trend_series + 1) % ROLLUP_SERIES; while (!rollup_series_name(trend_series));
+                        force_refresh = 1;
+                    }
+                    if (key == 'h' || key == 'H') {
+                        // 第一次按进入热点远端视图，之后在主机与网段之间切换
+                        if (current_view == VIEW_HITTERS) hitters_by_prefix = !hitters_by_prefix;
+                        else current_view = VIEW_HITTERS;
+                        selected_idx = 0; scroll_offset = 0; force_refresh = 1;
+                    }
+                    if (key == '[' || key == '{') {
+                        // 从实时进入回放时由上一轮开始（最新一轮即实时画面）；到最旧一轮时停住
+                        int64_t first, last;
+                        if (history_range(&first, &last) > 1) {
+                            int64_t from = replay_seq >= 0 ? replay_seq : last;
+                            from -= key == '{' ? REPLAY_JUMP_SCANS : 1;
+                            replay_seq = from < first ? first : from;
+                            force_refresh = 1;
+                        }
+                    }
+                    if ((key == ']' || key == '}') && replay_seq >= 0) {
+                        int64_t first, last;
+                        history_range(&first, &last);
+                        replay_seq += key == '}' ? REPLAY_JUMP_SCANS : 1;
+                        if (replay_seq >= last) replay_seq = -1; // 走到最新一轮即回到实时
+                        force_refresh = 1;
+                    }
+                    if (key == 27 && replay_seq >= 0) { replay_seq = -1; force_refresh = 1; }
+                    if (key == 't' || key == 'T') { show_profiler = !show_profiler; force_refresh = 1; }
                     if (key == 'l' || key == 'L') { current_lang = (current_lang == LANG_CN) ? LANG_EN : LANG_CN; force_refresh = 1; }
                     if (key == '/') { is_searching = 1; search_filter[0] = '\0'; force_refresh = 1; }
-                    if (key == 's' || key == 'S') { current_sort = (SortMode)((current_sort + 1) % 4); force_refresh = 1; }
+                    if (key == 's' || key == 'S') { current_sort = (SortMode)((current_sort + 1) % SORT_MODE_COUNT); force_refresh = 1; }
                     if (key == 'j' || key == 'J' || key == KEY_UP) { if (selected_idx < match_count - 1) { selected_idx++; force_refresh = 1; } }
                     if (key == 'k' || key == 'K' || key == KEY_UP) { if (selected_idx > 0) { selected_idx--; force_refresh = 1; } }
-                    if (key == 'K') { if (match_count > 0 && filtered_conns[selected_idx]->pid > 0) { kill_confirm = 1; force_refresh = 1; } }
+                    if (key == 'K' && replay_seq < 0) { if (match_count > 0 && filtered_conns[selected_idx]->pid > 0) { kill_confirm = 1; force_refresh = 1; } }
                     if (key == 10 || key == 13) { 
                         if (match_count > 0) { show_detail_overlay(filtered_conns[selected_idx]); while(get_key() == -1) 
                             #ifdef _WIN32
@@ -700,23 +648,32 @@ int main(int argc, char **argv) {
                         }
                         force_refresh = 1;
                     }
-                    if (key >= '1' && key <= '5') { current_view = (ViewType)(key - '0'); selected_idx = 0; scroll_offset = 0; force_refresh = 1; }
+                    if (key >= '0' && key <= '9') {
+                        int view = key == '0' ? 10 : key - '0';
+                        if (view <= VIEW_MAX) { current_view = (ViewType)view; selected_idx = 0; scroll_offset = 0; force_refresh = 1; }
+                    }
                 }
             }
 
             // B. 处理内核驱动事件
             if (has_netlink) {
-                if (nl_wait_for_event(nl_fd) == 1) {
+                if (nl_wait_for_event(nl_fd) == 1 && wall_clock_ms() - last_scan_at >= scan_sched_floor_ms()) {
                     force_refresh = 1; 
-                    needs_data_scan = 1; // 有新驱动事件，标记需要重扫数据
+                    needs_data_scan = 1; // 有新驱动事件，标记需要重扫数据（不早于 CPU 预算允许的最短间隔）
                 }
             }
 
             if (force_refresh) break;
         }
-        free(filtered_conns);
     }
 
     set_non_blocking_input(0);
+    metrics_http_stop();
+    query_server_stop();
+    shm_publish_stop();
+    conn_track_free();
+    sock_diag_close();
+    history_free();
+    tui_free();
     return 0;
 }
@@ -0,0 +1,42 @@
+#include <stddef.h>
+#include "tools/alloc_count.h"
+
+static AllocCounts counts;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t n, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+void __wrap_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+    counts.allocs++;
+    counts.bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    counts.allocs++;
+    counts.bytes += n * size;
+    return __real_calloc(n, size);
+}
+
+// realloc 可能搬移数据，按一次分配计
+void *__wrap_realloc(void *ptr, size_t size) {
+    counts.allocs++;
+    counts.bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr) counts.frees++;
+    __real_free(ptr);
+}
+
+void alloc_count_snapshot(AllocCounts *out) {
+    *out = counts;
+}
@@ -0,0 +1,18 @@
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+
+#include <stdint.h>
+
+// 堆分配计数：目标以 -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free 链接 alloc_count.c 后，
+// 参与链接的目标文件（被测模块与基准自身）发出的调用都会经过计数；libc 内部的分配不计
+// 单线程使用，计数不加锁
+
+typedef struct {
+    uint64_t allocs;     // malloc / calloc / realloc 次数
+    uint64_t frees;
+    uint64_t bytes;      // 申请的字节数累计
+} AllocCounts;
+
+void alloc_count_snapshot(AllocCounts *out);
+
+#endif // ALLOC_COUNT_H
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "tools/conn_synth.h"
+
+#define SYNTH_PROCS 400
+#define SYNTH_PID_BASE 1000
+#define SYNTH_EPOCH 1700000000
+
+static const char *proc_names[] = { "nginx", "postgres", "java", "redis-server", "node", "python3", "envoy", "sshd", "haproxy", "containerd" };
+static const char *proc_exes[] = { "/usr/sbin/nginx", "/usr/lib/postgresql/15/bin/postgres", "/usr/lib/jvm/java-17/bin/java",
+                                   "/usr/bin/redis-server", "/usr/bin/node", "/usr/bin/python3.11", "/usr/local/bin/envoy",
+                                   "/usr/sbin/sshd", "/usr/sbin/haproxy", "/usr/bin/containerd" };
+static const uint16_t service_ports[] = { 80, 443, 5432, 6379, 8080, 9090, 22, 3306 };
+#define PICK(arr) (arr[rng() % (sizeof(arr) / sizeof(arr[0]))])
+
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static ConnectionStatus pick_tcp_state(void) {
+    uint32_t r = rng() % 100;
+    if (r < 60) return CONN_STATUS_ESTABLISHED;
+    if (r < 80) return CONN_STATUS_TIME_WAIT;
+    if (r < 88) return CONN_STATUS_CLOSE_WAIT;
+    if (r < 92) return CONN_STATUS_SYN_SENT;
+    if (r < 95) return CONN_STATUS_FIN_WAIT2;
+    if (r < 97) return CONN_STATUS_FIN_WAIT1;
+    return CONN_STATUS_LAST_ACK;
+}
+
+static void random_remote_ip(char *out, size_t size) {
+    uint32_t r = rng() % 10;
+    if (r == 0) snprintf(out, size, "127.0.0.1");
+    else if (r < 7) snprintf(out, size, "10.2.%u.%u", rng() % 16, 1 + rng() % 32);
+    else snprintf(out, size, "%u.%u.%u.%u", 1 + rng() % 223, rng() % 256, rng() % 256, 1 + rng() % 254);
+}
+
+// 进程下标 -> 名称 / 路径（按下标固定，同一进程的各连接一致）
+static void fill_owner(ConnectionInfo *c, int owner) {
+    const char *name = proc_names[owner % (int)(sizeof(proc_names) / sizeof(proc_names[0]))];
+    const char *exe = proc_exes[owner % (int)(sizeof(proc_exes) / sizeof(proc_exes[0]))];
+    c->pid = SYNTH_PID_BASE + owner;
+    snprintf(c->process, sizeof(c->process), "%s", name);
+    if (owner % 100 == 99) snprintf(c->exe_path, sizeof(c->exe_path), "/tmp/.cache/%s", name);
+    else if (owner % 200 == 150) snprintf(c->exe_path, sizeof(c->exe_path), "/home/deploy/.local/bin/%s", name);
+    else if (owner % 20 == 7) snprintf(c->exe_path, sizeof(c->exe_path), "Access Denied");
+    else snprintf(c->exe_path, sizeof(c->exe_path), "%s", exe);
+}
+
+void conn_synth_fill(ConnectionInfo *conns, int count, unsigned int seed) {
+    rng_state = seed ? seed : 0x9E3779B9u;
+    for (int i = 0; i < count; i++) {
+        ConnectionInfo *c = &conns[i];
+        memset(c, 0, sizeof(*c));
+        char lip[16], rip[16];
+        snprintf(lip, sizeof(lip), "10.0.%u.%u", rng() % 4, 1 + rng() % 4);
+        int udp = rng() % 10 == 0;
+        snprintf(c->protocol, sizeof(c->protocol), "%s", udp ? "UDP" : "TCP");
+
+        if (!udp && i % 32 == 0) {
+            c->status_enum = CONN_STATUS_LISTEN;
+            snprintf(c->local_addr, sizeof(c->local_addr), "0.0.0.0:%u", PICK(service_ports));
+            snprintf(c->remote_addr, sizeof(c->remote_addr), "0.0.0.0:0");
+            c->rx_queue = rng() % 8;
+            c->backlog = 511;
+        } else if (udp) {
+            c->status_enum = CONN_STATUS_NONE;
+            snprintf(c->local_addr, sizeof(c->local_addr), "%s:%u", lip, 32768 + rng() % 28000);
+            if (rng() % 4 == 0) snprintf(c->remote_addr, sizeof(c->remote_addr), "10.1.%u.%u:53", rng() % 8, 1 + rng() % 254);
+            else snprintf(c->remote_addr, sizeof(c->remote_addr), "0.0.0.0:0");
+        } else {
+            c->status_enum = pick_tcp_state();
+            random_remote_ip(rip, sizeof(rip));
+            // 约 5% 的连接指向非常用端口，触发端口审计
+            uint32_t rport = rng() % 20 == 0 ? 1024 + rng() % 64000 : PICK(service_ports);
+            if (rng() % 2) {
+                snprintf(c->local_addr, sizeof(c->local_addr), "%s:%u", lip, 32768 + rng() % 28000);
+                snprintf(c->remote_addr, sizeof(c->remote_addr), "%s:%u", rip, rport);
+            } else {
+                snprintf(c->local_addr, sizeof(c->local_addr), "%s:%u", lip, PICK(service_ports));
+                snprintf(c->remote_addr, sizeof(c->remote_addr), "%s:%u", rip, 1024 + rng() % 64000);
+            }
+            if (c->status_enum == CONN_STATUS_ESTABLISHED && rng() % 20 == 0) c->tx_queue = rng() % 65536;
+        }
+        snprintf(c->status, sizeof(c->status), "%s", conn_status_name(c->status_enum));
+
+        if (c->status_enum == CONN_STATUS_TIME_WAIT) {
+            snprintf(c->process, sizeof(c->process), "N/A");
+            snprintf(c->exe_path, sizeof(c->exe_path), "N/A");
+        } else {
+            // 两个均匀数相乘后偏向小下标：少数进程持有大部分连接
+            uint64_t a = rng() % SYNTH_PROCS, b = rng() % SYNTH_PROCS;
+            fill_owner(c, (int)(a * b / SYNTH_PROCS));
+            c->inode = 100000 + (uint64_t)i;
+        }
+        c->group_count = 1;
+        c->first_seen = SYNTH_EPOCH - (int64_t)(rng() % 86400);
+        c->state_since = c->first_seen + (int64_t)(rng() % 60);
+    }
+}
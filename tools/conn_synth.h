@@ -0,0 +1,15 @@
+#ifndef CONN_SYNTH_H
+#define CONN_SYNTH_H
+
+#include "backend/scanner.h"
+
+// 合成 ConnectionInfo 数组：直接在内存中生成扫描结果，供 logic / 渲染基准使用（不经过 procfs）
+//
+// 分布与 proc_fixture 一致：ESTABLISHED 为主，含 TIME_WAIT、CLOSE_WAIT 等，约 3% LISTEN、10% UDP；
+// 进程名呈长尾分布（少数进程持有大部分连接），TIME_WAIT 无主；约 1% 的进程运行在 /tmp 下、0.5% 在隐藏目录、
+// 5% 路径不可读；远端约 10% 为回环、60% 为内网上游、30% 为公网，端口多为常用端口，少量为随机高位端口
+// 结果只由 seed 决定，可重复
+
+void conn_synth_fill(ConnectionInfo *conns, int count, unsigned int seed);
+
+#endif // CONN_SYNTH_H
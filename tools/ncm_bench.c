@@ -0,0 +1,120 @@
+// 扫描器基准：在合成 procfs 上反复调用 scanner_get_connections()，报告延迟分位数与稳态堆分配
+//
+//   ncm_bench [--sizes 1000,10000,100000,500000] [--iterations N] [--dir DIR] [--keep]
+//
+// 每个规模生成一份 fixture（进程数为套接字数的 1/100，至少 50 个，每个进程至少 32 个 fd），
+// 预热两次后计时 N 次；allocs 为计时各轮平均每次扫描的堆分配次数（--wrap 计数，稳态应为 0）；
+// fixture 默认在结束后删除
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "backend/scanner.h"
+#include "tools/proc_fixture.h"
+#include "tools/alloc_count.h"
+
+#define BENCH_MAX_SIZES 16
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// 最近秩分位数
+static double percentile(const double *sorted, int n, int pct) {
+    return sorted[(n - 1) * pct / 100];
+}
+
+static int bench_size(const char *base, int sockets, int iterations, int keep) {
+    char root[512];
+    snprintf(root, sizeof(root), "%s/s%d", base, sockets);
+    ProcFixtureSpec spec = { sockets / 100 > 50 ? sockets / 100 : 50, 32, sockets, (unsigned int)sockets };
+
+    double t0 = now_ms();
+    if (proc_fixture_create(root, &spec) != 0) {
+        fprintf(stderr, "Cannot create fixture under %s\n", root);
+        return -1;
+    }
+    double gen_ms = now_ms() - t0;
+    if (scanner_set_proc_root(root) != 0) return -1;
+
+    double *samples = malloc(sizeof(double) * iterations);
+    if (!samples) return -1;
+    int rows = 0;
+    AllocCounts before = { 0, 0, 0 }, after;
+    for (int i = -2; i < iterations; i++) {
+        if (i == 0) alloc_count_snapshot(&before);
+        double start = now_ms();
+        ConnectionInfo *conns = scanner_get_connections(&rows);
+        double elapsed = now_ms() - start;
+        scanner_free_connections(conns, rows);
+        if (i >= 0) samples[i] = elapsed; // 前两次为预热（第二次时扫描区域按首次的高水位扩容），不计入
+    }
+    alloc_count_snapshot(&after);
+    qsort(samples, iterations, sizeof(double), cmp_double);
+    double p50 = percentile(samples, iterations, 50);
+    printf("%9d %9d %7d %9.1f %9.2f %9.2f %9.2f %9.2f %9.0f %9.1f\n",
+           sockets, rows, spec.procs, gen_ms / 1000.0, p50, percentile(samples, iterations, 90),
+           percentile(samples, iterations, 99), samples[iterations - 1], rows > 0 ? p50 * 1e6 / rows : 0.0,
+           (double)(after.allocs - before.allocs) / iterations);
+    fflush(stdout);
+    free(samples);
+
+    if (!keep) proc_fixture_remove(root);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int sizes[BENCH_MAX_SIZES] = { 1000, 10000, 100000, 500000 };
+    int size_count = 4;
+    int iterations = 10;
+    int keep = 0;
+    const char *dir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            char buf[256];
+            snprintf(buf, sizeof(buf), "%s", argv[++i]);
+            size_count = 0;
+            for (char *tok = strtok(buf, ","); tok && size_count < BENCH_MAX_SIZES; tok = strtok(NULL, ",")) {
+                int v = atoi(tok);
+                if (v > 0) sizes[size_count++] = v;
+            }
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--keep") == 0) {
+            keep = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--sizes N[,N...]] [--iterations N] [--dir DIR] [--keep]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1 || size_count == 0) {
+        fprintf(stderr, "Nothing to run\n");
+        return 1;
+    }
+
+    char tmp[] = "/tmp/ncm_bench.XXXXXX";
+    if (!dir) {
+        dir = mkdtemp(tmp);
+        if (!dir) {
+            perror("mkdtemp");
+            return 1;
+        }
+    }
+
+    printf("# scanner_get_connections() on synthetic procfs under %s, %d iterations per size\n", dir, iterations);
+    printf("%9s %9s %7s %9s %9s %9s %9s %9s %9s %9s\n", "sockets", "rows", "procs", "gen_s", "p50_ms", "p90_ms", "p99_ms", "max_ms", "ns/row", "allocs");
+    int rc = 0;
+    for (int i = 0; i < size_count && rc == 0; i++) rc = bench_size(dir, sizes[i], iterations, keep);
+    if (!keep && dir == tmp) proc_fixture_remove(dir);
+    return rc == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// lib/logic.c 热点函数基准：在合成 ConnectionInfo 数组上计时 is_suspicious / calculate_stats /
+// sort_connections / is_internal，报告每行耗时与每轮堆分配
+//
+//   ncm_logic_bench [--rows 1000,10000,100000] [--iterations N] [--seed S] [--json] [--label L]
+//
+// 每个样本至少覆盖 10 万行（小规模时同一轮重复多次），取各样本的中位数与 P90；
+// 输入只由 seed 决定，--json 每行输出一个对象（附 --label，如提交号），便于跨提交对比
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "backend/scanner.h"
+#include "tools/conn_synth.h"
+#include "tools/alloc_count.h"
+
+#define BENCH_MAX_SIZES 16
+#define SAMPLE_MIN_ROWS 100000
+
+typedef struct {
+    const char *name;
+    SortMode sort;       // 仅 sort_* 用例；排序会改写输入，每次先从原始数组复制（复制不计时）
+    void (*run)(ConnectionInfo *conns, int count);
+} BenchCase;
+
+static volatile int sink;
+
+static void run_is_suspicious(ConnectionInfo *conns, int count) {
+    int n = 0;
+    for (int i = 0; i < count; i++) n += is_suspicious(&conns[i]);
+    sink = n;
+}
+
+static void run_calculate_stats(ConnectionInfo *conns, int count) {
+    ConnectionStats stats;
+    calculate_stats(conns, count, &stats);
+    sink = stats.total;
+}
+
+static void run_is_internal(ConnectionInfo *conns, int count) {
+    int n = 0;
+    for (int i = 0; i < count; i++) n += is_internal(conns[i].remote_addr);
+    sink = n;
+}
+
+static const BenchCase cases[] = {
+    { "is_suspicious", SORT_NONE, run_is_suspicious },
+    { "calculate_stats", SORT_NONE, run_calculate_stats },
+    { "is_internal", SORT_NONE, run_is_internal },
+    { "sort_pid", SORT_BY_PID, NULL },
+    { "sort_process", SORT_BY_PROCESS, NULL },
+    { "sort_remote", SORT_BY_REMOTE, NULL },
+    { "sort_age", SORT_BY_AGE, NULL },
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_json_str(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') putchar('\\');
+        if ((unsigned char)*s >= 0x20) putchar(*s);
+    }
+    putchar('"');
+}
+
+// 一个样本：重复 reps 次，返回每行平均耗时（纳秒）
+static double run_sample(const BenchCase *bc, ConnectionInfo *work, const ConnectionInfo *pristine, int count, int reps) {
+    double elapsed = 0;
+    for (int r = 0; r < reps; r++) {
+        if (bc->sort != SORT_NONE) memcpy(work, pristine, sizeof(ConnectionInfo) * count);
+        double start = now_ns();
+        if (bc->sort != SORT_NONE) sort_connections(work, count, bc->sort);
+        else bc->run(work, count);
+        elapsed += now_ns() - start;
+    }
+    return elapsed / ((double)reps * count);
+}
+
+static int bench_size(int rows, int iterations, unsigned int seed, int json, const char *label) {
+    ConnectionInfo *pristine = malloc(sizeof(ConnectionInfo) * rows);
+    ConnectionInfo *work = malloc(sizeof(ConnectionInfo) * rows);
+    double *samples = malloc(sizeof(double) * iterations);
+    if (!pristine || !work || !samples) {
+        free(pristine);
+        free(work);
+        free(samples);
+        fprintf(stderr, "Out of memory for %d rows\n", rows);
+        return -1;
+    }
+    conn_synth_fill(pristine, rows, seed);
+    int reps = rows >= SAMPLE_MIN_ROWS ? 1 : SAMPLE_MIN_ROWS / rows;
+
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        const BenchCase *bc = &cases[k];
+        memcpy(work, pristine, sizeof(ConnectionInfo) * rows);
+        run_sample(bc, work, pristine, rows, 2); // 预热（内部区域在第二次调用时按首次的高水位扩容）
+
+        // 分配按单轮统计（一次完整调用 / 一遍所有行），与计时分开测，避免计数影响样本
+        AllocCounts before, after;
+        if (bc->sort != SORT_NONE) memcpy(work, pristine, sizeof(ConnectionInfo) * rows);
+        alloc_count_snapshot(&before);
+        if (bc->sort != SORT_NONE) sort_connections(work, rows, bc->sort);
+        else bc->run(work, rows);
+        alloc_count_snapshot(&after);
+
+        for (int i = 0; i < iterations; i++) samples[i] = run_sample(bc, work, pristine, rows, reps);
+        qsort(samples, iterations, sizeof(double), cmp_double);
+        double p50 = samples[(iterations - 1) / 2], p90 = samples[(iterations - 1) * 90 / 100];
+        unsigned long long allocs = (unsigned long long)(after.allocs - before.allocs);
+        unsigned long long bytes = (unsigned long long)(after.bytes - before.bytes);
+
+        if (json) {
+            printf("{\"label\":");
+            print_json_str(label);
+            printf(",\"bench\":\"%s\",\"rows\":%d,\"seed\":%u,\"iterations\":%d,"
+                   "\"ns_per_row_p50\":%.2f,\"ns_per_row_p90\":%.2f,\"allocs_per_call\":%llu,\"alloc_bytes_per_call\":%llu}\n",
+                   bc->name, rows, seed, iterations, p50, p90, allocs, bytes);
+        } else {
+            printf("%-16s %9d %12.2f %12.2f %10llu %12llu\n", bc->name, rows, p50, p90, allocs, bytes);
+        }
+        fflush(stdout);
+    }
+    free(pristine);
+    free(work);
+    free(samples);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int sizes[BENCH_MAX_SIZES] = { 1000, 10000, 100000 };
+    int size_count = 3;
+    int iterations = 15;
+    unsigned int seed = 1;
+    int json = 0;
+    const char *label = "";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            char buf[256];
+            snprintf(buf, sizeof(buf), "%s", argv[++i]);
+            size_count = 0;
+            for (char *tok = strtok(buf, ","); tok && size_count < BENCH_MAX_SIZES; tok = strtok(NULL, ",")) {
+                int v = atoi(tok);
+                if (v > 0) sizes[size_count++] = v;
+            }
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--rows N[,N...]] [--iterations N] [--seed S] [--json] [--label L]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1 || size_count == 0) {
+        fprintf(stderr, "Nothing to run\n");
+        return 1;
+    }
+
+    if (!json) {
+        printf("# lib/logic.c on synthetic connections (seed %u), %d samples per case%s%s\n",
+               seed, iterations, label[0] ? ", " : "", label);
+        printf("%-16s %9s %12s %12s %10s %12s\n", "bench", "rows", "ns/row_p50", "ns/row_p90", "allocs", "alloc_bytes");
+    }
+    for (int i = 0; i < size_count; i++) {
+        if (bench_size(sizes[i], iterations, seed, json, label) != 0) return 1;
+    }
+    return 0;
+}
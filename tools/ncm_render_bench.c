@@ -0,0 +1,193 @@
+// 无头渲染基准：把 tui.c 的帧输出切到内存，在合成快照上逐视图计时帧构建
+//
+//   ncm_render_bench [--rows 1000,10000,100000,500000] [--min-ms N] [--seed S] [--json] [--label L]
+//
+// 每个规模先跑一遍扫描后的分析（统计、风险、监听/端口/泄漏跟踪），再对 11 个视图各测两种状态：
+// plain（无搜索、不排序）与 search（搜索 "nginx" 并按远端地址排序）。每个用例至少渲染 --min-ms
+// 毫秒，报告帧率、每帧耗时中位数、每帧输出字节数与计时各帧平均的堆分配次数（--wrap 计数，稳态应为 0）；
+// --json 每行一个对象，便于跨提交对比
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "backend/scanner.h"
+#include "lib/listen_watch.h"
+#include "lib/port_exhaust.h"
+#include "lib/leak_watch.h"
+#include "lib/heavy_hitters.h"
+#include "lib/rollup.h"
+#include "tools/conn_synth.h"
+#include "tools/alloc_count.h"
+#include "tui.h"
+
+#define BENCH_MAX_SIZES 16
+#define MIN_FRAMES 3
+#define MAX_SAMPLES 4096
+#define BENCH_SEARCH "nginx"
+#define BENCH_NOW_MS 1700000000000LL
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_json_str(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') putchar('\\');
+        if ((unsigned char)*s >= 0x20) putchar(*s);
+    }
+    putchar('"');
+}
+
+// 合成快照没有 tcp_info：按下标给已建立连接填上速率、RTT 与少量重传，让流量/健康度视图有数据
+static void fill_tcp(ConnectionInfo *conns, int count) {
+    for (int i = 0; i < count; i++) {
+        TcpDiag *t = &conns[i].tcp;
+        if (conns[i].status_enum != CONN_STATUS_ESTABLISHED) continue;
+        t->valid = 1;
+        t->rtt_us = 200 + (uint32_t)(i * 7919 % 80000);
+        t->rttvar_us = t->rtt_us / 4;
+        t->snd_cwnd = 10 + (uint32_t)(i % 90);
+        t->tx_rate = (double)(i * 2654435761u % 5000000u);
+        t->rx_rate = (double)(i * 40503u % 2000000u);
+        if (i % 50 == 0) {
+            t->total_retrans = (uint32_t)(i % 400);
+            t->retrans_rate = (i % 7) * 0.5;
+            t->ca_state = (uint8_t)(i % 5);
+        }
+    }
+}
+
+static int bench_size(int rows, double min_ms, unsigned int seed, int json, const char *label) {
+    ConnectionInfo *conns = malloc(sizeof(ConnectionInfo) * rows);
+    double *samples = malloc(sizeof(double) * MAX_SAMPLES);
+    if (!conns || !samples) {
+        free(conns);
+        free(samples);
+        fprintf(stderr, "Out of memory for %d rows\n", rows);
+        return -1;
+    }
+    conn_synth_fill(conns, rows, seed);
+    fill_tcp(conns, rows);
+
+    // 与主循环一次扫描后的分析步骤一致（conn_track 会改写首次观测时间，这里保留合成的连接时长）
+    ConnectionStats stats;
+    calculate_stats(conns, rows, &stats);
+    rollup_ingest(&stats, BENCH_NOW_MS / 1000);
+    for (int i = 0; i < rows; i++) is_suspicious(&conns[i]);
+    listen_watch_update(conns, rows);
+    port_exhaust_update(conns, rows, BENCH_NOW_MS);
+    stats.leaking = leak_watch_update(conns, rows, BENCH_NOW_MS);
+    heavy_hitters_update(conns, rows, BENCH_NOW_MS);
+    stats.stuck = 0;
+    const PortDest *worst;
+    stats.port_at_risk = port_exhaust_at_risk();
+    stats.port_util_max = port_exhaust_ranked(&worst, 1) == 1 ? port_exhaust_pct(worst) : 0;
+
+    TuiFrame frame = { .conns = conns, .count = rows, .stats = &stats, .now_ms = BENCH_NOW_MS,
+                       .driver_name = "bench", .tcp_info = 1 };
+    for (int view = VIEW_OVERVIEW; view <= VIEW_MAX; view++) {
+        for (int searching = 0; searching <= 1; searching++) {
+            current_view = (ViewType)view;
+            snprintf(search_filter, sizeof(search_filter), "%s", searching ? BENCH_SEARCH : "");
+            current_sort = searching ? SORT_BY_REMOTE : SORT_NONE;
+            selected_idx = 0;
+            scroll_offset = 0;
+            // 预热两帧：首帧放不下的临时分配溢出到堆，第二帧开始时帧区域按其高水位扩容，之后即为稳态
+            tui_render_frame(&frame);
+            tui_render_frame(&frame);
+
+            int frames = 0;
+            double total = 0;
+            AllocCounts before, after;
+            alloc_count_snapshot(&before);
+            while (frames < MIN_FRAMES || (total < min_ms * 1e6 && frames < MAX_SAMPLES)) {
+                double start = now_ns();
+                tui_render_frame(&frame);
+                samples[frames] = now_ns() - start;
+                total += samples[frames++];
+            }
+            alloc_count_snapshot(&after);
+            double allocs = (double)(after.allocs - before.allocs) / frames;
+            size_t bytes = 0;
+            tui_frame_data(&bytes);
+            int matched = 0;
+            tui_rows(&matched);
+            qsort(samples, frames, sizeof(double), cmp_double);
+            double p50_ms = samples[(frames - 1) / 2] / 1e6;
+            double fps = frames * 1e9 / total;
+            const char *mode = searching ? "search" : "plain";
+
+            if (json) {
+                printf("{\"label\":");
+                print_json_str(label);
+                printf(",\"rows\":%d,\"seed\":%u,\"view\":%d,\"mode\":\"%s\",\"matched\":%d,\"frames\":%d,"
+                       "\"fps\":%.1f,\"ms_per_frame_p50\":%.3f,\"bytes_per_frame\":%zu,\"allocs_per_frame\":%.2f}\n",
+                       rows, seed, view, mode, matched, frames, fps, p50_ms, bytes, allocs);
+            } else {
+                printf("%9d %4d %-7s %9d %7d %10.1f %10.3f %10zu %8.2f\n", rows, view, mode, matched, frames, fps, p50_ms, bytes, allocs);
+            }
+            fflush(stdout);
+        }
+    }
+    free(conns);
+    free(samples);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int sizes[BENCH_MAX_SIZES] = { 1000, 10000, 100000, 500000 };
+    int size_count = 4;
+    double min_ms = 200;
+    unsigned int seed = 1;
+    int json = 0;
+    const char *label = "";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            char buf[256];
+            snprintf(buf, sizeof(buf), "%s", argv[++i]);
+            size_count = 0;
+            for (char *tok = strtok(buf, ","); tok && size_count < BENCH_MAX_SIZES; tok = strtok(NULL, ",")) {
+                int v = atoi(tok);
+                if (v > 0) sizes[size_count++] = v;
+            }
+        } else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+            min_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--rows N[,N...]] [--min-ms N] [--seed S] [--json] [--label L]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (size_count == 0) {
+        fprintf(stderr, "Nothing to run\n");
+        return 1;
+    }
+
+    // 帧只写入内存；英文界面使输出字节数与终端语言设置无关
+    tui_set_sink(TUI_SINK_MEMORY);
+    current_lang = LANG_EN;
+    if (!json) {
+        printf("# tui.c frames on synthetic connections (seed %u), >= %.0f ms per case%s%s\n",
+               seed, min_ms, label[0] ? ", " : "", label);
+        printf("%9s %4s %-7s %9s %7s %10s %10s %10s %8s\n", "rows", "view", "mode", "matched", "frames", "fps", "ms_p50", "bytes", "allocs");
+    }
+    for (int i = 0; i < size_count; i++) {
+        if (bench_size(sizes[i], min_ms, seed, json, label) != 0) return 1;
+    }
+    tui_free();
+    return 0;
+}
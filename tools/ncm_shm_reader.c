@@ -0,0 +1,214 @@
+// NCM 共享内存快照示例读端
+//
+//   ncm_shm_reader [name]                 读取一次一致快照并打印
+//   ncm_shm_reader --watch [name]         每 100ms 打印一次轮次与记录数
+//   ncm_shm_reader --stress [sec] [n]     自建区域，1 个写线程 + n 个读线程并发压测一致性（未观察到重读时视为失败）
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "lib/ncm_shm.h"
+#include "lib/shm_publish.h"
+
+#define STRESS_MAX_ROWS 20000
+
+static void format_ip(uint32_t ip, uint16_t port, char *out, size_t n) {
+    const unsigned char *o = (const unsigned char *)&ip;
+    snprintf(out, n, "%u.%u.%u.%u:%u", o[0], o[1], o[2], o[3], port);
+}
+
+static int dump_once(const char *name) {
+    NcmShmReader r;
+    if (ncm_shm_reader_open(&r, name) != 0) {
+        fprintf(stderr, "Cannot open shm region %s (is ncm running with --shm-publish?)\n", name);
+        return 1;
+    }
+    // 先在一致视图内统计，再打印（打印耗时较长，避免与写端长时间竞争）
+    uint64_t s, gen;
+    uint32_t n, suspicious;
+    do {
+        s = ncm_shm_read_begin(&r);
+        gen = r.hdr->generation;
+        n = ncm_shm_count(&r);
+        suspicious = 0;
+        const NcmWireRecord *recs = ncm_shm_records(&r);
+        for (uint32_t i = 0; i < n; i++) {
+            if (recs[i].flags & NCM_WIRE_FLAG_SUSPICIOUS) suspicious++;
+        }
+    } while (!ncm_shm_read_end(&r, s));
+    printf("generation %llu: %u connections, %u suspicious\n", (unsigned long long)gen, n, suspicious);
+
+    // 逐行打印：单条记录拷出后校验，不一致则跳过该轮剩余部分
+    const NcmWireRecord *recs = ncm_shm_records(&r);
+    for (uint32_t i = 0; i < n; i++) {
+        NcmWireRecord rec = recs[i];
+        if (!ncm_shm_read_end(&r, s)) {
+            printf("(snapshot replaced while printing)\n");
+            break;
+        }
+        char local[32], remote[32];
+        format_ip(rec.local_ip, rec.local_port, local, sizeof(local));
+        format_ip(rec.remote_ip, rec.remote_port, remote, sizeof(remote));
+        printf("%-4s %-22s %-22s %-12s %-8d %s\n", rec.proto == NCM_WIRE_PROTO_UDP ? "UDP" : "TCP",
+               local, remote, conn_status_name((ConnectionStatus)rec.state), rec.pid, rec.process);
+    }
+    ncm_shm_reader_close(&r);
+    return 0;
+}
+
+static int watch(const char *name) {
+    NcmShmReader r;
+    if (ncm_shm_reader_open(&r, name) != 0) {
+        fprintf(stderr, "Cannot open shm region %s\n", name);
+        return 1;
+    }
+    uint64_t last_gen = 0;
+    for (;;) {
+        uint64_t s, gen;
+        uint32_t n;
+        do {
+            s = ncm_shm_read_begin(&r);
+            gen = r.hdr->generation;
+            n = ncm_shm_count(&r);
+        } while (!ncm_shm_read_end(&r, s));
+        if (gen != last_gen) {
+            printf("generation %llu: %u connections\n", (unsigned long long)gen, n);
+            fflush(stdout);
+            last_gen = gen;
+        }
+        usleep(100000);
+    }
+    return 0;
+}
+
+// ---- 压测：写线程持续发布，读线程校验每个一致视图的内部不变量 ----
+
+static const char *stress_name;
+static volatile int stress_stop = 0;
+
+typedef struct {
+    unsigned long long reads;
+    unsigned long long retries;
+    unsigned long long errors;
+} StressStats;
+
+// 奇数轮发布小表、偶数轮发布大表（首次发布大表时触发写端扩容与读端重映射）；
+// 两张表都预先建好，写端在两次发布之间不做任何准备，读小表的读者常能完成，读大表的读者常被下一次写入打断
+#define STRESS_SMALL_ROWS 100
+
+static uint32_t stress_rows(uint64_t gen) {
+    return (gen & 1) ? STRESS_SMALL_ROWS : STRESS_MAX_ROWS;
+}
+
+static int32_t stress_pid(uint64_t gen) {
+    return (gen & 1) ? 1 : 2;
+}
+
+static void *stress_writer(void *arg) {
+    (void)arg;
+    ConnectionInfo *tables[2];
+    for (int t = 0; t < 2; t++) {
+        tables[t] = calloc(STRESS_MAX_ROWS, sizeof(ConnectionInfo));
+        if (!tables[t]) return NULL;
+        for (int i = 0; i < STRESS_MAX_ROWS; i++) {
+            ConnectionInfo *c = &tables[t][i];
+            strcpy(c->protocol, "TCP");
+            snprintf(c->local_addr, sizeof(c->local_addr), "127.0.0.1:%d", i & 0xFFFF);
+            strcpy(c->remote_addr, "10.0.0.1:443");
+            c->status_enum = CONN_STATUS_ESTABLISHED;
+            strcpy(c->process, "stress");
+            c->pid = stress_pid((uint64_t)t + 1);
+        }
+    }
+    // 写端轮次从 1 开始，与 NcmShmHeader.generation 保持一致
+    // 发布之间不睡眠，只让出一次 CPU：否则 seq 几乎始终为奇数，读端连开始读的机会都没有
+    for (uint64_t gen = 1; !stress_stop; gen++) {
+        shm_publish_update(tables[(gen - 1) & 1], (int)stress_rows(gen));
+        sched_yield();
+    }
+    free(tables[0]);
+    free(tables[1]);
+    return NULL;
+}
+
+static void *stress_reader(void *arg) {
+    StressStats *st = arg;
+    NcmShmReader r;
+    if (ncm_shm_reader_open(&r, stress_name) != 0) {
+        st->errors++;
+        return NULL;
+    }
+    while (!stress_stop) {
+        uint64_t s = ncm_shm_read_begin(&r);
+        uint64_t gen = r.hdr->generation;
+        uint32_t n = ncm_shm_count(&r);
+        const NcmWireRecord *recs = ncm_shm_records(&r);
+        int bad = (n != stress_rows(gen));
+        for (uint32_t i = 0; i < n && !bad; i++) {
+            if (recs[i].pid != stress_pid(gen) || recs[i].local_port != (i & 0xFFFF)) bad = 1;
+            // 每校验 1024 条让出一次 CPU，拉长读窗口使其跨过写入（单核机器上否则几乎不会重叠）
+            if ((i & 1023) == 1023) sched_yield();
+        }
+        if (!ncm_shm_read_end(&r, s)) {
+            st->retries++;
+            continue;
+        }
+        if (gen == 0) continue; // 写端尚未发布第一轮，不计入一致读
+        st->reads++;
+        if (bad) st->errors++;
+    }
+    ncm_shm_reader_close(&r);
+    return NULL;
+}
+
+static int stress(int seconds, int nreaders) {
+    static char name[64];
+    snprintf(name, sizeof(name), "/ncm-stress-%d", (int)getpid());
+    stress_name = name;
+    if (shm_publish_start(name) != 0) return 1;
+    if (nreaders < 1) nreaders = 1;
+    if (nreaders > 64) nreaders = 64;
+
+    pthread_t writer, readers[64];
+    StressStats stats[64];
+    memset(stats, 0, sizeof(stats));
+    pthread_create(&writer, NULL, stress_writer, NULL);
+    for (int i = 0; i < nreaders; i++) pthread_create(&readers[i], NULL, stress_reader, &stats[i]);
+
+    sleep((unsigned)seconds);
+    stress_stop = 1;
+    pthread_join(writer, NULL);
+    StressStats total = {0, 0, 0};
+    for (int i = 0; i < nreaders; i++) {
+        pthread_join(readers[i], NULL);
+        total.reads += stats[i].reads;
+        total.retries += stats[i].retries;
+        total.errors += stats[i].errors;
+    }
+    shm_publish_stop();
+
+    printf("stress: %d readers, %llu consistent reads, %llu retries, %llu inconsistent\n",
+           nreaders, total.reads, total.retries, total.errors);
+    // 没有重读说明读写从未重叠，"0 inconsistent" 不能证明什么
+    if (total.retries == 0) fprintf(stderr, "stress: no torn reads were observed; the retry path was not exercised\n");
+    return (total.errors == 0 && total.reads > 0 && total.retries > 0) ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--stress") == 0) {
+        int seconds = argc > 2 ? atoi(argv[2]) : 3;
+        int nreaders = argc > 3 ? atoi(argv[3]) : 4;
+        return stress(seconds > 0 ? seconds : 3, nreaders);
+    }
+    if (argc > 1 && strcmp(argv[1], "--watch") == 0) {
+        return watch(argc > 2 ? argv[2] : "/ncm");
+    }
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        printf("Usage: %s [name] | --watch [name] | --stress [seconds] [readers]\n", argv[0]);
+        return 0;
+    }
+    return dump_once(argc > 1 ? argv[1] : "/ncm");
+}
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "tools/proc_fixture.h"
+
+#define FIXTURE_PID_BASE 1000
+#define FIXTURE_INODE_BASE 100000
+
+typedef struct {
+    uint8_t udp;
+    uint8_t st;                // 内核状态码（TCP），UDP 为 07
+    uint8_t lip[4], rip[4];
+    uint16_t lport, rport;
+    uint32_t txq, rxq;
+    uint64_t inode;            // TIME_WAIT 为 0（已无 fd）
+    int owner;                 // 进程下标，-1 表示无主
+} FixtureSocket;
+
+static const char *proc_names[] = { "nginx", "postgres", "java", "redis-server", "node", "python3", "envoy", "sshd", "haproxy", "containerd" };
+static const char *proc_exes[] = { "/usr/sbin/nginx", "/usr/lib/postgresql/15/bin/postgres", "/usr/lib/jvm/java-17/bin/java",
+                                   "/usr/bin/redis-server", "/usr/bin/node", "/usr/bin/python3.11", "/usr/local/bin/envoy",
+                                   "/usr/sbin/sshd", "/usr/sbin/haproxy", "/usr/bin/containerd" };
+static const uint16_t listen_ports[] = { 80, 443, 5432, 6379, 8080, 9090, 22, 3306 };
+
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static int mkdirs(const char *path) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return mkdir(buf, 0755) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+static int write_file(const char *path, const char *content) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    fputs(content, f);
+    return fclose(f);
+}
+
+// 按常见比例抽取 TCP 状态
+static uint8_t pick_tcp_state(void) {
+    uint32_t r = rng() % 100;
+    if (r < 60) return 0x01;       // ESTABLISHED
+    if (r < 80) return 0x06;       // TIME_WAIT
+    if (r < 88) return 0x08;       // CLOSE_WAIT
+    if (r < 92) return 0x02;       // SYN_SENT
+    if (r < 95) return 0x05;       // FIN_WAIT2
+    if (r < 97) return 0x04;       // FIN_WAIT1
+    return 0x09;                   // LAST_ACK
+}
+
+static void gen_socket(FixtureSocket *s, int index, int procs) {
+    memset(s, 0, sizeof(*s));
+    s->udp = rng() % 10 == 0;
+    s->lip[0] = 10; s->lip[1] = 0; s->lip[2] = (uint8_t)(rng() % 4); s->lip[3] = (uint8_t)(1 + rng() % 4);
+    // 少量监听套接字，其余为客户端或服务端连接
+    if (!s->udp && index % 64 == 0) {
+        s->st = 0x0A;
+        s->lport = listen_ports[rng() % (sizeof(listen_ports) / sizeof(listen_ports[0]))];
+        s->rxq = rng() % 8;
+    } else if (s->udp) {
+        s->st = 0x07;
+        s->lport = (uint16_t)(32768 + rng() % 28000);
+        if (rng() % 4 == 0) {
+            s->rip[0] = 10; s->rip[1] = 1; s->rip[2] = (uint8_t)(rng() % 8); s->rip[3] = (uint8_t)(1 + rng() % 254);
+            s->rport = 53;
+        }
+    } else {
+        s->st = pick_tcp_state();
+        // 远端集中在少数上游子网，另有一部分公网地址
+        if (rng() % 5 == 0) {
+            s->rip[0] = (uint8_t)(1 + rng() % 223); s->rip[1] = (uint8_t)(rng() % 256);
+            s->rip[2] = (uint8_t)(rng() % 256); s->rip[3] = (uint8_t)(1 + rng() % 254);
+        } else {
+            s->rip[0] = 10; s->rip[1] = 2; s->rip[2] = (uint8_t)(rng() % 16); s->rip[3] = (uint8_t)(1 + rng() % 32);
+        }
+        if (rng() % 2) {
+            s->lport = (uint16_t)(32768 + rng() % 28000);
+            s->rport = listen_ports[rng() % (sizeof(listen_ports) / sizeof(listen_ports[0]))];
+        } else {
+            s->lport = listen_ports[rng() % (sizeof(listen_ports) / sizeof(listen_ports[0]))];
+            s->rport = (uint16_t)(1024 + rng() % 64000);
+        }
+        if (s->st == 0x01 && rng() % 20 == 0) s->txq = rng() % 65536;
+    }
+    if (s->st == 0x06 && !s->udp) {
+        s->inode = 0;
+        s->owner = -1;
+    } else {
+        s->inode = FIXTURE_INODE_BASE + (uint64_t)index;
+        // 两个均匀数相乘后偏向小下标：少数进程持有大部分套接字
+        uint64_t a = rng() % (uint32_t)procs, b = rng() % (uint32_t)procs;
+        s->owner = (int)(a * b / (uint64_t)procs);
+    }
+}
+
+static void write_socket_row(FILE *f, int sl, const FixtureSocket *s) {
+    // 地址按内核的打印方式：网络序的 4 字节按小端整数输出
+    fprintf(f, "%4d: %02X%02X%02X%02X:%04X %02X%02X%02X%02X:%04X %02X %08X:%08X 00:00000000 00000000  1000        0 %llu 1 0000000000000000 20 4 30 10 -1\n",
+            sl, s->lip[3], s->lip[2], s->lip[1], s->lip[0], s->lport,
+            s->rip[3], s->rip[2], s->rip[1], s->rip[0], s->rport,
+            s->st, s->txq, s->rxq, (unsigned long long)s->inode);
+}
+
+static int write_tables(const char *root, const FixtureSocket *socks, int n) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/net", root);
+    if (mkdirs(path) != 0) return -1;
+    for (int udp = 0; udp <= 1; udp++) {
+        snprintf(path, sizeof(path), "%s/net/%s", root, udp ? "udp" : "tcp");
+        FILE *f = fopen(path, "w");
+        if (!f) return -1;
+        fputs(udp ? "   sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode ref pointer drops\n"
+                  : "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n", f);
+        int sl = 0;
+        for (int i = 0; i < n; i++) {
+            if (socks[i].udp == udp) write_socket_row(f, sl++, &socks[i]);
+        }
+        if (fclose(f) != 0) return -1;
+    }
+    snprintf(path, sizeof(path), "%s/sys/net/ipv4", root);
+    if (mkdirs(path) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/sys/net/ipv4/ip_local_port_range", root);
+    return write_file(path, "32768\t60999\n");
+}
+
+static int write_process(const char *root, int idx, int32_t pid, const uint64_t *inodes, int n_inodes, int fds_min) {
+    char dir[1024], path[1100], buf[512];
+    int kind = idx % (int)(sizeof(proc_names) / sizeof(proc_names[0]));
+    snprintf(dir, sizeof(dir), "%s/%d", root, pid);
+    snprintf(path, sizeof(path), "%s/fd", dir);
+    if (mkdirs(path) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/ns", dir);
+    if (mkdirs(path) != 0) return -1;
+
+    snprintf(path, sizeof(path), "%s/comm", dir);
+    snprintf(buf, sizeof(buf), "%s\n", proc_names[kind]);
+    if (write_file(path, buf) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/stat", dir);
+    snprintf(buf, sizeof(buf), "%d (%s) S 1 %d %d 0 -1 4194560 100 0 0 0 10 5 0 0 20 0 4 0 %d 104857600 2048\n",
+             pid, proc_names[kind], pid, pid, 1000 + idx);
+    if (write_file(path, buf) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/limits", dir);
+    if (write_file(path, "Limit                     Soft Limit           Hard Limit           Units     \n"
+                         "Max open files            65536                65536                files     \n") != 0) return -1;
+
+    // 约 1% 的进程运行在 /tmp 下，触发路径审计
+    snprintf(path, sizeof(path), "%s/exe", dir);
+    if (idx % 100 == 99) snprintf(buf, sizeof(buf), "/tmp/.cache/%s", proc_names[kind]);
+    else snprintf(buf, sizeof(buf), "%s", proc_exes[kind]);
+    if (symlink(buf, path) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/net", dir);
+    if (symlink("../net", path) != 0) return -1;
+    char ns_src[1024];
+    snprintf(ns_src, sizeof(ns_src), "%s/.ns_net", root);
+    snprintf(path, sizeof(path), "%s/ns/net", dir);
+    if (link(ns_src, path) != 0) return -1;
+
+    // fd 0-2 为标准流，其后是套接字，不足 fds_min 时以管道、日志文件与 epoll 补足
+    int total = n_inodes + 3 > fds_min ? n_inodes + 3 : fds_min;
+    for (int fd = 0; fd < total; fd++) {
+        snprintf(path, sizeof(path), "%s/fd/%d", dir, fd);
+        if (fd < 3) snprintf(buf, sizeof(buf), "/dev/null");
+        else if (fd - 3 < n_inodes) snprintf(buf, sizeof(buf), "socket:[%llu]", (unsigned long long)inodes[fd - 3]);
+        else if (fd % 3 == 0) snprintf(buf, sizeof(buf), "pipe:[%d]", 50000 + fd);
+        else if (fd % 3 == 1) snprintf(buf, sizeof(buf), "/var/log/%s.log", proc_names[kind]);
+        else snprintf(buf, sizeof(buf), "anon_inode:[eventpoll]");
+        if (symlink(buf, path) != 0) return -1;
+    }
+    return 0;
+}
+
+int proc_fixture_create(const char *root, const ProcFixtureSpec *spec) {
+    if (spec->procs <= 0 || spec->sockets < 0 || mkdirs(root) != 0) return -1;
+    rng_state = spec->seed ? spec->seed : 0x9E3779B9u;
+
+    FixtureSocket *socks = malloc(sizeof(FixtureSocket) * (spec->sockets > 0 ? spec->sockets : 1));
+    int *per_proc = calloc((size_t)spec->procs + 1, sizeof(int));
+    uint64_t *by_proc = malloc(sizeof(uint64_t) * (spec->sockets > 0 ? spec->sockets : 1));
+    if (!socks || !per_proc || !by_proc) {
+        free(socks);
+        free(per_proc);
+        free(by_proc);
+        return -1;
+    }
+
+    for (int i = 0; i < spec->sockets; i++) {
+        gen_socket(&socks[i], i, spec->procs);
+        if (socks[i].owner >= 0) per_proc[socks[i].owner + 1]++;
+    }
+    // 按进程分桶：per_proc[p]..per_proc[p+1] 为进程 p 的套接字 inode
+    for (int p = 0; p < spec->procs; p++) per_proc[p + 1] += per_proc[p];
+    int *fill = calloc((size_t)spec->procs, sizeof(int));
+    int rc = fill ? 0 : -1;
+    for (int i = 0; rc == 0 && i < spec->sockets; i++) {
+        int o = socks[i].owner;
+        if (o >= 0) by_proc[per_proc[o] + fill[o]++] = socks[i].inode;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/.ns_net", root);
+    if (rc == 0) rc = write_file(path, "");
+    if (rc == 0) rc = write_tables(root, socks, spec->sockets);
+    for (int p = 0; rc == 0 && p < spec->procs; p++) {
+        rc = write_process(root, p, FIXTURE_PID_BASE + p, by_proc + per_proc[p], per_proc[p + 1] - per_proc[p], spec->fds_per_proc);
+    }
+
+    free(fill);
+    free(socks);
+    free(per_proc);
+    free(by_proc);
+    return rc;
+}
+
+int proc_fixture_remove(const char *root) {
+    // 先按文件 / 符号链接删除（不跟随链接），是目录时再递归
+    if (unlink(root) == 0) return 0;
+    if (errno != EISDIR && errno != EPERM) return -1;
+    DIR *dir = opendir(root);
+    if (!dir) return -1;
+    struct dirent *e;
+    int rc = 0;
+    while ((e = readdir(dir))) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", root, e->d_name);
+        if (proc_fixture_remove(path) != 0) rc = -1;
+    }
+    closedir(dir);
+    return rmdir(root) == 0 ? rc : -1;
+}
@@ -0,0 +1,29 @@
+#ifndef PROC_FIXTURE_H
+#define PROC_FIXTURE_H
+
+// 合成 procfs：在普通目录下生成 scanner_lin.c 读取的全部文件，供基准测试与回归复现使用
+//
+//   <root>/net/tcp, <root>/net/udp               套接字表（格式与内核一致）
+//   <root>/sys/net/ipv4/ip_local_port_range
+//   <root>/<pid>/comm, stat, limits
+//   <root>/<pid>/exe -> 可执行文件路径（悬空符号链接）
+//   <root>/<pid>/fd/<n> -> socket:[inode] / pipe:[..] / /dev/null 等
+//   <root>/<pid>/net -> ../net，<root>/<pid>/ns/net 为同一文件的硬链接（-p 模式按命名空间去重）
+//
+// 套接字按状态的常见比例生成（ESTABLISHED 为主，含 LISTEN、TIME_WAIT、CLOSE_WAIT 等，约 10% 为 UDP），
+// 除 TIME_WAIT 外都分配给进程，进程间的分配呈长尾分布；结果只由 seed 决定，可重复
+
+typedef struct {
+    int procs;             // 进程数
+    int fds_per_proc;      // 每个进程至少持有的 fd 数（套接字不足时以其他类型补足）
+    int sockets;           // 套接字总数（TCP + UDP）
+    unsigned int seed;
+} ProcFixtureSpec;
+
+// 在 root（应为空目录或不存在）下生成，成功返回 0
+int proc_fixture_create(const char *root, const ProcFixtureSpec *spec);
+
+// 递归删除 root 及其内容
+int proc_fixture_remove(const char *root);
+
+#endif // PROC_FIXTURE_H
@@ -0,0 +1,1057 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tui.h"
+#include "lib/arena.h"
+#include "lib/strbuf.h"
+#include "lib/conn_filter.h"
+#include "lib/conn_track.h"
+#include "lib/listen_watch.h"
+#include "lib/pin_watch.h"
+#include "lib/port_exhaust.h"
+#include "lib/leak_watch.h"
+#include "lib/fanout.h"
+#include "lib/heavy_hitters.h"
+#include "lib/rollup.h"
+#include "lib/phase_timer.h"
+#include "lib/scan_sched.h"
+
+// 全局界面状态
+LangType current_lang = LANG_CN;
+ViewType current_view = VIEW_OVERVIEW;
+int scroll_offset = 0;
+char search_filter[64] = "";
+int is_searching = 0;
+SortMode current_sort = SORT_NONE;
+int selected_idx = 0; // 当前选中的列表行索引
+int show_detail = 0;  // 是否显示详情浮窗
+int kill_confirm = 0; // 是否处于终止确认状态
+int health_by_rtt = 0;    // 健康度视图排序：0 按重传速率，1 按 RTT（R 键切换）
+int hitters_by_prefix = 0; // 热点远端视图：0 按主机，1 按 /24（IPv6 /64）网段（在该视图再按 H 切换）
+int trend_series = 0;     // 趋势图的序列（lib/rollup.h 的序号，X 键切换）
+int trend_res = ROLLUP_1S; // 趋势图的粒度（RollupRes，Z 键切换）
+int show_profiler = 0;    // 分阶段耗时面板（T 键切换）
+
+// 帧缓冲：整帧拼好后一次写出，避免逐段 printf 在慢终端上出现撕裂，也便于无头渲染计量
+static StrBuf out;
+static TuiSink sink = TUI_SINK_STDOUT;
+static size_t last_frame_bytes;
+
+// 帧区域：过滤后的行与各面板的聚合表每帧从这里分配，下一帧开始时复位
+static Arena frame_arena;
+static ConnectionInfo **filtered_conns;
+static int match_count;
+
+static void emit(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    strbuf_vprintf(&out, fmt, ap);
+    va_end(ap);
+}
+
+// 结束一帧：标准输出端写出后清空缓冲；内存输出端保留到下一帧开始
+static void tui_flush(void) {
+    last_frame_bytes = out.len;
+    if (sink != TUI_SINK_STDOUT) return;
+    if (out.len) fwrite(out.data, 1, out.len, stdout);
+    fflush(stdout);
+    out.len = 0;
+}
+
+void tui_set_sink(TuiSink s) {
+    sink = s;
+    out.len = 0;
+}
+
+const char *tui_frame_data(size_t *len) {
+    if (len) *len = last_frame_bytes;
+    return sink == TUI_SINK_STDOUT ? NULL : out.data;
+}
+
+ConnectionInfo **tui_rows(int *count) {
+    *count = match_count;
+    return filtered_conns;
+}
+
+// 国际化文本结构
+static struct {
+    const char *title;
+    const char *ctrl_hint;
+    const char *scroll_hint;
+    const char *search_hint;
+    const char *sort_hint;
+    const char *driver_label;
+    const char *interval_label;
+    const char *search_label;
+    const char *sort_label;
+    const char *board_total;
+    const char *board_est;
+    const char *board_listen;
+    const char *board_suspicious;
+    const char *top_proc_label;
+    const char *view_ov;
+    const char *view_all;
+    const char *view_conn;
+    const char *view_list;
+    const char *view_susp;
+    const char *view_talkers;
+    const char *view_health;
+    const char *view_pressure;
+    const char *view_ports;
+    const char *view_leaks;
+    const char *view_hitters;
+    const char *col_proto;
+    const char *col_local;
+    const char *col_remote;
+    const char *col_status;
+    const char *col_proc;
+    const char *col_age;
+    const char *no_data;
+} ui_text;
+
+static void update_ui_text() {
+    if (current_lang == LANG_CN) {
+        ui_text.title = "NCM 网络连接监测器 v2.0";
+        ui_text.ctrl_hint = "按 Q 退出 | L 切换 English | 0-9 切换视图 | G 折叠 | T 性能 | [ 回放";
+        ui_text.scroll_hint = "J/K/↑/↓ 滚动";
+        ui_text.search_hint = "/ 搜索";
+        ui_text.sort_hint = "S 排序";
+        ui_text.driver_label = "驱动级别";
+        ui_text.interval_label = "扫描间隔";
+        ui_text.search_label = "搜索关键词";
+        ui_text.sort_label = "排序模式";
+        ui_text.board_total = "总连接数";
+        ui_text.board_est = "正在通信";
+        ui_text.board_listen = "监听中";
+        ui_text.board_suspicious = "可疑连接";
+        ui_text.top_proc_label = "最活跃进程";
+        ui_text.view_ov = "1.总览";
+        ui_text.view_all = "2.全量";
+        ui_text.view_conn = "3.通信中";
+        ui_text.view_list = "4.监听中";
+        ui_text.view_susp = "5.可疑连接";
+        ui_text.view_talkers = "6.流量排行";
+        ui_text.view_health = "7.健康度";
+        ui_text.view_pressure = "8.监听压力";
+        ui_text.view_ports = "9.端口耗尽";
+        ui_text.view_leaks = "0.套接字泄漏";
+        ui_text.view_hitters = "H.热点远端";
+        ui_text.col_proto = "协议";
+        ui_text.col_local = "本地地址";
+        ui_text.col_remote = "远端地址";
+        ui_text.col_status = "状态";
+        ui_text.col_proc = "进程";
+        ui_text.col_age = "时长";
+        ui_text.no_data = "暂无匹配数据";
+    } else {
+        ui_text.title = "NCM - Network Monitor v2.0";
+        ui_text.ctrl_hint = "Q:Exit | L:Language | 0-9:Switch View | G:Collapse | T:Profiler | [:Replay";
+        ui_text.scroll_hint = "J/K/↑/↓:Scroll";
+        ui_text.search_hint = "/:Search";
+        ui_text.sort_hint = "S:Sort";
+        ui_text.driver_label = "DRIVER";
+        ui_text.interval_label = "Scan";
+        ui_text.search_label = "Filter";
+        ui_text.sort_label = "Sort";
+        ui_text.board_total = "TOTAL CONNS";
+        ui_text.board_est = "ESTABLISHED";
+        ui_text.board_listen = "LISTENING";
+        ui_text.board_suspicious = "SUSPICIOUS";
+        ui_text.top_proc_label = "Top Process";
+        ui_text.view_ov = "1.Overview";
+        ui_text.view_all = "2.All";
+        ui_text.view_conn = "3.Comm";
+        ui_text.view_list = "4.Listen";
+        ui_text.view_susp = "5.Suspicious";
+        ui_text.view_talkers = "6.Talkers";
+        ui_text.view_health = "7.Health";
+        ui_text.view_pressure = "8.Pressure";
+        ui_text.view_ports = "9.Ports";
+        ui_text.view_leaks = "0.Leaks";
+        ui_text.view_hitters = "H.Top Remotes";
+        ui_text.col_proto = "PROTO";
+        ui_text.col_local = "LOCAL ADDR";
+        ui_text.col_remote = "REMOTE ADDR";
+        ui_text.col_status = "STATUS";
+        ui_text.col_proc = "PROCESS";
+        ui_text.col_age = "AGE";
+        ui_text.no_data = "No matching data";
+    }
+}
+
+// 状态翻译
+static const char* trans_status(const char* st) {
+    if (current_lang == LANG_EN) return st;
+    if (strcmp(st, "ESTABLISHED") == 0) return "已连接";
+    if (strcmp(st, "LISTEN") == 0) return "监听中";
+    if (strcmp(st, "TIME_WAIT") == 0) return "等待关闭";
+    if (strcmp(st, "CLOSE_WAIT") == 0) return "等待关闭";
+    if (strcmp(st, "NONE") == 0) return "无状态";
+    return st;
+}
+
+// 清屏
+static void clear_screen() {
+#ifdef _WIN32
+    if (sink == TUI_SINK_STDOUT) system("cls");
+    else emit("\033[2J\033[H");
+#else
+    // 恢复全屏清除模式以消除视图切换时的样式错乱和残影
+    emit("\033[2J\033[H");
+#endif
+}
+
+// 宽度感知打印 (处理 UTF-8 中文双倍宽度)
+static void print_padded(const char* s, int target_width) {
+    int visual_width = 0;
+    const unsigned char *p = (const unsigned char *)s;
+    while (*p) {
+        if (*p < 128) { visual_width += 1; p += 1; }
+        else if (*p < 224) { visual_width += 1; p += 2; }
+        else if (*p < 240) { visual_width += 2; p += 3; } // 中文通常是 3 字节，2 列宽
+        else { visual_width += 2; p += 4; }
+    }
+    strbuf_puts(&out, s);
+    for (int i = 0; i < target_width - visual_width; i++) strbuf_append(&out, " ", 1);
+}
+
+static void draw_stats_board(const ConnectionStats *stats) {
+    // 盒式布局：┌ + 16个─ + ┐ (总宽18)
+    emit(CL_BLD "┌────────────────┐ ┌────────────────┐ ┌────────────────┐ ┌────────────────┐\n");
+    
+    // 内容行：│ + 16位对齐内容 + │
+    emit("│" CL_CYN); print_padded(ui_text.board_total, 16); emit(CLR_RST "│ │" CL_GRN); print_padded(ui_text.board_est, 16); emit(CLR_RST "│ │" CL_YLW); print_padded(ui_text.board_listen, 16); emit(CLR_RST "│ │" CL_RED); print_padded(ui_text.board_suspicious, 16); emit(CLR_RST "│\n");
+    
+    // 数据行：同样 16 位宽度
+    emit("│" CL_BLD "%-16d" CLR_RST "│ │" CL_BLD "%-16d" CLR_RST "│ │" CL_BLD "%-16d" CLR_RST "│ │" CL_BLD "%-16d" CLR_RST "│\n", 
+           stats->total, stats->established, stats->listening, stats->suspicious);
+           
+    emit("└────────────────┘ └────────────────┘ └────────────────┘ └────────────────┘\n");
+    emit(CL_BLD " %s: " CLR_RST CL_MAG "%s" CLR_RST " (%d %s) | " CL_CYN "%s" CLR_RST " | " CL_YLW "%s" CLR_RST " | " CL_GRN "%s" CLR_RST "\n", 
+           ui_text.top_proc_label, stats->top_process, stats->top_process_count, 
+           (current_lang == LANG_CN ? "连接" : "conns"), ui_text.scroll_hint, ui_text.search_hint, ui_text.sort_hint);
+    if (stats->stuck > 0) {
+        emit(BG_RED " %s: %d " CLR_RST "\n", (current_lang == LANG_CN ? "状态滞留告警（SYN_SENT/CLOSE_WAIT/FIN_WAIT2 超时）" : "STUCK (SYN_SENT/CLOSE_WAIT/FIN_WAIT2 past threshold)"),
+               stats->stuck);
+    }
+    if (stats->leaking > 0) {
+        const ProcLeak *top;
+        if (leak_watch_ranked(&top, 1) == 1 && top->flags) {
+            char eta[16] = "-";
+            int eta_sec = leak_watch_eta_sec(top);
+            if (eta_sec >= 0) conn_track_format_age(eta_sec, eta, sizeof(eta));
+            emit(BG_RED " %s: %d (%s[%d] %s %d, CLOSE_WAIT %d, %s %s) " CLR_RST "\n",
+                   (current_lang == LANG_CN ? "套接字持续增长的进程" : "SOCKET LEAK suspected"), stats->leaking,
+                   top->process, top->pid, top->fds >= 0 ? "fd" : (current_lang == LANG_CN ? "套接字" : "sockets"),
+                   top->fds >= 0 ? top->fds : top->sockets, top->close_wait,
+                   (current_lang == LANG_CN ? "预计到达上限" : "limit in"), eta);
+        }
+    }
+    if (stats->port_at_risk > 0) {
+        const PortDest *top;
+        if (port_exhaust_ranked(&top, 1) == 1) {
+            emit(BG_RED " %s: %d (%s %d%%: %s -> %s) " CLR_RST "\n",
+                   (current_lang == LANG_CN ? "临时端口即将耗尽的目标" : "EPHEMERAL PORTS near exhaustion"), stats->port_at_risk,
+                   (current_lang == LANG_CN ? "最高" : "max"), stats->port_util_max, top->local_ip_str, top->remote_addr);
+        }
+    }
+    
+    // 显示搜索和排序状态
+    if (is_searching || strlen(search_filter) > 0 || current_sort != SORT_NONE) {
+        emit(CL_CYN " %s: " CLR_RST CL_BLD "[ %s ]" CLR_RST " %s", 
+               ui_text.search_label, search_filter, (is_searching ? "_" : ""));
+        
+        if (current_sort != SORT_NONE) {
+            const char *sort_name = "NONE";
+            if (current_lang == LANG_CN) {
+                if (current_sort == SORT_BY_PID) sort_name = "PID";
+                else if (current_sort == SORT_BY_PROCESS) sort_name = "进程名";
+                else if (current_sort == SORT_BY_REMOTE) sort_name = "远端地址";
+                else if (current_sort == SORT_BY_AGE) sort_name = "连接时长";
+            } else {
+                if (current_sort == SORT_BY_PID) sort_name = "PID";
+                else if (current_sort == SORT_BY_PROCESS) sort_name = "Process";
+                else if (current_sort == SORT_BY_REMOTE) sort_name = "Remote";
+                else if (current_sort == SORT_BY_AGE) sort_name = "Age";
+            }
+            emit(" | " CL_YLW "%s: " CLR_RST CL_BLD "%s" CLR_RST, ui_text.sort_label, sort_name);
+        }
+        emit("\n");
+    }
+    emit("────────────────────────────────────────────────────────────────────────────────────\n");
+}
+
+// 趋势图显示的桶数（1 秒粒度即最近 1 分钟，1 分钟粒度即最近 1 小时）
+#define TREND_HISTORY_SIZE 60
+
+// 绘制趋势字符图：所选序列在所选粒度下各桶的平均值，缺口留空；行尾为可见窗口内的最小 / 最大 / 平均
+static void draw_sparkline(long long now_ms) {
+    const char* bars[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    const char *name = rollup_series_name(trend_series);
+    if (!name) {
+        trend_series = 0;
+        name = rollup_series_name(0);
+    }
+    RollupBucket b[TREND_HISTORY_SIZE];
+    int n = rollup_read(trend_series, (RollupRes)trend_res, (int64_t)(now_ms / 1000), b, TREND_HISTORY_SIZE);
+    int32_t max = 1, lo = 0, hi = 0;
+    int64_t sum = 0;
+    uint32_t samples = 0;
+    for (int i = 0; i < n; i++) {
+        if (b[i].n == 0) continue;
+        if (b[i].max > max) max = b[i].max;
+        if (samples == 0 || b[i].min < lo) lo = b[i].min;
+        if (samples == 0 || b[i].max > hi) hi = b[i].max;
+        sum += b[i].sum;
+        samples += b[i].n;
+    }
+
+    char label[48];
+    snprintf(label, sizeof(label), "%.*s·%s", 24, name, rollup_res_name((RollupRes)trend_res));
+    emit(CL_CYN " TREND %s: " CLR_RST, label);
+    for (int i = 0; i < n; i++) {
+        if (b[i].n == 0) { emit(" "); continue; }
+        double avg = (double)b[i].sum / b[i].n;
+        int bar_idx = (int)(avg * 7 / max);
+        emit("%s", bars[bar_idx < 0 ? 0 : bar_idx > 7 ? 7 : bar_idx]);
+    }
+    if (samples > 0) emit(CL_CYN "  min %d  max %d  avg %.1f" CLR_RST, lo, hi, (double)sum / samples);
+    emit("  [Z: 1s/1m/1h | X: %s]\n", current_lang == LANG_CN ? "序列" : "series");
+}
+
+// 回放提示：所显示扫描的时刻、距今多久与距最新一轮的轮数
+static void draw_replay_banner(const TuiFrame *f) {
+    time_t at = (time_t)(f->now_ms / 1000);
+    char when[16], ago[16];
+    struct tm *t = localtime(&at);
+    if (!t || strftime(when, sizeof(when), "%H:%M:%S", t) == 0) snprintf(when, sizeof(when), "-");
+    conn_track_format_age((f->live_ms - f->now_ms) / 1000, ago, sizeof(ago));
+    if (current_lang == LANG_CN)
+        emit(BG_RED " 回放 %s（%s 前，第 -%d 轮）" CLR_RST CL_YLW "  [ ] 前后一轮 | { } 前后 %d 轮 | Esc 返回实时" CLR_RST "\n",
+             when, ago, f->replay_back, REPLAY_JUMP_SCANS);
+    else
+        emit(BG_RED " REPLAY %s (%s ago, scan -%d) " CLR_RST CL_YLW "  [ ]:Step | { }:%d scans | Esc:Live" CLR_RST "\n",
+             when, ago, f->replay_back, REPLAY_JUMP_SCANS);
+}
+
+// 显示详情浮窗
+void show_detail_overlay(ConnectionInfo *conn) {
+    emit("\033[2J\033[H"); // 全屏清除，进入详情
+    emit("\n\n" CL_BLD "  ┌────────────────────────────────────────────────────────────┐\n");
+    
+    // 标题行
+    emit("  │ " CL_MAG); print_padded("PROCESS DETAILS", 58); emit(CLR_RST " │\n");
+    emit("  ├────────────────────────────────────────────────────────────┤\n");
+    
+    char buf[80];     // 最长一行为 AGE：两段时长加状态名
+    // PID
+    snprintf(buf, sizeof(buf), "%d", conn->pid);
+    emit("  │ " CL_CYN); print_padded("PID:       ", 11); emit(CLR_RST); print_padded(buf, 47); emit(" │\n");
+    
+    // COMM
+    emit("  │ " CL_CYN); print_padded("COMM:      ", 11); emit(CLR_RST); print_padded(conn->process, 47); emit(" │\n");
+    
+    // PROTO/ST
+    emit("  │ " CL_CYN); print_padded("PROTO/ST:  ", 11); emit(CLR_RST); print_padded(conn->status, 47); emit(" │\n");
+    
+    // LOCAL
+    emit("  │ " CL_CYN); print_padded("LOCAL:     ", 11); emit(CLR_RST); print_padded(conn->local_addr, 47); emit(" │\n");
+    
+    // REMOTE
+    emit("  │ " CL_CYN); print_padded("REMOTE:    ", 11); emit(CLR_RST); print_padded(conn->remote_addr, 47); emit(" │\n");
+
+    // GROUP（折叠行：成员数与本地端口范围，上方字段取自首个成员）
+    if (conn->group_count > 1) {
+        snprintf(buf, sizeof(buf), "%d conns, local ports %u-%u", conn->group_count, conn->group_port_min, conn->group_port_max);
+        emit("  │ " CL_CYN); print_padded("GROUP:     ", 11); emit(CLR_RST); print_padded(buf, 47); emit(" │\n");
+    }
+    
+    // EXE PATH (处理换行)
+    emit("  │ " CL_CYN); print_padded("EXE PATH:  ", 11); emit(CLR_RST); 
+    if (strlen(conn->exe_path) <= 47) {
+        print_padded(conn->exe_path, 47); emit(" │\n");
+    } else {
+        char path_part[48];
+        strncpy(path_part, conn->exe_path, 47); path_part[47] = '\0';
+        print_padded(path_part, 47); emit(" │\n");
+        emit("  │            "); print_padded(conn->exe_path + 47, 47); emit(" │\n");
+    }
+    
+    // AGE（首次观测至今 / 处于当前状态的时长）
+    if (conn->first_seen > 0) {
+        char age[16], in_state[16];
+        time_t now = time(NULL);
+        conn_track_format_age((int64_t)now - conn->first_seen, age, sizeof(age));
+        conn_track_format_age((int64_t)now - conn->state_since, in_state, sizeof(in_state));
+        snprintf(buf, sizeof(buf), "%s (in %s: %s)", age, conn->status, in_state);
+        emit("  │ " CL_CYN); print_padded("AGE:       ", 11); emit(CLR_RST); print_padded(buf, 47); emit(" │\n");
+    }
+
+    // TCP 健康度（--tcp-info）
+    if (conn->tcp.valid) {
+        snprintf(buf, sizeof(buf), "%.2fms ±%.2fms  cwnd %u", conn->tcp.rtt_us / 1000.0, conn->tcp.rttvar_us / 1000.0, conn->tcp.snd_cwnd);
+        emit("  │ " CL_CYN); print_padded("RTT:       ", 11); emit(CLR_RST); print_padded(buf, 47); emit(" │\n");
+        snprintf(buf, sizeof(buf), "%u total, %.1f/s  ca_state %s", conn->tcp.total_retrans, conn->tcp.retrans_rate, tcp_ca_state_name(conn->tcp.ca_state));
+        emit("  │ " CL_CYN); print_padded("RETRANS:   ", 11); emit(CLR_RST); print_padded(buf, 47); emit(" │\n");
+    }
+
+    // FAN-OUT（该进程最近 1~2 分钟内出站连向的不同远端数，HyperLogLog 估计）
+    const FanOutProc *fo = fanout_lookup(conn->pid);
+    if (fo) {
+        snprintf(buf, sizeof(buf), "~%d IPs, ~%d ports%s", fo->ip_est, fo->port_est, fo->flags ? "  (jump)" : "");
+        emit("  │ " CL_CYN); print_padded("FAN-OUT:   ", 11); emit(CLR_RST); print_padded(buf, 47); emit(" │\n");
+    }
+
+    // RISK
+    emit("  │ " CL_RED); print_padded("RISK:      ", 11); emit(CLR_RST); 
+    print_padded(strlen(conn->risk_reason) ? conn->risk_reason : "Safe", 47); emit(" │\n");
+    
+    emit("  ├────────────────────────────────────────────────────────────┤\n");
+    // 底部提示
+    emit("  │ " CL_YLW); print_padded("Press ANY KEY to return", 58); emit(CLR_RST " │\n");
+    emit("  └────────────────────────────────────────────────────────────┘\n");
+    tui_flush();
+}
+
+static void draw_sidebar() {
+    emit(CL_BLD " [%s] " CLR_RST, (current_lang == LANG_CN ? "菜单选择" : "VIEW"));
+    emit(current_view == VIEW_OVERVIEW ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_ov);
+    emit(current_view == VIEW_ALL ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_all);
+    emit(current_view == VIEW_ESTABLISHED ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_conn);
+    emit(current_view == VIEW_LISTEN ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_list);
+    emit(current_view == VIEW_SUSPICIOUS ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_susp);
+    emit(current_view == VIEW_TALKERS ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_talkers);
+    emit(current_view == VIEW_HEALTH ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_health);
+    emit(current_view == VIEW_PRESSURE ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_pressure);
+    emit(current_view == VIEW_PORTS ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_ports);
+    emit(current_view == VIEW_LEAKS ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_leaks);
+    emit(current_view == VIEW_HITTERS ? BG_RED " %s " CLR_RST : " %s ", ui_text.view_hitters);
+    emit("\n");
+}
+
+// 速率格式化：B/s、KB/s、MB/s、GB/s
+static void format_rate(double bps, char *buf, size_t size) {
+    if (bps >= 1e9) snprintf(buf, size, "%.1fGB/s", bps / 1e9);
+    else if (bps >= 1e6) snprintf(buf, size, "%.1fMB/s", bps / 1e6);
+    else if (bps >= 1e3) snprintf(buf, size, "%.1fKB/s", bps / 1e3);
+    else snprintf(buf, size, "%.0fB/s", bps);
+}
+
+// 按总吞吐降序
+static int cmp_conn_rate_desc(const void *a, const void *b) {
+    const ConnectionInfo *ca = *(ConnectionInfo * const *)a, *cb = *(ConnectionInfo * const *)b;
+    double ra = ca->tcp.tx_rate + ca->tcp.rx_rate, rb = cb->tcp.tx_rate + cb->tcp.rx_rate;
+    return (ra < rb) - (ra > rb);
+}
+
+// 按收发队列积压降序
+static int cmp_conn_queue_desc(const void *a, const void *b) {
+    const ConnectionInfo *ca = *(ConnectionInfo * const *)a, *cb = *(ConnectionInfo * const *)b;
+    uint64_t qa = (uint64_t)ca->rx_queue + ca->tx_queue, qb = (uint64_t)cb->rx_queue + cb->tx_queue;
+    return (qa < qb) - (qa > qb);
+}
+
+// 环形历史的字符趋势图（按时间先后从左到右）
+static void draw_ring_sparkline(const uint32_t *vals, int len, int pos, int cap, uint32_t max, int width) {
+    const char* bars[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    if (max == 0) max = 1;
+    int shown = len < width ? len : width;
+    for (int i = 0; i < width - shown; i++) emit(" ");
+    for (int i = shown; i > 0; i--) {
+        uint32_t v = vals[(pos - i + cap) % cap];
+        emit("%s", bars[(uint64_t)(v > max ? max : v) * 7 / max]);
+    }
+}
+
+// 监听压力视图顶部：按 accept 队列占用率与收发队列积压排列监听端口，附带最近若干轮趋势
+#define PRESSURE_ROWS 8
+#define PRESSURE_TREND_WIDTH 15
+static void draw_listen_pressure(void) {
+    const ListenerPressure *top[PRESSURE_ROWS];
+    int n = listen_watch_ranked(top, PRESSURE_ROWS);
+    emit(CL_BLD);
+    print_padded(current_lang == LANG_CN ? "监听地址" : "LISTEN", 22);
+    print_padded(ui_text.col_proc, 14);
+    print_padded("ACCEPT-Q", 12);
+    print_padded("FILL", 6);
+    print_padded("RECV-Q", 10);
+    print_padded("SEND-Q", 10);
+    print_padded("FILL TREND", PRESSURE_TREND_WIDTH + 1);
+    print_padded("QUEUE TREND", PRESSURE_TREND_WIDTH);
+    emit(CLR_RST "\n");
+    for (int i = 0; i < n; i++) {
+        const ListenerPressure *l = top[i];
+        char aq[24], fill[8], rq[16], sq[16];
+        double ratio = listen_fill_ratio(l);
+        if (l->backlog) snprintf(aq, sizeof(aq), "%u/%u", l->accept_queue, l->backlog);
+        else snprintf(aq, sizeof(aq), "%u/?", l->accept_queue);
+        snprintf(fill, sizeof(fill), "%.0f%%", ratio * 100.0);
+        snprintf(rq, sizeof(rq), "%llu", (unsigned long long)l->child_rx_queue);
+        snprintf(sq, sizeof(sq), "%llu", (unsigned long long)l->child_tx_queue);
+
+        print_padded(l->local_addr, 22);
+        emit(CL_MAG);
+        char proc[14];
+        snprintf(proc, sizeof(proc), "%.*s", (int)sizeof(proc) - 1, l->process);
+        print_padded(proc, 14);
+        emit(ratio >= 0.8 ? BG_RED : ratio >= 0.5 ? CL_YLW : CLR_RST);
+        print_padded(aq, 12);
+        print_padded(fill, 6);
+        emit(CLR_RST);
+        print_padded(rq, 10);
+        print_padded(sq, 10);
+
+        uint32_t fills[LISTEN_HISTORY_LEN], qmax = 0;
+        for (int k = 0; k < LISTEN_HISTORY_LEN; k++) {
+            fills[k] = l->fill_history[k];
+            if (l->queue_history[k] > qmax) qmax = l->queue_history[k];
+        }
+        emit(CL_YLW);
+        draw_ring_sparkline(fills, l->history_len, l->history_pos, LISTEN_HISTORY_LEN, 100, PRESSURE_TREND_WIDTH);
+        emit(" " CL_CYN);
+        draw_ring_sparkline(l->queue_history, l->history_len, l->history_pos, LISTEN_HISTORY_LEN, qmax, PRESSURE_TREND_WIDTH);
+        emit(CLR_RST "\n");
+    }
+    if (n == 0) emit("   (%s)\n", ui_text.no_data);
+    emit("\n");
+}
+
+// 端口耗尽视图顶部：按占用的临时端口数排列 (本地 IP, 远端 IP:端口) 目标，附带趋势与耗尽预估
+#define PORTS_ROWS 8
+static void draw_port_exhaustion(void) {
+    const PortDest *top[PORTS_ROWS];
+    int n = port_exhaust_ranked(top, PORTS_ROWS);
+    uint16_t lo, hi;
+    port_exhaust_range(&lo, &hi);
+    unsigned int size = (unsigned int)hi - lo + 1;
+    emit(CL_CYN " ip_local_port_range %u-%u (%u)" CLR_RST "\n", lo, hi, size);
+    emit(CL_BLD);
+    print_padded(current_lang == LANG_CN ? "本地 IP" : "LOCAL IP", 16);
+    print_padded(current_lang == LANG_CN ? "目标" : "DESTINATION", 22);
+    print_padded(ui_text.col_proc, 14);
+    print_padded("IN USE", 14);
+    print_padded("TIME_WAIT", 10);
+    print_padded("UTIL", 6);
+    print_padded("ETA", 8);
+    print_padded("TREND", PRESSURE_TREND_WIDTH);
+    emit(CLR_RST "\n");
+    for (int i = 0; i < n; i++) {
+        const PortDest *d = top[i];
+        char used[24], tw[16], util[8], eta[16];
+        int pct = port_exhaust_pct(d);
+        int eta_sec = port_exhaust_eta_sec(d);
+        snprintf(used, sizeof(used), "%u/%u", d->in_use, size);
+        snprintf(tw, sizeof(tw), "%u", d->time_wait);
+        snprintf(util, sizeof(util), "%d%%", pct);
+        if (eta_sec < 0) snprintf(eta, sizeof(eta), "-");
+        else conn_track_format_age(eta_sec, eta, sizeof(eta));
+
+        print_padded(d->local_ip_str, 16);
+        print_padded(d->remote_addr, 22);
+        emit(CL_MAG);
+        char proc[14];
+        snprintf(proc, sizeof(proc), "%.*s", (int)sizeof(proc) - 1, d->process);
+        print_padded(proc, 14);
+        emit(pct >= PORT_EXHAUST_WARN_PCT ? BG_RED : pct >= PORT_EXHAUST_WARN_PCT / 2 ? CL_YLW : CLR_RST);
+        print_padded(used, 14);
+        emit(CLR_RST);
+        print_padded(tw, 10);
+        emit(pct >= PORT_EXHAUST_WARN_PCT ? BG_RED : pct >= PORT_EXHAUST_WARN_PCT / 2 ? CL_YLW : CLR_RST);
+        print_padded(util, 6);
+        emit(CLR_RST);
+        print_padded(eta, 8);
+        uint32_t hmax = 0;
+        for (int k = 0; k < PORT_HISTORY_LEN; k++) if (d->history[k] > hmax) hmax = d->history[k];
+        emit(CL_CYN);
+        draw_ring_sparkline(d->history, d->history_len, d->history_pos, PORT_HISTORY_LEN, hmax, PRESSURE_TREND_WIDTH);
+        emit(CLR_RST "\n");
+    }
+    if (n == 0) emit("   (%s)\n", ui_text.no_data);
+    emit("\n");
+}
+
+// 泄漏视图顶部：按是否持续增长与增长速率排列进程，附带 fd 上限、预计到达上限的时间与趋势
+#define LEAK_ROWS 8
+static void draw_leak_watch(void) {
+    const ProcLeak *top[LEAK_ROWS];
+    int n = leak_watch_ranked(top, LEAK_ROWS);
+    emit(CL_BLD);
+    print_padded("PID", 8);
+    print_padded(ui_text.col_proc, 14);
+    print_padded("SOCKETS", 9);
+    print_padded("CLOSE_WAIT", 11);
+    print_padded("FDS/LIMIT", 16);
+    print_padded("FD/MIN", 8);
+    print_padded("CW/MIN", 8);
+    print_padded("ETA", 7);
+    print_padded("TREND", PRESSURE_TREND_WIDTH);
+    emit(CLR_RST "\n");
+    for (int i = 0; i < n; i++) {
+        const ProcLeak *p = top[i];
+        char pid[16], sockets[16], cw[16], fds[32], fd_rate[16], cw_rate[16], eta[16] = "-";
+        snprintf(pid, sizeof(pid), "%d", p->pid);
+        snprintf(sockets, sizeof(sockets), "%d", p->sockets);
+        snprintf(cw, sizeof(cw), "%d", p->close_wait);
+        if (p->fds < 0) snprintf(fds, sizeof(fds), "-");
+        else if (p->fd_limit > 0) snprintf(fds, sizeof(fds), "%d/%d", p->fds, p->fd_limit);
+        else snprintf(fds, sizeof(fds), "%d/∞", p->fds);
+        snprintf(fd_rate, sizeof(fd_rate), "%+.1f", p->fd_trend.rate * 60.0);
+        snprintf(cw_rate, sizeof(cw_rate), "%+.1f", p->cw_trend.rate * 60.0);
+        int eta_sec = leak_watch_eta_sec(p);
+        if (eta_sec >= 0) conn_track_format_age(eta_sec, eta, sizeof(eta));
+
+        print_padded(pid, 8);
+        emit(CL_MAG);
+        char proc[14];
+        snprintf(proc, sizeof(proc), "%.*s", (int)sizeof(proc) - 1, p->process);
+        print_padded(proc, 14);
+        emit(CLR_RST);
+        print_padded(sockets, 9);
+        emit((p->flags & LEAK_FLAG_CLOSE_WAIT) ? BG_RED : CLR_RST);
+        print_padded(cw, 11);
+        emit((p->flags & LEAK_FLAG_FDS) ? BG_RED : CLR_RST);
+        print_padded(fds, 16);
+        emit(CLR_RST);
+        print_padded(fd_rate, 8);
+        print_padded(cw_rate, 8);
+        emit(p->flags ? CL_RED : CLR_RST);
+        print_padded(eta, 7);
+        uint32_t hmax = 0;
+        for (int k = 0; k < LEAK_HISTORY_LEN; k++) if (p->history[k] > hmax) hmax = p->history[k];
+        emit(CL_CYN);
+        draw_ring_sparkline(p->history, p->history_len, p->history_pos, LEAK_HISTORY_LEN, hmax, PRESSURE_TREND_WIDTH);
+        emit(CLR_RST "\n");
+    }
+    if (n == 0) emit("   (%s)\n", ui_text.no_data);
+    emit("\n");
+}
+
+#define HITTERS_ROWS 10
+#define HITTERS_BAR_WIDTH 20
+
+static HhMode hitters_mode(void) {
+    return hitters_by_prefix ? HH_BY_PREFIX : HH_BY_HOST;
+}
+
+// 热点远端：近一小时（指数衰减）平均并发连接数最高的主机或网段，估计值带 Space-Saving 误差上界
+static void draw_heavy_hitters(void) {
+    const HeavyHitter *top[HITTERS_ROWS];
+    int n = heavy_hitters_ranked(hitters_mode(), top, HITTERS_ROWS);
+    char window[16];
+    conn_track_format_age((int64_t)heavy_hitters_window_sec(), window, sizeof(window));
+    emit(CL_CYN " %s %s, %s %s" CLR_RST "  [H: %s]\n",
+         current_lang == LANG_CN ? "近 1 小时平均（衰减），已覆盖" : "1h decayed average, covering", window,
+         current_lang == LANG_CN ? "按" : "by", hitters_by_prefix ? "/24 | /64" : (current_lang == LANG_CN ? "主机" : "host"),
+         hitters_by_prefix ? (current_lang == LANG_CN ? "按主机" : "by host") : (current_lang == LANG_CN ? "按网段" : "by prefix"));
+    emit(CL_BLD);
+    print_padded("#", 4);
+    print_padded(current_lang == LANG_CN ? "远端" : "REMOTE", 26);
+    print_padded("AVG CONNS", 11);
+    print_padded("±ERR", 9);
+    print_padded("SHARE", 8);
+    emit(CLR_RST "\n");
+    double amax = n > 0 ? heavy_hitters_avg(top[0]) : 0;
+    for (int i = 0; i < n; i++) {
+        const HeavyHitter *h = top[i];
+        char rank[8], avg[16], err[16], share[16];
+        double a = heavy_hitters_avg(h);
+        snprintf(rank, sizeof(rank), "%d", i + 1);
+        snprintf(avg, sizeof(avg), "%.1f", a);
+        snprintf(err, sizeof(err), "%.1f", heavy_hitters_err(h));
+        snprintf(share, sizeof(share), "%.1f%%", heavy_hitters_share(h) * 100.0);
+
+        print_padded(rank, 4);
+        emit(CL_MAG);
+        print_padded(h->label, 26);
+        emit(CLR_RST);
+        print_padded(avg, 11);
+        // 误差上界超过估计值一半时排名不可靠，置灰提示
+        emit(h->err * 2 > h->count ? "\033[2m" : CLR_RST);
+        print_padded(err, 9);
+        emit(CLR_RST);
+        print_padded(share, 8);
+        int bar = amax > 0 ? (int)(a / amax * HITTERS_BAR_WIDTH + 0.5) : 0;
+        emit(CL_CYN);
+        for (int k = 0; k < bar; k++) emit("█");
+        emit(CLR_RST "\n");
+    }
+    if (n == 0) emit("   (%s)\n", ui_text.no_data);
+    emit("\n");
+}
+
+// 把端口耗尽视图的行按所属目标的排名稳定分桶，每行只查一次目标
+static void order_by_port_rank(ConnectionInfo **rows, int n) {
+    int *ranks = arena_alloc(&frame_arena, sizeof(int) * (n > 0 ? n : 1));
+    ConnectionInfo **out = arena_alloc(&frame_arena, sizeof(ConnectionInfo *) * (n > 0 ? n : 1));
+    if (!ranks || !out) return;
+    int starts[PORTS_ROWS + 1] = {0};
+    for (int i = 0; i < n; i++) {
+        ranks[i] = port_exhaust_rank(rows[i], PORTS_ROWS);
+        starts[ranks[i] + 1]++;
+    }
+    for (int r = 1; r <= PORTS_ROWS; r++) starts[r] += starts[r - 1];
+    for (int i = 0; i < n; i++) out[starts[ranks[i]]++] = rows[i];
+    memcpy(rows, out, sizeof(ConnectionInfo *) * n);
+}
+
+// 分阶段耗时面板：各阶段最近一次 / 分位数 / 最大值（毫秒），以及最近一轮扫描的行数、系统调用数与 RSS
+static void draw_profiler_panel(void) {
+    emit(CL_BLD);
+    print_padded(current_lang == LANG_CN ? "阶段耗时 (ms)" : "PHASE (ms)", 16);
+    print_padded(current_lang == LANG_CN ? "最近" : "LAST", 10);
+    print_padded("P50", 10);
+    print_padded("P90", 10);
+    print_padded("P99", 10);
+    print_padded("MAX", 10);
+    emit("%s" CLR_RST "\n", current_lang == LANG_CN ? "次数" : "COUNT");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseHist *h = phase_hist((PhaseId)i);
+        char last[16], p50[16], p90[16], p99[16], max[16];
+        snprintf(last, sizeof(last), "%.2f", h->last_ns / 1e6);
+        snprintf(p50, sizeof(p50), "%.2f", phase_percentile_ns((PhaseId)i, 50) / 1e6);
+        snprintf(p90, sizeof(p90), "%.2f", phase_percentile_ns((PhaseId)i, 90) / 1e6);
+        snprintf(p99, sizeof(p99), "%.2f", phase_percentile_ns((PhaseId)i, 99) / 1e6);
+        snprintf(max, sizeof(max), "%.2f", h->max_ns / 1e6);
+        emit(i == PHASE_SCAN || i == PHASE_FRAME ? CL_CYN : CL_MAG);
+        print_padded(phase_name((PhaseId)i), 16);
+        emit(CLR_RST);
+        print_padded(last, 10);
+        print_padded(p50, 10);
+        print_padded(p90, 10);
+        print_padded(p99, 10);
+        print_padded(max, 10);
+        emit("%llu\n", (unsigned long long)h->count);
+    }
+    const PhaseProcess *pp = phase_process();
+    emit(CL_BLD " %s: " CLR_RST "%d | " CL_BLD "%s: " CLR_RST "%llu | " CL_BLD "RSS: " CLR_RST "%.1f MiB\n\n",
+           current_lang == LANG_CN ? "行数" : "Rows", pp->rows,
+           current_lang == LANG_CN ? "系统调用/轮" : "Syscalls/scan", (unsigned long long)pp->syscalls,
+           pp->rss_bytes / 1048576.0);
+}
+
+// 固定连接面板：独立于全量扫描每 100ms 精确查询，展示状态、队列、RTT 与最近的状态迁移
+static void draw_pinned_panel(long long now_ms) {
+    int n = pin_watch_count();
+    if (n == 0) return;
+    emit(CL_BLD);
+    print_padded(current_lang == LANG_CN ? "固定连接 (100ms)" : "PINNED (100ms)", 46);
+    print_padded(ui_text.col_status, 13);
+    print_padded(current_lang == LANG_CN ? "持续" : "FOR", 7);
+    print_padded("RECV-Q", 9);
+    print_padded("SEND-Q", 9);
+    print_padded("RTT", 9);
+    emit("%s" CLR_RST "\n", current_lang == LANG_CN ? "最近迁移" : "RECENT TRANSITIONS");
+    for (int i = 0; i < n; i++) {
+        const PinnedConn *p = pin_watch_get(i);
+        char tuple[80], since[16], rq[16], sq[16], rtt[16];
+        snprintf(tuple, sizeof(tuple), "%s -> %s", p->local_addr, p->remote_addr);
+        conn_track_format_age(p->state_since_ms > 0 ? (now_ms - p->state_since_ms) / 1000 : -1, since, sizeof(since));
+        snprintf(rq, sizeof(rq), "%u", p->rx_queue);
+        snprintf(sq, sizeof(sq), "%u", p->tx_queue);
+        if (p->tcp.valid) snprintf(rtt, sizeof(rtt), "%.1fms", p->tcp.rtt_us / 1000.0);
+        else snprintf(rtt, sizeof(rtt), "-");
+
+        print_padded(tuple, 46);
+        emit(p->state == PIN_STATE_GONE ? CL_RED : p->state == CONN_STATUS_ESTABLISHED ? CL_GRN : CL_YLW);
+        print_padded(pin_state_name(p->state), 13);
+        emit(CLR_RST);
+        print_padded(since, 7);
+        print_padded(rq, 9);
+        print_padded(sq, 9);
+        print_padded(rtt, 9);
+        // 最近的迁移在前，最多两条
+        for (int k = 0; k < p->event_count && k < 2; k++) {
+            const PinEvent *e = &p->events[(p->event_pos - 1 - k + PIN_EVENT_HISTORY) % PIN_EVENT_HISTORY];
+            char ago[16];
+            conn_track_format_age((now_ms - e->at_ms) / 1000, ago, sizeof(ago));
+            emit("%s%s>%s (%s)", k ? ", " : "", pin_state_name(e->from), pin_state_name(e->to), ago);
+        }
+        emit("\n");
+    }
+    emit("\n");
+}
+
+// 健康度排序：按重传速率（其次 RTT）或按 RTT 降序
+static int cmp_conn_health_desc(const void *a, const void *b) {
+    const TcpDiag *ta = &(*(ConnectionInfo * const *)a)->tcp, *tb = &(*(ConnectionInfo * const *)b)->tcp;
+    if (!health_by_rtt && ta->retrans_rate != tb->retrans_rate) return (ta->retrans_rate < tb->retrans_rate) - (ta->retrans_rate > tb->retrans_rate);
+    return (ta->rtt_us < tb->rtt_us) - (ta->rtt_us > tb->rtt_us);
+}
+
+// 健康度视图顶部的远端 /24 前缀排行：单个异常上游子网在上千连接中也能一眼看出
+#define HEALTH_PREFIX_ROWS 5
+static void draw_prefix_health(ConnectionInfo *conns, int count, int tcp_info) {
+    if (!tcp_info) {
+        emit(CL_YLW " %s\n\n" CLR_RST, (current_lang == LANG_CN ? "TCP 健康度采集未开启：请以 --tcp-info 启动" : "TCP health collection is off: restart with --tcp-info"));
+        return;
+    }
+    PrefixHealth top[HEALTH_PREFIX_ROWS];
+    int n = top_prefix_health(conns, count, top, HEALTH_PREFIX_ROWS, &frame_arena);
+    emit(CL_BLD);
+    print_padded(current_lang == LANG_CN ? "远端前缀" : "REMOTE PREFIX", 20);
+    print_padded(current_lang == LANG_CN ? "连接数" : "CONNS", 8);
+    print_padded("AVG RTT", 12);
+    print_padded("MAX RTT", 12);
+    print_padded("RETRANS/s", 12);
+    print_padded("RETRANS", 10);
+    emit(CLR_RST "  [R: %s]\n", health_by_rtt ? "RTT" : "RETRANS");
+    for (int i = 0; i < n; i++) {
+        char prefix[24], conns_buf[16], avg[16], max[16], rate[16], total[16];
+        snprintf(prefix, sizeof(prefix), "%u.%u.%u.0/24", top[i].prefix >> 24, (top[i].prefix >> 16) & 0xFF, (top[i].prefix >> 8) & 0xFF);
+        snprintf(conns_buf, sizeof(conns_buf), "%d", top[i].conns);
+        snprintf(avg, sizeof(avg), "%.1fms", top[i].avg_rtt_us / 1000.0);
+        snprintf(max, sizeof(max), "%.1fms", top[i].max_rtt_us / 1000.0);
+        snprintf(rate, sizeof(rate), "%.1f", top[i].retrans_rate);
+        snprintf(total, sizeof(total), "%u", top[i].total_retrans);
+        emit(top[i].retrans_rate > 0 ? CL_RED : CL_MAG);
+        print_padded(prefix, 20);
+        emit(CLR_RST);
+        print_padded(conns_buf, 8);
+        print_padded(avg, 12);
+        print_padded(max, 12);
+        print_padded(rate, 12);
+        print_padded(total, 10);
+        emit("\n");
+    }
+    if (n == 0) emit("   (%s)\n", ui_text.no_data);
+    emit("\n");
+}
+
+// Top Talkers 视图顶部的进程吞吐排行
+#define TALKER_PROCESS_ROWS 5
+static void draw_process_talkers(ConnectionInfo *conns, int count, int tcp_info) {
+    if (!tcp_info) {
+        emit(CL_YLW " %s\n\n" CLR_RST, (current_lang == LANG_CN ? "吞吐统计未开启：请以 --tcp-info 启动" : "Throughput collection is off: restart with --tcp-info"));
+        return;
+    }
+    ProcessRate top[TALKER_PROCESS_ROWS];
+    int n = top_process_rates(conns, count, top, TALKER_PROCESS_ROWS, &frame_arena);
+    emit(CL_BLD);
+    print_padded(ui_text.col_proc, 18);
+    print_padded("PID", 8);
+    print_padded(current_lang == LANG_CN ? "连接数" : "CONNS", 8);
+    print_padded("TX", 12);
+    print_padded("RX", 12);
+    emit(CLR_RST "\n");
+    for (int i = 0; i < n; i++) {
+        char pid[16], conns_buf[16], tx[24], rx[24];
+        snprintf(pid, sizeof(pid), "%d", top[i].pid);
+        snprintf(conns_buf, sizeof(conns_buf), "%d", top[i].conns);
+        format_rate(top[i].tx_rate, tx, sizeof(tx));
+        format_rate(top[i].rx_rate, rx, sizeof(rx));
+        emit(CL_MAG);
+        print_padded(top[i].process, 18);
+        emit(CLR_RST);
+        print_padded(pid, 8);
+        print_padded(conns_buf, 8);
+        print_padded(tx, 12);
+        print_padded(rx, 12);
+        emit("\n");
+    }
+    if (n == 0) emit("   (%s)\n", ui_text.no_data);
+    emit("\n");
+}
+
+void tui_render_frame(const TuiFrame *f) {
+    ConnectionInfo *conns = f->conns;
+    int count = f->count;
+    time_t now_sec = (time_t)(f->now_ms / 1000);
+    out.len = 0;
+    arena_reset(&frame_arena);
+    filtered_conns = NULL;
+    match_count = 0;
+    update_ui_text();
+
+    // 帧计时：排序与视图过滤计入 filter，其余绘制计入 render
+    uint64_t frame_start = phase_now_ns();
+    if (current_sort != SORT_NONE) sort_connections(conns, count, current_sort);
+    uint64_t filter_ns = phase_now_ns() - frame_start;
+
+    clear_screen();
+    emit(CL_BLD CL_GRN " %s " CLR_RST "  [%s]  " CL_YLW "[%s: %s]" CLR_RST, 
+           ui_text.title, ui_text.ctrl_hint, ui_text.driver_label, f->driver_name);
+    // 当前扫描间隔；设置了 --cpu-budget 时附上估计的扫描 CPU 占用 / 预算
+    char interval[16];
+    scan_sched_format_interval(scan_sched_interval_ms(), interval, sizeof(interval));
+    if (scan_sched_adaptive())
+        emit("  " CL_CYN "[%s: %s  CPU %.1f%%/%.1f%%]" CLR_RST "\n", ui_text.interval_label, interval,
+             scan_sched_cpu_share() * 100, scan_sched_budget() * 100);
+    else
+        emit("  " CL_CYN "[%s: %s]" CLR_RST "\n", ui_text.interval_label, interval);
+    if (f->live_ms > 0) draw_replay_banner(f);
+    draw_sparkline(f->now_ms);
+    emit("\n");
+
+    draw_stats_board(f->stats);
+    draw_sidebar();
+    emit("\n");
+    if (show_profiler) draw_profiler_panel();
+    if (current_view == VIEW_TALKERS) draw_process_talkers(conns, count, f->tcp_info);
+    if (current_view == VIEW_HEALTH) draw_prefix_health(conns, count, f->tcp_info);
+    if (current_view == VIEW_PRESSURE) draw_listen_pressure();
+    // 端口耗尽、泄漏与热点远端的视图按实时监测状态挑选行，与回放的历史轮次对不上：回放中停用
+    int live_only = f->live_ms > 0 && (current_view == VIEW_PORTS || current_view == VIEW_LEAKS || current_view == VIEW_HITTERS);
+    if (live_only) {
+        emit(CL_YLW "%s" CLR_RST "\n\n", current_lang == LANG_CN ? " 该视图基于实时监测状态，回放中不可用（Esc 返回实时）"
+                                                           : " This view is built from live monitor state and is unavailable in replay (Esc: live)");
+    } else {
+        if (current_view == VIEW_PORTS) draw_port_exhaustion();
+        if (current_view == VIEW_LEAKS) draw_leak_watch();
+        if (current_view == VIEW_HITTERS) draw_heavy_hitters();
+    }
+    draw_pinned_panel(f->live_ms > 0 ? f->live_ms : f->now_ms); // 固定连接始终是实时数据
+
+    emit(CL_BLD);
+    print_padded(ui_text.col_proto, 6);
+    print_padded(ui_text.col_local, 22);
+    print_padded(ui_text.col_remote, 22);
+    print_padded(ui_text.col_status, 12);
+    print_padded(ui_text.col_age, 6);
+    print_padded(ui_text.col_proc, 12);
+    print_padded(current_view == VIEW_TALKERS ? "TX / RX" : current_view == VIEW_HEALTH ? "RTT / RETRANS" :
+                 current_view == VIEW_PRESSURE ? "RECV-Q / SEND-Q" : current_view == VIEW_PORTS ? "DEST UTIL" :
+                 current_view == VIEW_LEAKS ? "LEAK" : current_view == VIEW_HITTERS ? "TOP" : "RISK", 10);
+    emit(CLR_RST "\n");
+    emit(" ───────────────────────────────────────────────────────────────────────────────────\n");
+
+    uint64_t filter_start = phase_now_ns();
+    filtered_conns = arena_alloc(&frame_arena, sizeof(ConnectionInfo *) * (count > 0 ? count : 1));
+    if (!filtered_conns) count = 0;
+
+    for (int i = 0; i < count && !live_only; i++) {
+        int vm = 0;
+        switch (current_view) {
+            case VIEW_OVERVIEW: if (conns[i].status_enum == CONN_STATUS_ESTABLISHED && is_external_connection(&conns[i])) vm = 1; break;
+            case VIEW_ALL: vm = 1; break;
+            case VIEW_ESTABLISHED: if (conns[i].status_enum == CONN_STATUS_ESTABLISHED) vm = 1; break;
+            case VIEW_LISTEN: if (conns[i].status_enum == CONN_STATUS_LISTEN) vm = 1; break;
+            case VIEW_SUSPICIOUS: if (strlen(conns[i].risk_reason) > 0) vm = 1; break;
+            case VIEW_TALKERS: if (conns[i].tcp.tx_rate + conns[i].tcp.rx_rate > 0) vm = 1; break;
+            case VIEW_HEALTH: if (conns[i].tcp.valid && conns[i].status_enum == CONN_STATUS_ESTABLISHED) vm = 1; break;
+            case VIEW_PRESSURE: if (conns[i].status_enum != CONN_STATUS_LISTEN && conns[i].rx_queue + conns[i].tx_queue > 0) vm = 1; break;
+            case VIEW_PORTS: if (port_exhaust_rank(&conns[i], PORTS_ROWS) >= 0) vm = 1; break;
+            case VIEW_LEAKS: if (conns[i].status_enum == CONN_STATUS_CLOSE_WAIT || leak_watch_is_leaking(conns[i].pid)) vm = 1; break;
+            case VIEW_HITTERS: if (heavy_hitters_rank(hitters_mode(), &conns[i], HITTERS_ROWS) >= 0) vm = 1; break;
+        }
+
+        if (vm && strlen(search_filter) > 0) {
+            if (strstr(conns[i].process, search_filter) == NULL && 
+                strstr(conns[i].remote_addr, search_filter) == NULL) {
+                vm = 0;
+            }
+        }
+        if (vm) filtered_conns[match_count++] = &conns[i];
+    }
+
+    if (current_view == VIEW_TALKERS) qsort(filtered_conns, match_count, sizeof(ConnectionInfo *), cmp_conn_rate_desc);
+    if (current_view == VIEW_HEALTH) qsort(filtered_conns, match_count, sizeof(ConnectionInfo *), cmp_conn_health_desc);
+    if (current_view == VIEW_PRESSURE) qsort(filtered_conns, match_count, sizeof(ConnectionInfo *), cmp_conn_queue_desc);
+    if (current_view == VIEW_PORTS) order_by_port_rank(filtered_conns, match_count);
+    filter_ns += phase_now_ns() - filter_start;
+
+    // 滚动与选择自适应
+    int display_limit = 15; 
+    if (selected_idx >= match_count && match_count > 0) selected_idx = match_count - 1;
+    if (selected_idx < 0) selected_idx = 0;
+
+    if (selected_idx < scroll_offset) scroll_offset = selected_idx;
+    if (selected_idx >= scroll_offset + display_limit) scroll_offset = selected_idx - display_limit + 1;
+
+    int rendered = 0;
+    for (int i = scroll_offset; i < match_count && rendered < display_limit; i++) {
+        const char *st_clr = CLR_RST;
+        if (filtered_conns[i]->status_enum == CONN_STATUS_ESTABLISHED) st_clr = CL_GRN;
+        if (strlen(filtered_conns[i]->risk_reason) > 0) st_clr = BG_RED;
+
+        if (i == selected_idx) emit("\033[7m"); 
+
+        // 已固定的连接在协议后加 * 标记；折叠行以 ×N 代替协议，本地地址显示端口范围
+        char proto[24], local[64];   // 协议名加固定标记 "*"
+        const char *local_shown = filtered_conns[i]->local_addr;
+        if (filtered_conns[i]->group_count > 1) {
+            snprintf(proto, sizeof(proto), "×%d", filtered_conns[i]->group_count);
+            const char *colon = strrchr(filtered_conns[i]->local_addr, ':');
+            int ip_len = colon ? (int)(colon - filtered_conns[i]->local_addr) : 0;
+            snprintf(local, sizeof(local), "%.*s:%u-%u", ip_len, filtered_conns[i]->local_addr,
+                     filtered_conns[i]->group_port_min, filtered_conns[i]->group_port_max);
+            if (strlen(local) > 21) snprintf(local, sizeof(local), "%.*s:*", ip_len, filtered_conns[i]->local_addr);
+            local_shown = local;
+        } else {
+            snprintf(proto, sizeof(proto), "%s%s", filtered_conns[i]->protocol,
+                     pin_watch_is_pinned(filtered_conns[i]->local_addr, filtered_conns[i]->remote_addr) ? "*" : "");
+        }
+        print_padded(proto, 6);
+        print_padded(local_shown, 22);
+        print_padded(filtered_conns[i]->remote_addr, 22);
+        emit("%s", st_clr);
+        print_padded(trans_status(filtered_conns[i]->status), 12);
+        emit(CLR_RST);
+        if (i == selected_idx) emit("\033[7m");
+        char age[16];
+        conn_track_format_age(filtered_conns[i]->first_seen > 0 ? (int64_t)now_sec - filtered_conns[i]->first_seen : -1, age, sizeof(age));
+        print_padded(age, 6);
+        if (i == selected_idx) emit("\033[7m");
+        print_padded(filtered_conns[i]->process, 12);
+        emit(CL_YLW);
+        if (current_view == VIEW_TALKERS) {
+            char tx[24], rx[24];
+            format_rate(filtered_conns[i]->tcp.tx_rate, tx, sizeof(tx));
+            format_rate(filtered_conns[i]->tcp.rx_rate, rx, sizeof(rx));
+            emit("%s / %s", tx, rx);
+        } else if (current_view == VIEW_HEALTH) {
+            const TcpDiag *t = &filtered_conns[i]->tcp;
+            if (t->retrans_rate > 0 || t->ca_state >= 3) emit(CL_RED);
+            emit("%.1fms / %.1f/s (%u)", t->rtt_us / 1000.0, t->retrans_rate, t->total_retrans);
+        } else if (current_view == VIEW_PRESSURE) {
+            emit("%u / %u", filtered_conns[i]->rx_queue, filtered_conns[i]->tx_queue);
+        } else if (current_view == VIEW_PORTS) {
+            const PortDest *top[PORTS_ROWS];
+            int n = port_exhaust_ranked(top, PORTS_ROWS);
+            int r = port_exhaust_rank(filtered_conns[i], PORTS_ROWS);
+            if (r >= 0 && r < n) emit("%d%% (#%d)", port_exhaust_pct(top[r]), r + 1);
+        } else if (current_view == VIEW_LEAKS) {
+            if (leak_watch_is_leaking(filtered_conns[i]->pid)) emit(CL_RED "%s", current_lang == LANG_CN ? "持续增长" : "growing");
+        } else if (current_view == VIEW_HITTERS) {
+            int r = heavy_hitters_rank(hitters_mode(), filtered_conns[i], HITTERS_ROWS);
+            if (r >= 0) emit("#%d", r + 1);
+        } else {
+            print_padded(filtered_conns[i]->risk_reason, 10);
+        }
+        emit(CLR_RST "\n");
+        rendered++;
+    }
+
+    if (rendered == 0) emit("\n   (%s)\n", ui_text.no_data);
+    else {
+        // 回放中的 PID 可能已被复用，不提供终止
+        emit("\n" CL_CYN "   [#%d/%d %s | Enter:%s | P:%s%s%s%s%s]\n" CLR_RST, 
+               selected_idx + 1, match_count, 
+               (current_lang == LANG_CN ? "已选中" : "Selected"),
+               (current_lang == LANG_CN ? "详情" : "Detail"),
+               (current_lang == LANG_CN ? "固定" : "Pin"),
+               f->live_ms > 0 ? "" : " | K:",
+               f->live_ms > 0 ? "" : (current_lang == LANG_CN ? "终止" : "Kill"),
+               conn_collapse_enabled() ? " | E:" : "",
+               conn_collapse_enabled() ? (current_lang == LANG_CN ? "展开/收起分组" : "Expand group") : "");
+    }
+
+    if (kill_confirm && match_count > 0 && selected_idx < match_count) {
+        emit(BG_RED " CONFIRM KILL PID %d (%s)? [y/N]: " CLR_RST, 
+               filtered_conns[selected_idx]->pid, filtered_conns[selected_idx]->process);
+    }
+    // 渲染完成后清除屏幕剩余部分，确保长列表切短列表时没有残影
+    emit("\033[J");
+    tui_flush();
+    uint64_t frame_ns = phase_now_ns() - frame_start;
+    phase_record(PHASE_FILTER, filter_ns);
+    phase_record(PHASE_RENDER, frame_ns - filter_ns);
+    phase_record(PHASE_FRAME, frame_ns);
+}
+
+void tui_free(void) {
+    strbuf_free(&out);
+    arena_free(&frame_arena);
+    filtered_conns = NULL;
+    match_count = 0;
+}
@@ -0,0 +1,75 @@
+#ifndef TUI_H
+#define TUI_H
+
+#include <stddef.h>
+#include "backend/scanner.h"
+
+// 终端界面帧构建：一帧先完整写入内部缓冲，再整体交给输出端
+// 输出端为标准输出时一次 fwrite；为内存时保留缓冲供调用方读取（无头渲染基准）
+
+// 颜色定义
+#define CLR_RST  "\033[0m"
+#define CL_BLD   "\033[1m"
+#define CL_GRN   "\033[32m"
+#define CL_YLW   "\033[33m"
+#define CL_CYN   "\033[36m"
+#define CL_MAG   "\033[35m"
+#define CL_RED   "\033[31m"
+#define BG_RED   "\033[41;37m"
+
+// 语言与视图状态
+typedef enum { LANG_CN, LANG_EN } LangType;
+typedef enum { VIEW_OVERVIEW = 1, VIEW_ALL, VIEW_ESTABLISHED, VIEW_LISTEN, VIEW_SUSPICIOUS, VIEW_TALKERS, VIEW_HEALTH, VIEW_PRESSURE, VIEW_PORTS, VIEW_LEAKS, VIEW_HITTERS } ViewType;
+#define VIEW_MAX VIEW_HITTERS        // 数字键 1..9 直接切换视图，0 对应第 10 个，H 对应第 11 个
+#define REPLAY_JUMP_SCANS 30         // 回放时 { } 一次跳过的轮数（[ ] 为一轮）
+
+// 全局界面状态（由 main.c 的按键处理修改）
+extern LangType current_lang;
+extern ViewType current_view;
+extern int scroll_offset;
+extern char search_filter[64];
+extern int is_searching;
+extern SortMode current_sort;
+extern int selected_idx;
+extern int show_detail;
+extern int kill_confirm;
+extern int health_by_rtt;
+extern int hitters_by_prefix;
+extern int trend_series;
+extern int trend_res;
+extern int show_profiler;
+
+typedef enum {
+    TUI_SINK_STDOUT,     // 默认：每帧一次写出并刷新
+    TUI_SINK_MEMORY      // 帧保留在内存中，不写终端
+} TuiSink;
+
+// 一帧的输入：连接快照（排序时会被原地重排）与其统计
+typedef struct {
+    ConnectionInfo *conns;
+    int count;
+    const ConnectionStats *stats;
+    long long now_ms;
+    const char *driver_name;
+    int tcp_info;            // 是否采集了 tcp_info（决定吞吐/健康度面板是否有数据）
+    long long live_ms;       // 回放历史时为当前时刻（now_ms 为该轮的扫描时刻），实时为 0
+    int replay_back;         // 回放的轮次距最新一轮的轮数
+} TuiFrame;
+
+void tui_set_sink(TuiSink sink);
+
+// 最近一帧的内容与字节数（内存输出端下有效，标准输出端下只有字节数）
+const char *tui_frame_data(size_t *len);
+
+// 构建一帧并写出，阶段耗时计入 PHASE_FILTER / PHASE_RENDER / PHASE_FRAME
+void tui_render_frame(const TuiFrame *frame);
+
+// 最近一帧当前视图过滤后的行（指向 frame->conns，下一帧前有效）
+ConnectionInfo **tui_rows(int *count);
+
+// 全屏详情浮窗，直接写出
+void show_detail_overlay(ConnectionInfo *conn);
+
+void tui_free(void);
+
+#endif // TUI_H